@@ -0,0 +1,192 @@
+#!/usr/bin/env python3
+"""
+Fit thruster compensation tables from bollard-pull data
+Reads a CSV of command vs. measured force and prints the shell commands
+that load the tables into the firmware (rov comp set ... / rov comp save)
+
+CSV columns (header required):
+    command   - normalized command (-1..1), or pulse width in us with --pwm
+    force     - measured thrust, any unit (negative for reverse)
+    thruster  - optional thruster index; without it one table pair is
+                fitted and loaded on all thrusters
+
+Usage:
+    python3 fit_thruster_comp.py bollard.csv > comp.txt
+    python3 fit_thruster_comp.py --pwm --normalize forward bollard.csv
+"""
+
+import argparse
+import csv
+import math
+import sys
+from collections import defaultdict
+
+# Must match COMP_TABLE_POINTS in src/compensation.h
+TABLE_POINTS = 17
+
+# Must match the PWM backend (src/actuator_pwm.c)
+PWM_NEUTRAL_US = 1500
+PWM_RANGE_US = 400
+
+
+def isotonic(values):
+    """Pool-adjacent-violators: closest non-decreasing sequence (least squares)"""
+    blocks = []  # [mean, weight, count]
+    for v in values:
+        blocks.append([v, 1.0, 1])
+        while len(blocks) > 1 and blocks[-2][0] > blocks[-1][0]:
+            m2, w2, n2 = blocks.pop()
+            m1, w1, n1 = blocks.pop()
+            blocks.append([(m1 * w1 + m2 * w2) / (w1 + w2), w1 + w2, n1 + n2])
+    out = []
+    for mean, _, count in blocks:
+        out.extend([mean] * count)
+    return out
+
+
+def monotone_curve(samples):
+    """Average repeated commands and make force non-decreasing in command"""
+    by_command = defaultdict(list)
+    for command, force in samples:
+        by_command[command].append(force)
+    commands = sorted(by_command)
+    forces = [sum(by_command[c]) / len(by_command[c]) for c in commands]
+    if not commands or commands[0] > 0.0:
+        commands.insert(0, 0.0)
+        forces.insert(0, 0.0)
+    return commands, isotonic(forces)
+
+
+def force_at(commands, forces, command):
+    """Linear interpolation of the fitted force at a command"""
+    if command <= commands[0]:
+        return forces[0]
+    for i in range(1, len(commands)):
+        if command <= commands[i]:
+            span = commands[i] - commands[i - 1]
+            frac = (command - commands[i - 1]) / span if span > 0 else 1.0
+            return forces[i - 1] + frac * (forces[i] - forces[i - 1])
+    return forces[-1]
+
+
+def command_for(commands, forces, force):
+    """Smallest command that reaches a force on the monotone curve"""
+    if force <= forces[0]:
+        return commands[0]
+    for i in range(1, len(commands)):
+        if forces[i] >= force:
+            rise = forces[i] - forces[i - 1]
+            frac = (force - forces[i - 1]) / rise if rise > 0 else 0.0
+            return commands[i - 1] + frac * (commands[i] - commands[i - 1])
+    return 1.0
+
+
+def deadband_edge(commands, forces, full_force):
+    """
+    Command where thrust starts. Force is roughly quadratic past the deadband,
+    so sqrt(force) is close to linear in command: fit a line over 5..50% of
+    full force and take its zero crossing. None if there are too few points.
+    """
+    points = [(c, math.sqrt(f)) for c, f in zip(commands, forces)
+              if 0.05 * full_force <= f <= 0.5 * full_force]
+    if len(points) < 3:
+        return None
+    n = len(points)
+    mean_c = sum(c for c, _ in points) / n
+    mean_r = sum(r for _, r in points) / n
+    var = sum((c - mean_c) ** 2 for c, _ in points)
+    if var <= 0.0:
+        return None
+    slope = sum((c - mean_c) * (r - mean_r) for c, r in points) / var
+    if slope <= 0.0:
+        return None
+    return mean_c - mean_r / slope
+
+
+def fit_direction(samples, full_force, deadband_frac):
+    """Table of command magnitudes for forces 0, 1/16, ... 1 of full_force"""
+    commands, forces = monotone_curve(samples)
+    deadband = None if deadband_frac is not None else deadband_edge(commands, forces, full_force)
+    if deadband is None:
+        frac = deadband_frac if deadband_frac is not None else 0.02
+        deadband = command_for(commands, forces, frac * full_force)
+
+    table = [0.0]
+    for k in range(1, TABLE_POINTS):
+        table.append(command_for(commands, forces, full_force * k / (TABLE_POINTS - 1)))
+    table[0] = min(max(deadband, 0.0), table[1])
+    deadband = table[0]
+
+    # Clamp and keep the table non-decreasing, as the firmware requires
+    table = [min(max(c, 0.0), 1.0) for c in table]
+    for i in range(1, len(table)):
+        table[i] = max(table[i], table[i - 1])
+
+    # Linearity after compensation: force reached at each table entry vs. the target
+    errors = [force_at(commands, forces, table[k]) - full_force * k / (TABLE_POINTS - 1)
+              for k in range(1, TABLE_POINTS)]
+    rms = math.sqrt(sum(e * e for e in errors) / len(errors)) / full_force
+    return table, deadband, forces[-1], rms
+
+
+def load_csv(path, pwm):
+    data = defaultdict(list)
+    with open(path, newline='') as f:
+        for row in csv.DictReader(f):
+            command = float(row['command'])
+            if pwm:
+                command = (command - PWM_NEUTRAL_US) / PWM_RANGE_US
+            command = min(max(command, -1.0), 1.0)
+            thruster = row.get('thruster', '').strip() or 'all'
+            data[thruster].append((command, float(row['force'])))
+    return data
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Fit thruster compensation tables")
+    parser.add_argument('csv', help="Bollard-pull CSV (command, force[, thruster])")
+    parser.add_argument('--pwm', action='store_true',
+                        help="Commands are pulse widths in us (1500 +/- 400)")
+    parser.add_argument('--normalize', choices=['min', 'forward', 'each'], default='min',
+                        help="Force for a normalized command of 1.0: the weaker direction "
+                             "(symmetric, default), the forward maximum, or each direction's own")
+    parser.add_argument('--deadband', type=float, default=None,
+                        help="Force fraction that counts as leaving the deadband "
+                             "(default: extrapolate a quadratic force curve to zero)")
+    parser.add_argument('--no-save', action='store_true', help="Do not append 'rov comp save'")
+    args = parser.parse_args()
+
+    data = load_csv(args.csv, args.pwm)
+    if not data:
+        sys.exit("No samples in " + args.csv)
+
+    for thruster in sorted(data):
+        samples = data[thruster]
+        forward = [(c, f) for c, f in samples if c >= 0.0 and f >= 0.0]
+        reverse = [(-c, -f) for c, f in samples if c <= 0.0 and f <= 0.0]
+        if len(forward) < 3 or len(reverse) < 3:
+            sys.exit(f"Thruster {thruster}: need at least 3 forward and 3 reverse samples")
+
+        max_fwd = max(f for _, f in forward)
+        max_rev = max(f for _, f in reverse)
+        if args.normalize == 'min':
+            full = {'fwd': min(max_fwd, max_rev), 'rev': min(max_fwd, max_rev)}
+        elif args.normalize == 'forward':
+            full = {'fwd': max_fwd, 'rev': max_fwd}
+        else:
+            full = {'fwd': max_fwd, 'rev': max_rev}
+
+        for name, direction in (('fwd', forward), ('rev', reverse)):
+            table, deadband, peak, rms = fit_direction(direction, full[name], args.deadband)
+            print(f"# thruster {thruster} {name}: deadband {deadband:.3f}, "
+                  f"max force {peak:.2f}, residual {rms * 100:.1f}% of full scale",
+                  file=sys.stderr)
+            values = ' '.join(f"{c:.4f}" for c in table)
+            print(f"rov comp set {thruster} {name} {values}")
+
+    if not args.no_save:
+        print("rov comp save")
+
+
+if __name__ == '__main__':
+    main()
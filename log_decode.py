@@ -0,0 +1,214 @@
+#!/usr/bin/env python3
+"""
+Per-command log decoder for the K2 console (src/cmdlog.c)
+Reads the console from a serial port or a capture file, picks out the
+compact per-command records ("cmd #seq @timestamp_us surge sway heave roll
+pitch yaw Llight Mmanipulator") and reports the record rate, the console
+bytes spent per record, records lost in the logging pipeline (sequence
+gaps beyond the decimation set with `rov log every`) and the drops Zephyr
+reported itself ("--- N messages dropped ---").
+
+Text output (default build) is parsed directly. Dictionary output
+(-DEXTRA_CONF_FILE=log_dict.conf) is binary, or hex-encoded binary with
+--hex: pass --dict with the build's log_dictionary.json and the records are
+decoded with Zephyr's dictionary parser (scripts/logging/dictionary, found
+through ZEPHYR_BASE).
+
+Usage:
+    python3 log_decode.py --port /dev/ttyACM0
+    python3 log_decode.py --port /dev/ttyACM0 --dict build/zephyr/log_dictionary.json
+    python3 log_decode.py --file capture.log --csv commands.csv
+"""
+
+import argparse
+import contextlib
+import io
+import logging
+import os
+import re
+import sys
+import time
+
+RECORD = re.compile(r'cmd #(\d+) @(\d+) (-?\d+) (-?\d+) (-?\d+) (-?\d+) (-?\d+) (-?\d+) L(\d+) M(\d+)')
+DROPPED = re.compile(r'--- (\d+) messages dropped ---')
+HEX_RUN = re.compile(rb'[0-9a-fA-F]+')
+MIN_HEX_RUN = 8          # Shorter runs are shell text, not log data
+FIELDS = ('sequence', 'timestamp_us', 'surge', 'sway', 'heave', 'roll', 'pitch', 'yaw',
+          'light', 'manipulator')
+
+
+class DictionaryDecoder:
+    """Dictionary log stream -> text lines, through Zephyr's parser"""
+
+    def __init__(self, database, zephyr_base, hex_output):
+        if not zephyr_base:
+            raise SystemExit("--dict needs ZEPHYR_BASE (or --zephyr-base)")
+        sys.path.insert(0, os.path.join(zephyr_base, 'scripts', 'logging', 'dictionary'))
+        import dictionary_parser
+        from dictionary_parser.log_database import LogDatabase
+
+        db = LogDatabase.read_json_database(database)
+        if db is None:
+            raise SystemExit(f"Cannot read dictionary database {database}")
+        self.parser = dictionary_parser.get_parser(db)
+        self.hex_output = hex_output
+        self.pending = b''
+
+    def feed(self, chunk):
+        logdata = self.unhex(chunk) if self.hex_output else chunk
+        if not logdata:
+            return []
+
+        # The parser prints (or logs, depending on the Zephyr version)
+        output = io.StringIO()
+        handler = logging.StreamHandler(output)
+        root = logging.getLogger()
+        root.addHandler(handler)
+        root.setLevel(logging.INFO)
+        try:
+            with contextlib.redirect_stdout(output):
+                self.parser.parse_log_data(logdata)
+        finally:
+            root.removeHandler(handler)
+        return output.getvalue().splitlines()
+
+    def unhex(self, chunk):
+        # Keep the log data, drop the shell text around it; a run touching
+        # the end of the chunk may continue in the next one
+        data = self.pending + chunk
+        self.pending = b''
+        runs = [m for m in HEX_RUN.finditer(data)]
+        if runs and runs[-1].end() == len(data):
+            self.pending = runs.pop().group()
+        hexdata = b''.join(m.group() for m in runs if len(m.group()) >= MIN_HEX_RUN)
+        if len(hexdata) % 2:
+            hexdata = hexdata[:-1]
+        return bytes.fromhex(hexdata.decode())
+
+
+class Stats:
+    def __init__(self, carry=None):
+        self.records = 0
+        self.lost = 0
+        self.dropped = 0
+        self.console_bytes = 0
+        self.last_seq = carry.last_seq if carry else None
+        self.deltas = dict(carry.deltas) if carry else {}
+
+    def decimation(self):
+        """Most common sequence step, i.e. the `rov log every` setting"""
+        return max(self.deltas, key=self.deltas.get) if self.deltas else 1
+
+    def add(self, sequence):
+        self.records += 1
+        if self.last_seq is not None and sequence > self.last_seq:
+            delta = sequence - self.last_seq
+            self.deltas[delta] = self.deltas.get(delta, 0) + 1
+            step = self.decimation()
+            if delta > step:
+                self.lost += delta // step - 1
+        self.last_seq = sequence
+
+
+def report(label, stats, elapsed):
+    per_record = f"{stats.console_bytes / stats.records:6.1f}" if stats.records else "     -"
+    print(f"{label}: {stats.records / elapsed:7.1f} records/s  "
+          f"{stats.console_bytes / elapsed / 1000:6.2f} kB/s console  "
+          f"{per_record} B/record  every {stats.decimation()}  "
+          f"lost {stats.lost}  dropped by the device {stats.dropped}")
+
+
+def open_input(args):
+    if args.file:
+        return open(args.file, 'rb'), False
+    try:
+        import serial
+    except ImportError:
+        raise SystemExit("Reading a serial port needs pyserial (pip install pyserial)")
+    return serial.Serial(args.port, args.baud, timeout=0.1), True
+
+
+def main():
+    parser = argparse.ArgumentParser(description="K2 per-command log decoder")
+    source = parser.add_mutually_exclusive_group(required=True)
+    source.add_argument('--port', help="Serial port of the console")
+    source.add_argument('--file', help="Console capture to decode")
+    parser.add_argument('--baud', type=int, default=115200)
+    parser.add_argument('--dict', help="log_dictionary.json of the build (dictionary output)")
+    parser.add_argument('--hex', action='store_true',
+                        help="Dictionary output is hex-encoded (LOG_BACKEND_UART_OUTPUT_DICTIONARY_HEX)")
+    parser.add_argument('--zephyr-base', default=os.environ.get('ZEPHYR_BASE'),
+                        help="Zephyr tree with the dictionary parser (default $ZEPHYR_BASE)")
+    parser.add_argument('--csv', help="Write every record to this file")
+    parser.add_argument('--print', action='store_true', help="Print every decoded line")
+    parser.add_argument('--interval', type=float, default=5.0, help="Seconds between summaries")
+    parser.add_argument('--duration', type=float, help="Stop after this many seconds")
+    args = parser.parse_args()
+
+    decoder = DictionaryDecoder(args.dict, args.zephyr_base, args.hex) if args.dict else None
+    stream, live = open_input(args)
+    csv = open(args.csv, 'w') if args.csv else None
+    if csv:
+        csv.write(','.join(FIELDS) + '\n')
+
+    total = Stats()
+    window = Stats()
+    text_tail = b''
+    first = last = None      # Record timestamps, for capture files
+    start = window_start = time.monotonic()
+    try:
+        while args.duration is None or time.monotonic() - start < args.duration:
+            chunk = stream.read(4096)
+            if not chunk and not live:
+                break
+            total.console_bytes += len(chunk)
+            window.console_bytes += len(chunk)
+
+            if decoder:
+                lines = decoder.feed(chunk) if chunk else []
+            else:
+                text_tail += chunk
+                *complete, text_tail = text_tail.split(b'\n')
+                lines = [line.decode(errors='replace') for line in complete]
+
+            for line in lines:
+                if args.print:
+                    print(line.rstrip())
+                dropped = DROPPED.search(line)
+                if dropped:
+                    total.dropped += int(dropped.group(1))
+                    window.dropped += int(dropped.group(1))
+                    continue
+                record = RECORD.search(line)
+                if not record:
+                    continue
+                values = [int(v) for v in record.groups()]
+                total.add(values[0])
+                window.add(values[0])
+                first = values[1] if first is None else first
+                last = values[1]
+                if csv:
+                    csv.write(','.join(str(v) for v in values) + '\n')
+
+            now = time.monotonic()
+            if live and now - window_start >= args.interval:
+                report("last", window, now - window_start)
+                window = Stats(carry=window)
+                window_start = now
+    except KeyboardInterrupt:
+        pass
+    finally:
+        stream.close()
+        if csv:
+            csv.close()
+
+    if live:
+        elapsed = time.monotonic() - start
+    else:
+        # Capture files: the device timestamps give the time base
+        elapsed = ((last - first) & 0xFFFFFFFF) / 1e6 if first is not None else 0.0
+    report("total", total, max(elapsed, 1e-6))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,363 @@
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/shell/shell.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "actuator.h"
+#include "cycles.h"
+#include "hotpath.h"
+#include "latency.h"
+#include "trace.h"
+
+LOG_MODULE_DECLARE(k2_app);
+
+// Backend selected at build time: CAN ESCs if enabled, otherwise the fake
+// recorder on native_sim and timer PWM on hardware
+#if defined(CONFIG_K2_ACTUATOR_CAN)
+extern const actuator_backend_t actuator_can_backend;
+static const actuator_backend_t *const backend = &actuator_can_backend;
+#elif defined(CONFIG_ARCH_POSIX)
+extern const actuator_backend_t actuator_fake_backend;
+static const actuator_backend_t *const backend = &actuator_fake_backend;
+#else
+extern const actuator_backend_t actuator_pwm_backend;
+static const actuator_backend_t *const backend = &actuator_pwm_backend;
+#endif
+
+// Copy of the last committed frame for inspection and telemetry
+static actuator_frame_t last_frame;
+static struct k_spinlock last_lock;
+
+/*
+ * Published frames. The control thread writes a buffer that is neither the
+ * front nor pinned and then flips the front index; the commit (timer ISR, or
+ * the commit thread) pins the front buffer for as long as it reads it. A
+ * commit that blocks in the backend can span several publishes, so a third
+ * buffer keeps the control thread off the pinned one without waiting.
+ */
+#define ACTUATOR_FRAME_BUFFERS 3
+
+static actuator_frame_t ROV_HOT_BSS frames[ACTUATOR_FRAME_BUFFERS];
+static uint32_t ROV_HOT_BSS publish_cycles[ACTUATOR_FRAME_BUFFERS];
+static atomic_t front_index = ATOMIC_INIT(0);
+static atomic_t pinned_index = ATOMIC_INIT(-1);   // Buffer being committed, -1 if none
+static atomic_t frame_fresh = ATOMIC_INIT(0);
+
+static actuator_timing_t timing;
+static uint32_t last_commit_cycles;
+static struct k_spinlock timing_lock;
+
+static void actuator_commit_timer_handler(struct k_timer *timer);
+K_TIMER_DEFINE(actuator_commit_timer, actuator_commit_timer_handler, NULL);
+
+// Commit thread for backends that cannot commit from the timer ISR. The
+// sensor, network and control threads are preemptible, so it runs as soon
+// as the timer wakes it rather than when the running thread yields.
+#define ACTUATOR_COMMIT_STACK_SIZE 1024
+#define ACTUATOR_COMMIT_PRIORITY   K_PRIO_COOP(2)
+
+K_THREAD_STACK_DEFINE(actuator_commit_stack, ACTUATOR_COMMIT_STACK_SIZE);
+static struct k_thread actuator_commit_thread_data;
+static K_SEM_DEFINE(actuator_commit_sem, 0, 1);
+
+/**
+ * Initialize the actuator output backend (all outputs neutral)
+ * @return: 0 on success, negative error code from the backend
+ */
+int actuator_init(void)
+{
+    actuator_frame_t neutral = { 0 };
+    int ret = backend->init();
+
+    if (ret < 0) {
+        LOG_ERR("Actuator backend '%s' init failed: %d", backend->name, ret);
+        return ret;
+    }
+
+    actuator_commit(&neutral);
+    LOG_INF("Actuator outputs ready: %d thrusters, light, manipulator (%s backend)",
+            ROV_THRUSTER_COUNT, backend->name);
+    return 0;
+}
+
+static void actuator_commit_front(void);
+
+static void actuator_commit_thread(void *arg1, void *arg2, void *arg3)
+{
+    ARG_UNUSED(arg1); ARG_UNUSED(arg2); ARG_UNUSED(arg3);
+
+    while (1) {
+        k_sem_take(&actuator_commit_sem, K_FOREVER);
+        actuator_commit_front();
+    }
+}
+
+/**
+ * Start committing published frames. Call right after the control timer
+ * is started so the commit lands at ACTUATOR_COMMIT_PHASE_US into each tick.
+ */
+void actuator_start(void)
+{
+    actuator_reset_timing();
+    if (!backend->isr_safe) {
+        k_thread_create(&actuator_commit_thread_data, actuator_commit_stack,
+                        K_THREAD_STACK_SIZEOF(actuator_commit_stack), actuator_commit_thread,
+                        NULL, NULL, NULL, ACTUATOR_COMMIT_PRIORITY, 0, K_NO_WAIT);
+        k_thread_name_set(&actuator_commit_thread_data, "actuator");
+    }
+    k_timer_start(&actuator_commit_timer,
+                  K_USEC(ROV_CONTROL_PERIOD_US + ACTUATOR_COMMIT_PHASE_US),
+                  K_USEC(ROV_CONTROL_PERIOD_US));
+    LOG_INF("Actuator commit at %u us into each %u us tick (%s)",
+            ACTUATOR_COMMIT_PHASE_US, ROV_CONTROL_PERIOD_US,
+            backend->isr_safe ? "timer ISR" : "commit thread");
+}
+
+/**
+ * Publish the outputs of one control tick; committed at the next commit phase
+ * @param frame: Outputs for this control tick
+ */
+ROV_HOT_CODE void actuator_publish(const actuator_frame_t *frame)
+{
+    // A commit only ever pins the current front, which is never picked here
+    atomic_val_t front = atomic_get(&front_index);
+    atomic_val_t pinned = atomic_get(&pinned_index);
+    int back = 0;
+
+    while (back == front || back == pinned) {
+        back++;
+    }
+
+    frames[back] = *frame;
+    publish_cycles[back] = rov_cycles_now();
+    atomic_set(&front_index, back);
+    atomic_set(&frame_fresh, 1);
+}
+
+/**
+ * Write the front buffer to the backend and time it (timer ISR or commit thread)
+ */
+static void actuator_commit_front(void)
+{
+    uint32_t now = rov_cycles_now();
+    int front = atomic_get(&front_index);
+
+    atomic_set(&pinned_index, front);
+    bool fresh = atomic_clear(&frame_fresh) != 0;
+
+    actuator_commit(&frames[front]);
+
+    // End of the command lifecycle: first commit of a frame, one sample for
+    // every command its tick consumed (not only the newest)
+    const actuator_frame_t *frame = &frames[front];
+
+    if (fresh && frame->command_count > 0) {
+        uint32_t committed = rov_cycles_now();
+
+        for (int i = 0; i < frame->command_count; i++) {
+            const actuator_command_stamp_t *stamp = &frame->commands[i];
+
+            latency_record(LATENCY_CONTROL, committed - stamp->dequeue_cycles);
+            latency_record(LATENCY_TOTAL, committed - stamp->rx_cycles);
+            ROV_TRACE_ACTUATED(stamp->sequence);
+        }
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&timing_lock);
+    if (timing.commits > 0) {
+        uint32_t period = now - last_commit_cycles;
+
+        timing.period_min_cycles = MIN(timing.period_min_cycles, period);
+        timing.period_max_cycles = MAX(timing.period_max_cycles, period);
+    }
+    if (fresh) {
+        uint32_t slack = now - publish_cycles[front];
+        uint32_t phase = now - frame->tick_cycles;
+
+        timing.slack_min_cycles = MIN(timing.slack_min_cycles, slack);
+        timing.slack_total_cycles += slack;
+        timing.slack_count++;
+        timing.phase_min_cycles = MIN(timing.phase_min_cycles, phase);
+        timing.phase_max_cycles = MAX(timing.phase_max_cycles, phase);
+        timing.phase_total_cycles += phase;
+    } else {
+        timing.stale++;
+    }
+    timing.commits++;
+    last_commit_cycles = now;
+    k_spin_unlock(&timing_lock, key);
+
+    atomic_set(&pinned_index, -1);
+}
+
+/**
+ * Commit timer (ISR context): commit here if the backend allows it,
+ * otherwise wake the commit thread
+ */
+static void actuator_commit_timer_handler(struct k_timer *timer)
+{
+    ARG_UNUSED(timer);
+
+    if (backend->isr_safe) {
+        actuator_commit_front();
+    } else {
+        k_sem_give(&actuator_commit_sem);
+    }
+}
+
+/**
+ * Get output timing statistics since the last reset
+ * @param out: Output copy
+ */
+void actuator_get_timing(actuator_timing_t *out)
+{
+    k_spinlock_key_t key = k_spin_lock(&timing_lock);
+    *out = timing;
+    k_spin_unlock(&timing_lock, key);
+}
+
+/**
+ * Clear output timing statistics
+ */
+void actuator_reset_timing(void)
+{
+    k_spinlock_key_t key = k_spin_lock(&timing_lock);
+    memset(&timing, 0, sizeof(timing));
+    timing.period_min_cycles = UINT32_MAX;
+    timing.slack_min_cycles = UINT32_MAX;
+    timing.phase_min_cycles = UINT32_MAX;
+    k_spin_unlock(&timing_lock, key);
+}
+
+/**
+ * Commit a complete output frame in one batched backend update
+ * @param frame: Outputs for this control tick
+ */
+void actuator_commit(const actuator_frame_t *frame)
+{
+    backend->commit(frame);
+
+    k_spinlock_key_t key = k_spin_lock(&last_lock);
+    last_frame = *frame;
+    k_spin_unlock(&last_lock, key);
+}
+
+/**
+ * Read back the last committed frame
+ * @param frame: Output copy
+ */
+void actuator_get_last(actuator_frame_t *frame)
+{
+    k_spinlock_key_t key = k_spin_lock(&last_lock);
+    *frame = last_frame;
+    k_spin_unlock(&last_lock, key);
+}
+
+/**
+ * Map an output channel name to a frame slot
+ * @param name: "thr0".."thrN", "light" or "manipulator"
+ * @return: Slot index, or -1 if unknown
+ */
+int actuator_slot_from_name(const char *name)
+{
+    if (strcmp(name, "light") == 0) {
+        return ACTUATOR_SLOT_LIGHT;
+    }
+    if (strcmp(name, "manipulator") == 0) {
+        return ACTUATOR_SLOT_MANIPULATOR;
+    }
+    if (strncmp(name, "thr", 3) == 0) {
+        char *end;
+        long index = strtol(name + 3, &end, 10);
+
+        if (*end == '\0' && end != name + 3 && index >= 0 && index < ROV_THRUSTER_COUNT) {
+            return ACTUATOR_SLOT_THRUSTER0 + (int)index;
+        }
+    }
+    return -1;
+}
+
+/**
+ * Value of one slot in a frame
+ * @param frame: Output frame
+ * @param slot: Slot index (enum actuator_slot)
+ * @return: Normalized value of the slot
+ */
+float actuator_frame_slot(const actuator_frame_t *frame, int slot)
+{
+    if (slot == ACTUATOR_SLOT_LIGHT) {
+        return frame->light;
+    }
+    if (slot == ACTUATOR_SLOT_MANIPULATOR) {
+        return frame->manipulator;
+    }
+    return frame->thrust[slot - ACTUATOR_SLOT_THRUSTER0];
+}
+
+static int cmd_actuator_show(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    actuator_frame_t f;
+    actuator_get_last(&f);
+
+    shell_print(sh, "backend %s, command #%u", backend->name, f.sequence);
+    for (int i = 0; i < ROV_THRUSTER_COUNT; i++) {
+        shell_print(sh, "thr%d  %+.3f", i, (double)f.thrust[i]);
+    }
+    shell_print(sh, "light %.3f  manipulator %.3f", (double)f.light, (double)f.manipulator);
+    return 0;
+}
+
+static int cmd_actuator_timing(const struct shell *sh, size_t argc, char **argv)
+{
+    if (argc > 1 && strcmp(argv[1], "reset") == 0) {
+        actuator_reset_timing();
+        return 0;
+    }
+
+    actuator_timing_t t;
+    actuator_get_timing(&t);
+
+    if (t.commits < 2) {
+        shell_print(sh, "No output commits yet");
+        return 0;
+    }
+
+    uint32_t nominal_ns = ROV_CONTROL_PERIOD_US * 1000U;
+
+    shell_print(sh, "%u commits at %u us phase, %u stale (no new frame)",
+                t.commits, ACTUATOR_COMMIT_PHASE_US, t.stale);
+    shell_print(sh, "period: min %u ns  max %u ns  (nominal %u ns)",
+                rov_cycles_to_ns(t.period_min_cycles), rov_cycles_to_ns(t.period_max_cycles),
+                nominal_ns);
+    if (t.slack_count > 0) {
+        // Phase is measured from the start of the control tick that built the frame
+        uint32_t phase_nominal_ns = ACTUATOR_COMMIT_PHASE_US * 1000U;
+        uint32_t phase_min_ns = rov_cycles_to_ns(t.phase_min_cycles);
+        uint32_t phase_max_ns = rov_cycles_to_ns(t.phase_max_cycles);
+
+        shell_print(sh, "tick-to-commit phase: min %u ns  mean %u ns  max %u ns",
+                    phase_min_ns,
+                    rov_cycles_to_ns((uint32_t)(t.phase_total_cycles / t.slack_count)),
+                    phase_max_ns);
+        shell_print(sh, "phase jitter: %u ns peak-to-peak, %d ns to %d ns from nominal",
+                    phase_max_ns - phase_min_ns, (int32_t)(phase_min_ns - phase_nominal_ns),
+                    (int32_t)(phase_max_ns - phase_nominal_ns));
+        shell_print(sh, "publish-to-commit slack: min %u ns  mean %u ns",
+                    rov_cycles_to_ns(t.slack_min_cycles),
+                    rov_cycles_to_ns((uint32_t)(t.slack_total_cycles / t.slack_count)));
+    }
+    return 0;
+}
+
+SHELL_SUBCMD_SET_CREATE(actuator_cmds, (rov, actuator));
+SHELL_SUBCMD_ADD((rov, actuator), show, NULL, "Show the last committed output frame",
+                 cmd_actuator_show, 1, 0);
+SHELL_SUBCMD_ADD((rov, actuator), timing, NULL,
+                 "[reset] Output commit period, phase jitter and slack",
+                 cmd_actuator_timing, 1, 1);
+SHELL_SUBCMD_ADD((rov), actuator, &actuator_cmds, "Actuator outputs", NULL, 1, 0);
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <zephyr/kernel.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "control.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Output slots, used by backends to map channels onto the frame
+enum actuator_slot {
+    ACTUATOR_SLOT_THRUSTER0 = 0,
+    ACTUATOR_SLOT_LIGHT = ROV_THRUSTER_COUNT,
+    ACTUATOR_SLOT_MANIPULATOR,
+    ACTUATOR_SLOT_COUNT
+};
+
+// Lifecycle stamps of one command (latency.h)
+typedef struct {
+    uint32_t sequence;
+    uint32_t rx_cycles;
+    uint32_t dequeue_cycles;
+} actuator_command_stamp_t;
+
+// One complete set of outputs, committed once per control tick
+typedef struct {
+    float thrust[ROV_THRUSTER_COUNT];  // Normalized thrust (-1.0 to +1.0)
+    float light;                       // Brightness (0.0 to 1.0)
+    float manipulator;                 // Position (0.0 to 1.0)
+    uint32_t sequence;                 // Newest command reflected in this frame
+    uint32_t command_timestamp_us;     // Receive time of that command
+    uint8_t command_count;             // Commands consumed by the tick that built it
+    actuator_command_stamp_t commands[ROV_COMMAND_QUEUE_DEPTH];
+    uint32_t tick_cycles;              // Start of the control tick that built it
+} actuator_frame_t;
+
+/*
+ * Output timing: the control tick publishes a frame into a triple buffer,
+ * and a timer commits the front buffer at a fixed phase after each tick
+ * starts, independent of how long the computation took. Backends that may
+ * not run in an ISR (CAN: the driver takes a mutex) are committed by a
+ * cooperative thread that the timer wakes instead; it preempts the sensor,
+ * network and control threads, which are all preemptible.
+ */
+#define ACTUATOR_COMMIT_PHASE_US (ROV_CONTROL_PERIOD_US * 3 / 4)
+
+typedef struct {
+    uint32_t commits;
+    uint32_t stale;               // Commits with no new frame since the previous one
+    uint32_t period_min_cycles;   // Commit-to-commit interval
+    uint32_t period_max_cycles;
+    uint32_t phase_min_cycles;    // Control tick start to commit (fresh frames only)
+    uint32_t phase_max_cycles;
+    uint64_t phase_total_cycles;
+    uint32_t slack_min_cycles;    // Publish-to-commit margin (fresh frames only)
+    uint64_t slack_total_cycles;
+    uint32_t slack_count;
+} actuator_timing_t;
+
+// Output backend: hardware driver or test double
+typedef struct {
+    const char *name;
+    int (*init)(void);
+    void (*commit)(const actuator_frame_t *frame);  // Whole frame, one batched update
+    bool isr_safe;                                  // commit() may run in the timer ISR
+} actuator_backend_t;
+
+int actuator_init(void);
+void actuator_start(void);                              // Start the commit timer (control thread)
+void actuator_publish(const actuator_frame_t *frame);   // Control tick: fill back buffer and swap
+void actuator_commit(const actuator_frame_t *frame);    // Immediate batched write to the backend
+void actuator_get_last(actuator_frame_t *frame);
+void actuator_get_timing(actuator_timing_t *timing);
+void actuator_reset_timing(void);
+
+// Slot helpers ("thr0".."thrN", "light", "manipulator")
+int actuator_slot_from_name(const char *name);
+float actuator_frame_slot(const actuator_frame_t *frame, int slot);
+
+#if defined(CONFIG_K2_ACTUATOR_CAN)
+// Telemetry reported by a CAN ESC
+typedef struct {
+    int16_t rpm;
+    float current_a;
+    float temperature_c;
+    uint8_t status;          // ESC fault flags, 0 = ok
+    uint32_t updated_ms;     // Uptime of the last reply
+    uint32_t replies;        // Replies received
+} esc_telemetry_t;
+
+int actuator_can_get_telemetry(int esc, esc_telemetry_t *out);
+#endif
+
+#if defined(CONFIG_ARCH_POSIX)
+// Fake backend record, for latency and correctness checks on native_sim
+typedef struct {
+    actuator_frame_t frame;
+    uint32_t commit_us;       // Time of commit (setpoint timebase)
+    uint32_t commit_cycles;   // Cycle counter at commit
+} actuator_record_t;
+
+uint32_t actuator_fake_count(void);
+int actuator_fake_get(uint32_t age, actuator_record_t *record);  // age 0 = newest
+void actuator_fake_reset(void);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
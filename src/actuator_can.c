@@ -0,0 +1,409 @@
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/shell/shell.h>
+#include <zephyr/drivers/can.h>
+#include <zephyr/sys/byteorder.h>
+#include <errno.h>
+#include <string.h>
+
+#include "actuator.h"
+#include "cycles.h"
+
+LOG_MODULE_DECLARE(k2_app);
+
+/*
+ * CAN ESC backend.
+ *
+ * A frame is packed into the minimum number of classic CAN frames:
+ *   0x100  thr0..thr3     4 x int16 LE, -32767..32767 = full reverse..forward
+ *   0x101  thr4..thr7     4 x int16 LE
+ *   0x102  aux            light uint16 LE, manipulator uint16 LE (0..65535)
+ * All three are queued back to back in one burst per tick, which fits the
+ * three bxCAN TX mailboxes without waiting.
+ *
+ * ESCs answer with telemetry on 0x200 + ESC index:
+ *   rpm int16, current uint16 (10 mA), temperature int16 (0.1 C), status uint8
+ * Replies are matched by a hardware RX filter and parsed in the RX callback.
+ *
+ * With CONFIG_K2_ACTUATOR_CAN_LOOPBACK the controller runs in loopback mode
+ * (native_sim uses the loopback CAN driver) and emulated ESCs answer every
+ * setpoint frame, so bus load and tick-to-frame latency can be measured
+ * without hardware.
+ */
+
+#define CAN_ID_SETPOINT_BASE  0x100
+#define CAN_ID_AUX            0x102
+#define CAN_ID_TELEMETRY_BASE 0x200
+#define CAN_ID_TELEMETRY_MASK 0x7F8   // Matches 0x200..0x207
+
+#define THRUSTERS_PER_FRAME   4
+#define SETPOINT_FRAME_COUNT  (ROV_THRUSTER_COUNT / THRUSTERS_PER_FRAME)
+#define BURST_FRAME_COUNT     (SETPOINT_FRAME_COUNT + 1)
+
+BUILD_ASSERT(ROV_THRUSTER_COUNT % THRUSTERS_PER_FRAME == 0,
+             "thrusters must fill whole setpoint frames");
+
+// Classic CAN data frame, 11-bit ID: 47 bits overhead (interframe space included)
+// + 8 bits per data byte, plus at most one stuff bit per 4 of the 34 + 8 * dlc
+// stuffed bits in the worst case
+#define CAN_FRAME_OVERHEAD_BITS 47
+#define CAN_FRAME_STUFFED_BITS  34
+
+#define CAN_NODE DT_CHOSEN(zephyr_canbus)
+
+static const struct device *const can_dev = DEVICE_DT_GET(CAN_NODE);
+
+static esc_telemetry_t telemetry[ROV_THRUSTER_COUNT];
+static struct k_spinlock telemetry_lock;
+
+// TX statistics (burst start to completion of its last frame) and bus traffic
+// since the last reset. Only frames matching our RX filters are seen, so
+// traffic from other nodes is not counted.
+struct can_stats {
+    uint32_t window_start_ms;
+    uint32_t bursts;
+    uint32_t frames;
+    uint32_t dropped;      // No free TX mailbox
+    uint32_t errors;       // Completed with an error
+    uint32_t tx_done;      // Frames sent on the bus
+    uint64_t tx_bits;      // Nominal bits of those
+    uint64_t tx_bits_worst;
+    uint32_t rx_frames;    // ESC telemetry frames received
+    uint64_t rx_bits;
+    uint64_t rx_bits_worst;
+    uint32_t latency_count;
+    uint32_t latency_min_cycles;
+    uint32_t latency_max_cycles;
+    uint64_t latency_total_cycles;
+};
+static struct can_stats tx_stats;
+static struct k_spinlock tx_lock;
+static uint32_t burst_start_cycles;
+
+static int16_t pack_thrust(float value)
+{
+    return (int16_t)(CLAMP(value, -1.0f, 1.0f) * 32767.0f);
+}
+
+static uint16_t pack_unit(float value)
+{
+    return (uint16_t)(CLAMP(value, 0.0f, 1.0f) * 65535.0f);
+}
+
+/**
+ * Bits a classic data frame with an 11-bit ID takes on the bus
+ * @param dlc: Data bytes
+ * @param worst: Include the worst-case stuff bits
+ */
+static uint32_t can_frame_bits(uint8_t dlc, bool worst)
+{
+    uint32_t bits = CAN_FRAME_OVERHEAD_BITS + 8U * dlc;
+
+    if (worst) {
+        bits += (CAN_FRAME_STUFFED_BITS + 8U * dlc - 1U) / 4U;
+    }
+    return bits;
+}
+
+static void can_stats_reset(void)
+{
+    memset(&tx_stats, 0, sizeof(tx_stats));
+    tx_stats.latency_min_cycles = UINT32_MAX;
+    tx_stats.window_start_ms = k_uptime_get_32();
+}
+
+static void can_tx_done(const struct device *dev, int error, void *user_data)
+{
+    ARG_UNUSED(dev);
+
+    uint32_t now = rov_cycles_now();
+    uintptr_t index = (uintptr_t)user_data;
+    bool last = index == BURST_FRAME_COUNT - 1;
+    uint8_t dlc = index < SETPOINT_FRAME_COUNT ? 8 : 4;
+
+    k_spinlock_key_t key = k_spin_lock(&tx_lock);
+    if (error != 0) {
+        tx_stats.errors++;
+        k_spin_unlock(&tx_lock, key);
+        return;
+    }
+    tx_stats.tx_done++;
+    tx_stats.tx_bits += can_frame_bits(dlc, false);
+    tx_stats.tx_bits_worst += can_frame_bits(dlc, true);
+    if (last) {
+        uint32_t latency = now - burst_start_cycles;
+
+        tx_stats.latency_count++;
+        tx_stats.latency_total_cycles += latency;
+        tx_stats.latency_min_cycles = MIN(tx_stats.latency_min_cycles, latency);
+        tx_stats.latency_max_cycles = MAX(tx_stats.latency_max_cycles, latency);
+    }
+    k_spin_unlock(&tx_lock, key);
+}
+
+/**
+ * Parse an ESC telemetry frame (RX filter callback, ISR context)
+ */
+static void can_telemetry_rx(const struct device *dev, struct can_frame *frame, void *user_data)
+{
+    ARG_UNUSED(dev);
+    ARG_UNUSED(user_data);
+
+    uint32_t esc = frame->id - CAN_ID_TELEMETRY_BASE;
+
+    k_spinlock_key_t key = k_spin_lock(&tx_lock);
+    tx_stats.rx_frames++;
+    tx_stats.rx_bits += can_frame_bits(frame->dlc, false);
+    tx_stats.rx_bits_worst += can_frame_bits(frame->dlc, true);
+    k_spin_unlock(&tx_lock, key);
+
+    if (esc >= ROV_THRUSTER_COUNT || frame->dlc < 7) {
+        return;
+    }
+
+    key = k_spin_lock(&telemetry_lock);
+    esc_telemetry_t *t = &telemetry[esc];
+    t->rpm = (int16_t)sys_get_le16(&frame->data[0]);
+    t->current_a = sys_get_le16(&frame->data[2]) * 0.01f;
+    t->temperature_c = (int16_t)sys_get_le16(&frame->data[4]) * 0.1f;
+    t->status = frame->data[6];
+    t->updated_ms = k_uptime_get_32();
+    t->replies++;
+    k_spin_unlock(&telemetry_lock, key);
+}
+
+#if defined(CONFIG_K2_ACTUATOR_CAN_LOOPBACK)
+/*
+ * Emulated ESCs: each looped-back setpoint frame is answered with one
+ * telemetry frame per thruster. Replies are sent from a work item since
+ * the RX callback runs in ISR context.
+ */
+static int16_t emulated_setpoint[ROV_THRUSTER_COUNT];
+static struct k_work emulator_work;
+
+static void can_emulator_rx(const struct device *dev, struct can_frame *frame, void *user_data)
+{
+    ARG_UNUSED(dev);
+    ARG_UNUSED(user_data);
+
+    uint32_t first = (frame->id - CAN_ID_SETPOINT_BASE) * THRUSTERS_PER_FRAME;
+
+    for (uint32_t i = 0; i < THRUSTERS_PER_FRAME; i++) {
+        emulated_setpoint[first + i] = (int16_t)sys_get_le16(&frame->data[2 * i]);
+    }
+    if (first + THRUSTERS_PER_FRAME == ROV_THRUSTER_COUNT) {
+        k_work_submit(&emulator_work);
+    }
+}
+
+static void can_emulator_reply(struct k_work *work)
+{
+    ARG_UNUSED(work);
+
+    for (int esc = 0; esc < ROV_THRUSTER_COUNT; esc++) {
+        float cmd = emulated_setpoint[esc] / 32767.0f;
+        float mag = cmd < 0.0f ? -cmd : cmd;
+        struct can_frame reply = {
+            .id = CAN_ID_TELEMETRY_BASE + esc,
+            .dlc = 7,
+        };
+
+        // Rough model: 3000 rpm and 12 A at full throttle
+        sys_put_le16((uint16_t)(int16_t)(cmd * 3000.0f), &reply.data[0]);
+        sys_put_le16((uint16_t)(mag * mag * 1200.0f), &reply.data[2]);
+        sys_put_le16((uint16_t)(250 + (int)(mag * 100.0f)), &reply.data[4]);
+        reply.data[6] = 0;
+        (void)can_send(can_dev, &reply, K_MSEC(1), NULL, NULL);
+    }
+}
+
+static int can_emulator_init(void)
+{
+    const struct can_filter filter = {
+        .id = CAN_ID_SETPOINT_BASE,
+        .mask = 0x7FE,   // Matches the two setpoint frames only
+        .flags = 0,
+    };
+
+    k_work_init(&emulator_work, can_emulator_reply);
+    int ret = can_add_rx_filter(can_dev, can_emulator_rx, NULL, &filter);
+    return ret < 0 ? ret : 0;
+}
+#endif
+
+static int can_backend_init(void)
+{
+    const struct can_filter filter = {
+        .id = CAN_ID_TELEMETRY_BASE,
+        .mask = CAN_ID_TELEMETRY_MASK,
+        .flags = 0,
+    };
+    int ret;
+
+    if (!device_is_ready(can_dev)) {
+        LOG_ERR("CAN device %s not ready", can_dev->name);
+        return -ENODEV;
+    }
+
+    can_stats_reset();
+
+#if defined(CONFIG_K2_ACTUATOR_CAN_LOOPBACK)
+    ret = can_set_mode(can_dev, CAN_MODE_LOOPBACK);
+    if (ret < 0) {
+        LOG_ERR("Failed to set CAN loopback mode: %d", ret);
+        return ret;
+    }
+    ret = can_emulator_init();
+    if (ret < 0) {
+        LOG_ERR("Failed to add ESC emulator filter: %d", ret);
+        return ret;
+    }
+#endif
+
+    ret = can_set_bitrate(can_dev, CONFIG_K2_ACTUATOR_CAN_BITRATE);
+    if (ret < 0) {
+        LOG_ERR("Failed to set CAN bitrate %d: %d", CONFIG_K2_ACTUATOR_CAN_BITRATE, ret);
+        return ret;
+    }
+
+    ret = can_add_rx_filter(can_dev, can_telemetry_rx, NULL, &filter);
+    if (ret < 0) {
+        LOG_ERR("Failed to add ESC telemetry filter: %d", ret);
+        return ret;
+    }
+
+    ret = can_start(can_dev);
+    if (ret < 0) {
+        LOG_ERR("Failed to start CAN: %d", ret);
+        return ret;
+    }
+
+    LOG_INF("CAN actuator backend on %s: %d frames per tick at %d bit/s",
+            can_dev->name, BURST_FRAME_COUNT, CONFIG_K2_ACTUATOR_CAN_BITRATE);
+    return 0;
+}
+
+static void can_backend_commit(const actuator_frame_t *frame)
+{
+    struct can_frame burst[BURST_FRAME_COUNT] = { 0 };
+    uint32_t sent = 0;
+
+    // Pack first, then queue all frames back to back
+    for (int f = 0; f < SETPOINT_FRAME_COUNT; f++) {
+        burst[f].id = CAN_ID_SETPOINT_BASE + f;
+        burst[f].dlc = 8;
+        for (int i = 0; i < THRUSTERS_PER_FRAME; i++) {
+            int16_t value = pack_thrust(frame->thrust[f * THRUSTERS_PER_FRAME + i]);
+
+            sys_put_le16((uint16_t)value, &burst[f].data[2 * i]);
+        }
+    }
+    burst[SETPOINT_FRAME_COUNT].id = CAN_ID_AUX;
+    burst[SETPOINT_FRAME_COUNT].dlc = 4;
+    sys_put_le16(pack_unit(frame->light), &burst[SETPOINT_FRAME_COUNT].data[0]);
+    sys_put_le16(pack_unit(frame->manipulator), &burst[SETPOINT_FRAME_COUNT].data[2]);
+
+    burst_start_cycles = rov_cycles_now();
+
+    for (uintptr_t f = 0; f < BURST_FRAME_COUNT; f++) {
+        if (can_send(can_dev, &burst[f], K_NO_WAIT, can_tx_done, (void *)f) == 0) {
+            sent++;
+        }
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&tx_lock);
+    tx_stats.bursts++;
+    tx_stats.frames += sent;
+    tx_stats.dropped += BURST_FRAME_COUNT - sent;
+    k_spin_unlock(&tx_lock, key);
+}
+
+const actuator_backend_t actuator_can_backend = {
+    .name = "can",
+    .init = can_backend_init,
+    .commit = can_backend_commit,
+    .isr_safe = false,      // can_send() takes the driver's mutex
+};
+
+/**
+ * Latest telemetry reported by one ESC
+ * @param esc: ESC (thruster) index
+ * @param out: Output copy
+ * @return: 0 on success, -EINVAL for a bad index
+ */
+int actuator_can_get_telemetry(int esc, esc_telemetry_t *out)
+{
+    if (esc < 0 || esc >= ROV_THRUSTER_COUNT) {
+        return -EINVAL;
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&telemetry_lock);
+    *out = telemetry[esc];
+    k_spin_unlock(&telemetry_lock, key);
+    return 0;
+}
+
+static int cmd_can_stats(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    k_spinlock_key_t key = k_spin_lock(&tx_lock);
+    struct can_stats st = tx_stats;
+    k_spin_unlock(&tx_lock, key);
+
+    uint32_t window_ms = k_uptime_get_32() - st.window_start_ms;
+
+    shell_print(sh, "%u bursts, %u frames queued, %u dropped, %u errors",
+                st.bursts, st.frames, st.dropped, st.errors);
+    if (window_ms > 0) {
+        // Measured traffic: frames completed on the bus and ESC replies received
+        double bus_bits = (double)CONFIG_K2_ACTUATOR_CAN_BITRATE * window_ms / 1000.0;
+
+        shell_print(sh, "bus load over %u ms: %.1f%% nominal, %.1f%% worst-case stuffing",
+                    window_ms, 100.0 * (double)(st.tx_bits + st.rx_bits) / bus_bits,
+                    100.0 * (double)(st.tx_bits_worst + st.rx_bits_worst) / bus_bits);
+        shell_print(sh, "  tx %u frames %.1f%%, rx %u ESC frames %.1f%% (nominal)",
+                    st.tx_done, 100.0 * (double)st.tx_bits / bus_bits,
+                    st.rx_frames, 100.0 * (double)st.rx_bits / bus_bits);
+    }
+    if (st.latency_count > 0) {
+        shell_print(sh, "tick to last frame on bus: min %u ns  mean %u ns  max %u ns",
+                    rov_cycles_to_ns(st.latency_min_cycles),
+                    rov_cycles_to_ns((uint32_t)(st.latency_total_cycles / st.latency_count)),
+                    rov_cycles_to_ns(st.latency_max_cycles));
+    }
+
+    for (int esc = 0; esc < ROV_THRUSTER_COUNT; esc++) {
+        esc_telemetry_t t;
+
+        actuator_can_get_telemetry(esc, &t);
+        if (t.replies == 0) {
+            shell_print(sh, "esc%d  no telemetry", esc);
+            continue;
+        }
+        shell_print(sh, "esc%d  %+6d rpm  %5.2f A  %5.1f C  status 0x%02x  (%u ms ago)",
+                    esc, t.rpm, (double)t.current_a, (double)t.temperature_c, t.status,
+                    k_uptime_get_32() - t.updated_ms);
+    }
+    return 0;
+}
+
+static int cmd_can_reset(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    k_spinlock_key_t key = k_spin_lock(&tx_lock);
+    can_stats_reset();
+    k_spin_unlock(&tx_lock, key);
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(can_cmds,
+    SHELL_CMD(stats, NULL, "TX statistics, measured bus load and ESC telemetry", cmd_can_stats),
+    SHELL_CMD(reset, NULL, "Clear TX statistics and restart the bus load window", cmd_can_reset),
+    SHELL_SUBCMD_SET_END
+);
+
+SHELL_SUBCMD_ADD((rov, actuator), can, &can_cmds, "CAN ESC backend", NULL, 1, 0);
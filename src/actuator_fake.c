@@ -0,0 +1,173 @@
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/shell/shell.h>
+#include <errno.h>
+#include <stdlib.h>
+
+#include "actuator.h"
+#include "setpoint.h"
+#include "cycles.h"
+
+LOG_MODULE_DECLARE(k2_app);
+
+/*
+ * Fake actuator backend for native_sim. Instead of driving hardware it
+ * records every committed frame with its commit time, so latency and
+ * output correctness can be checked from the host.
+ */
+
+#define FAKE_RECORD_COUNT 256   // Power of two
+
+static actuator_record_t records[FAKE_RECORD_COUNT];
+static uint32_t record_head;    // Total frames recorded
+static struct k_spinlock record_lock;
+
+// Command-to-commit latency, measured on the first frame after each new command
+static uint32_t last_sequence;
+static uint32_t latency_count;
+static uint32_t latency_min_us = UINT32_MAX;
+static uint32_t latency_max_us;
+static uint64_t latency_total_us;
+
+static int fake_init(void)
+{
+    actuator_fake_reset();
+    return 0;
+}
+
+static void fake_commit(const actuator_frame_t *frame)
+{
+    uint32_t now_us = setpoint_now_us();
+
+    k_spinlock_key_t key = k_spin_lock(&record_lock);
+
+    actuator_record_t *rec = &records[record_head & (FAKE_RECORD_COUNT - 1)];
+    rec->frame = *frame;
+    rec->commit_us = now_us;
+    rec->commit_cycles = rov_cycles_now();
+    record_head++;
+
+    if (frame->sequence != last_sequence && frame->command_timestamp_us != 0) {
+        uint32_t latency = now_us - frame->command_timestamp_us;
+
+        last_sequence = frame->sequence;
+        latency_count++;
+        latency_total_us += latency;
+        latency_min_us = MIN(latency_min_us, latency);
+        latency_max_us = MAX(latency_max_us, latency);
+    }
+
+    k_spin_unlock(&record_lock, key);
+}
+
+const actuator_backend_t actuator_fake_backend = {
+    .name = "fake",
+    .init = fake_init,
+    .commit = fake_commit,
+    .isr_safe = true,
+};
+
+/**
+ * Number of frames recorded since the last reset
+ */
+uint32_t actuator_fake_count(void)
+{
+    k_spinlock_key_t key = k_spin_lock(&record_lock);
+    uint32_t count = record_head;
+    k_spin_unlock(&record_lock, key);
+    return count;
+}
+
+/**
+ * Fetch a recorded frame
+ * @param age: 0 for the newest frame, 1 for the one before, ...
+ * @param record: Output record
+ * @return: 0 on success, -ENOENT if the frame is no longer (or not yet) recorded
+ */
+int actuator_fake_get(uint32_t age, actuator_record_t *record)
+{
+    int ret = 0;
+
+    k_spinlock_key_t key = k_spin_lock(&record_lock);
+    if (age >= MIN(record_head, FAKE_RECORD_COUNT)) {
+        ret = -ENOENT;
+    } else {
+        *record = records[(record_head - 1 - age) & (FAKE_RECORD_COUNT - 1)];
+    }
+    k_spin_unlock(&record_lock, key);
+    return ret;
+}
+
+/**
+ * Drop all recorded frames and latency statistics
+ */
+void actuator_fake_reset(void)
+{
+    k_spinlock_key_t key = k_spin_lock(&record_lock);
+    record_head = 0;
+    last_sequence = 0;
+    latency_count = 0;
+    latency_min_us = UINT32_MAX;
+    latency_max_us = 0;
+    latency_total_us = 0;
+    k_spin_unlock(&record_lock, key);
+}
+
+static int cmd_fake_frames(const struct shell *sh, size_t argc, char **argv)
+{
+    uint32_t count = (argc > 1) ? strtoul(argv[1], NULL, 10) : 8;
+    actuator_record_t rec;
+
+    shell_print(sh, "%u frames recorded", actuator_fake_count());
+    for (uint32_t age = count; age-- > 0;) {
+        if (actuator_fake_get(age, &rec) != 0) {
+            continue;
+        }
+        shell_print(sh, "t=%10u us  cmd #%-6u thr %+.2f %+.2f %+.2f %+.2f %+.2f %+.2f %+.2f %+.2f"
+                    "  light %.2f  manip %.2f",
+                    rec.commit_us, rec.frame.sequence,
+                    (double)rec.frame.thrust[0], (double)rec.frame.thrust[1],
+                    (double)rec.frame.thrust[2], (double)rec.frame.thrust[3],
+                    (double)rec.frame.thrust[4], (double)rec.frame.thrust[5],
+                    (double)rec.frame.thrust[6], (double)rec.frame.thrust[7],
+                    (double)rec.frame.light, (double)rec.frame.manipulator);
+    }
+    return 0;
+}
+
+static int cmd_fake_latency(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    k_spinlock_key_t key = k_spin_lock(&record_lock);
+    uint32_t count = latency_count;
+    uint32_t min_us = latency_min_us;
+    uint32_t max_us = latency_max_us;
+    uint64_t total_us = latency_total_us;
+    k_spin_unlock(&record_lock, key);
+
+    if (count == 0) {
+        shell_print(sh, "No commands reached the outputs yet");
+        return 0;
+    }
+    shell_print(sh, "command -> output commit over %u commands: min %u us  mean %u us  max %u us",
+                count, min_us, (uint32_t)(total_us / count), max_us);
+    return 0;
+}
+
+static int cmd_fake_reset(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    actuator_fake_reset();
+    return 0;
+}
+
+SHELL_SUBCMD_ADD((rov, actuator), frames, NULL, "[n] Show the last n recorded frames",
+                 cmd_fake_frames, 1, 1);
+SHELL_SUBCMD_ADD((rov, actuator), latency, NULL, "Command to output latency",
+                 cmd_fake_latency, 1, 0);
+SHELL_SUBCMD_ADD((rov, actuator), reset, NULL, "Clear recorded frames",
+                 cmd_fake_reset, 1, 0);
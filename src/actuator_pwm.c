@@ -0,0 +1,190 @@
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/devicetree.h>
+#include <zephyr/drivers/pwm.h>
+#include <errno.h>
+#include <stm32_ll_tim.h>
+
+#include "actuator.h"
+
+LOG_MODULE_DECLARE(k2_app);
+
+/*
+ * Timer PWM backend for the STM32F7.
+ *
+ * Channels come from the "k2,actuator-pwm" devicetree node (see
+ * boards/nucleo_f767zi.overlay), named after the frame slot they drive.
+ * The Zephyr PWM driver configures each timer and channel once at init,
+ * with output compare preload enabled. After that a commit writes the
+ * CCR registers directly, one timer at a time, with update events held
+ * off (UDIS) while writing. All channels of a timer therefore latch on
+ * the same update event, and a frame costs one register store per
+ * channel instead of a driver call.
+ */
+
+#define ACTUATOR_PWM_NODE DT_NODELABEL(actuator_outputs)
+
+// Pulse widths
+#define THRUSTER_NEUTRAL_US 1500
+#define THRUSTER_RANGE_US   400    // ESC accepts 1100..1900 us
+#define SERVO_MIN_US        1000
+#define SERVO_RANGE_US      1000
+
+#if DT_NODE_HAS_STATUS(ACTUATOR_PWM_NODE, okay)
+
+typedef struct {
+    struct pwm_dt_spec spec;
+    TIM_TypeDef *timer;
+    const char *name;
+} pwm_output_t;
+
+#define PWM_OUTPUT_ENTRY(node, prop, idx)                                              \
+    {                                                                                  \
+        .spec = PWM_DT_SPEC_GET_BY_IDX(node, idx),                                     \
+        .timer = (TIM_TypeDef *)DT_REG_ADDR(DT_PARENT(DT_PWMS_CTLR_BY_IDX(node, idx))), \
+        .name = DT_PROP_BY_IDX(node, pwm_names, idx),                                  \
+    },
+
+static const pwm_output_t outputs[] = {
+    DT_FOREACH_PROP_ELEM(ACTUATOR_PWM_NODE, pwms, PWM_OUTPUT_ENTRY)
+};
+
+#define PWM_OUTPUT_COUNT ARRAY_SIZE(outputs)
+
+// Prepared at init: outputs sorted by timer, with direct register pointers
+typedef struct {
+    volatile uint32_t *ccr;
+    uint8_t slot;
+    float cycles_per_us;
+    uint32_t period_us;
+    uint32_t period_cycles;
+} pwm_channel_t;
+
+typedef struct {
+    TIM_TypeDef *timer;
+    uint8_t first;   // Index into channels[]
+    uint8_t count;
+} pwm_timer_group_t;
+
+static pwm_channel_t channels[PWM_OUTPUT_COUNT];
+static pwm_timer_group_t groups[PWM_OUTPUT_COUNT];
+static uint8_t group_count;
+
+static uint32_t pulse_us_for_slot(const actuator_frame_t *frame, int slot, uint32_t period_us)
+{
+    float value = actuator_frame_slot(frame, slot);
+
+    if (slot == ACTUATOR_SLOT_LIGHT) {
+        return (uint32_t)(value * period_us);
+    }
+    if (slot == ACTUATOR_SLOT_MANIPULATOR) {
+        return SERVO_MIN_US + (uint32_t)(value * SERVO_RANGE_US);
+    }
+    return (uint32_t)(THRUSTER_NEUTRAL_US + value * THRUSTER_RANGE_US);
+}
+
+static int pwm_backend_init(void)
+{
+    uint8_t used[PWM_OUTPUT_COUNT] = { 0 };
+    uint8_t n = 0;
+
+    group_count = 0;
+
+    // Group channels by timer so each timer is written in one burst
+    for (size_t i = 0; i < PWM_OUTPUT_COUNT; i++) {
+        if (used[i]) {
+            continue;
+        }
+
+        pwm_timer_group_t *group = &groups[group_count++];
+        group->timer = outputs[i].timer;
+        group->first = n;
+        group->count = 0;
+
+        for (size_t j = i; j < PWM_OUTPUT_COUNT; j++) {
+            const pwm_output_t *out = &outputs[j];
+            uint64_t cycles_per_sec;
+
+            if (used[j] || out->timer != group->timer) {
+                continue;
+            }
+            used[j] = 1;
+
+            int slot = actuator_slot_from_name(out->name);
+            if (slot < 0) {
+                LOG_ERR("Unknown actuator output name: %s", out->name);
+                return -EINVAL;
+            }
+            if (!pwm_is_ready_dt(&out->spec)) {
+                LOG_ERR("PWM device for %s not ready", out->name);
+                return -ENODEV;
+            }
+            if (pwm_get_cycles_per_sec(out->spec.dev, out->spec.channel, &cycles_per_sec) < 0) {
+                return -EIO;
+            }
+
+            // Let the driver set up the timer, channel mode and preload
+            pwm_channel_t *ch = &channels[n++];
+            ch->slot = (uint8_t)slot;
+            ch->cycles_per_us = (float)cycles_per_sec / 1000000.0f;
+            ch->period_us = out->spec.period / 1000U;
+            ch->period_cycles = (uint32_t)((out->spec.period * cycles_per_sec) / NSEC_PER_SEC);
+            ch->ccr = &out->timer->CCR1 + (out->spec.channel - 1);
+
+            actuator_frame_t neutral = { 0 };
+            uint32_t pulse_us = pulse_us_for_slot(&neutral, slot, ch->period_us);
+            int ret = pwm_set_dt(&out->spec, out->spec.period, PWM_USEC(pulse_us));
+            if (ret < 0) {
+                LOG_ERR("Failed to configure PWM for %s: %d", out->name, ret);
+                return ret;
+            }
+            group->count++;
+        }
+    }
+
+    LOG_INF("PWM actuator backend: %u channels on %u timers",
+            (unsigned int)PWM_OUTPUT_COUNT, group_count);
+    return 0;
+}
+
+static void pwm_backend_commit(const actuator_frame_t *frame)
+{
+    for (uint8_t g = 0; g < group_count; g++) {
+        const pwm_timer_group_t *group = &groups[g];
+        const pwm_channel_t *ch = &channels[group->first];
+
+        // Hold the update event so all CCR preloads transfer together
+        LL_TIM_DisableUpdateEvent(group->timer);
+
+        for (uint8_t i = 0; i < group->count; i++, ch++) {
+            uint32_t pulse = (uint32_t)(pulse_us_for_slot(frame, ch->slot, ch->period_us) *
+                                        ch->cycles_per_us);
+
+            *ch->ccr = MIN(pulse, ch->period_cycles);
+        }
+
+        LL_TIM_EnableUpdateEvent(group->timer);
+    }
+}
+
+#else /* No actuator outputs in the devicetree */
+
+static int pwm_backend_init(void)
+{
+    LOG_WRN("No actuator_outputs node in devicetree, outputs disabled");
+    return 0;
+}
+
+static void pwm_backend_commit(const actuator_frame_t *frame)
+{
+    ARG_UNUSED(frame);
+}
+
+#endif
+
+const actuator_backend_t actuator_pwm_backend = {
+    .name = "pwm",
+    .init = pwm_backend_init,
+    .commit = pwm_backend_commit,
+    .isr_safe = true,
+};
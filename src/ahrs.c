@@ -0,0 +1,394 @@
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/shell/shell.h>
+#include <zephyr/sys/barrier.h>
+#include <math.h>
+#include <string.h>
+
+#include "ahrs.h"
+#include "cycles.h"
+
+LOG_MODULE_DECLARE(k2_app);
+
+// Mahony feedback gains: kp pulls towards accel/mag, ki estimates gyro bias
+#define AHRS_KP 0.5f
+#define AHRS_KI 0.05f
+
+#define RAD_TO_DEG 57.29577951f
+#define DEG_TO_RAD 0.01745329252f
+
+// Earth magnetic field used for synthetic samples (horizontal, vertical)
+#define SYNTH_MAG_H  0.4f
+#define SYNTH_MAG_Z -0.5f
+
+// Validation trace: 60 s of combined roll/pitch oscillation and steady yaw
+#define VALIDATE_DURATION_S  60
+#define VALIDATE_SETTLE_S    5
+#define BENCH_ITERATIONS     2000
+
+// Vehicle estimator: written only by ahrs_feed()
+static ahrs_state_t ahrs_state;
+
+// Published snapshot, protected by a sequence counter (odd = write in progress)
+static ahrs_snapshot_t snapshot;
+static atomic_t snapshot_seq = ATOMIC_INIT(0);
+
+/**
+ * Reset a filter instance to level, facing north
+ * @param state: Filter instance
+ * @param kp: Proportional gain
+ * @param ki: Integral gain (0 disables gyro bias estimation)
+ * @param sample_rate_hz: Rate at which samples will be fed
+ */
+void ahrs_filter_init(ahrs_state_t *state, float kp, float ki, float sample_rate_hz)
+{
+    memset(state, 0, sizeof(*state));
+    state->q[0] = 1.0f;
+    state->two_kp = 2.0f * kp;
+    state->two_ki = 2.0f * ki;
+    state->dt = 1.0f / sample_rate_hz;
+}
+
+/**
+ * Fuse one IMU sample (Mahony complementary filter, single precision only)
+ * @param state: Filter instance
+ * @param sample: Gyro, accel and optional magnetometer sample
+ */
+void ahrs_filter_update(ahrs_state_t *state, const ahrs_sample_t *sample)
+{
+    float q0 = state->q[0], q1 = state->q[1], q2 = state->q[2], q3 = state->q[3];
+    float gx = sample->gyro[0], gy = sample->gyro[1], gz = sample->gyro[2];
+    float ax = sample->accel[0], ay = sample->accel[1], az = sample->accel[2];
+    float norm = ax * ax + ay * ay + az * az;
+
+    // Skip the correction step if the accelerometer reads nothing (free fall)
+    if (norm > 0.0f) {
+        float recip = 1.0f / sqrtf(norm);
+        ax *= recip;
+        ay *= recip;
+        az *= recip;
+
+        // Shared quaternion products
+        float q0q0 = q0 * q0, q0q1 = q0 * q1, q0q2 = q0 * q2, q0q3 = q0 * q3;
+        float q1q1 = q1 * q1, q1q2 = q1 * q2, q1q3 = q1 * q3;
+        float q2q2 = q2 * q2, q2q3 = q2 * q3, q3q3 = q3 * q3;
+
+        // Estimated direction of gravity, error is the cross product with the measurement
+        float vx = 2.0f * (q1q3 - q0q2);
+        float vy = 2.0f * (q0q1 + q2q3);
+        float vz = q0q0 - q1q1 - q2q2 + q3q3;
+        float ex = ay * vz - az * vy;
+        float ey = az * vx - ax * vz;
+        float ez = ax * vy - ay * vx;
+
+        float mx = sample->mag[0], my = sample->mag[1], mz = sample->mag[2];
+        float mnorm = mx * mx + my * my + mz * mz;
+
+        if (sample->has_mag && mnorm > 0.0f) {
+            recip = 1.0f / sqrtf(mnorm);
+            mx *= recip;
+            my *= recip;
+            mz *= recip;
+
+            // Earth field in the earth frame, flattened to (bx, 0, bz)
+            float hx = 2.0f * (mx * (0.5f - q2q2 - q3q3) + my * (q1q2 - q0q3) + mz * (q1q3 + q0q2));
+            float hy = 2.0f * (mx * (q1q2 + q0q3) + my * (0.5f - q1q1 - q3q3) + mz * (q2q3 - q0q1));
+            float bx = sqrtf(hx * hx + hy * hy);
+            float bz = 2.0f * (mx * (q1q3 - q0q2) + my * (q2q3 + q0q1) + mz * (0.5f - q1q1 - q2q2));
+
+            // Estimated direction of the field in the body frame
+            float wx = 2.0f * (bx * (0.5f - q2q2 - q3q3) + bz * (q1q3 - q0q2));
+            float wy = 2.0f * (bx * (q1q2 - q0q3) + bz * (q0q1 + q2q3));
+            float wz = 2.0f * (bx * (q0q2 + q1q3) + bz * (0.5f - q1q1 - q2q2));
+
+            ex += my * wz - mz * wy;
+            ey += mz * wx - mx * wz;
+            ez += mx * wy - my * wx;
+        }
+
+        // Integral feedback (gyro bias), then proportional feedback
+        if (state->two_ki > 0.0f) {
+            state->integral[0] += state->two_ki * ex * state->dt;
+            state->integral[1] += state->two_ki * ey * state->dt;
+            state->integral[2] += state->two_ki * ez * state->dt;
+            gx += state->integral[0];
+            gy += state->integral[1];
+            gz += state->integral[2];
+        }
+        gx += state->two_kp * ex;
+        gy += state->two_kp * ey;
+        gz += state->two_kp * ez;
+    }
+
+    // Integrate the rate of change of the quaternion
+    float half_dt = 0.5f * state->dt;
+    gx *= half_dt;
+    gy *= half_dt;
+    gz *= half_dt;
+
+    float qa = q0, qb = q1, qc = q2;
+    q0 += -qb * gx - qc * gy - q3 * gz;
+    q1 += qa * gx + qc * gz - q3 * gy;
+    q2 += qa * gy - qb * gz + q3 * gx;
+    q3 += qa * gz + qb * gy - qc * gx;
+
+    float recip = 1.0f / sqrtf(q0 * q0 + q1 * q1 + q2 * q2 + q3 * q3);
+    state->q[0] = q0 * recip;
+    state->q[1] = q1 * recip;
+    state->q[2] = q2 * recip;
+    state->q[3] = q3 * recip;
+    state->updates++;
+}
+
+/**
+ * Convert the filter state to quaternion + Euler angles
+ * @param state: Filter instance
+ * @param out: Output snapshot
+ */
+void ahrs_filter_snapshot(const ahrs_state_t *state, ahrs_snapshot_t *out)
+{
+    float q0 = state->q[0], q1 = state->q[1], q2 = state->q[2], q3 = state->q[3];
+
+    out->q[0] = q0;
+    out->q[1] = q1;
+    out->q[2] = q2;
+    out->q[3] = q3;
+
+    float sin_pitch = -2.0f * (q1 * q3 - q0 * q2);
+    sin_pitch = fmaxf(-1.0f, fminf(sin_pitch, 1.0f));
+
+    out->roll_deg = atan2f(q0 * q1 + q2 * q3, 0.5f - q1 * q1 - q2 * q2) * RAD_TO_DEG;
+    out->pitch_deg = asinf(sin_pitch) * RAD_TO_DEG;
+
+    // Yaw is counter-clockwise about z-up, compass heading runs clockwise
+    float yaw_deg = atan2f(q1 * q2 + q0 * q3, 0.5f - q2 * q2 - q3 * q3) * RAD_TO_DEG;
+    out->heading_deg = (yaw_deg > 0.0f) ? 360.0f - yaw_deg : -yaw_deg;
+
+    out->updates = state->updates;
+}
+
+/**
+ * Ideal IMU sample for a known attitude and attitude rate (ZYX Euler)
+ * @param euler: Roll, pitch, yaw in radians (yaw counter-clockwise)
+ * @param euler_rate: Time derivatives of roll, pitch, yaw in rad/s
+ * @param sample: Output sample (accel in g, mag in arbitrary units)
+ */
+void ahrs_synthesize(const float euler[3], const float euler_rate[3], ahrs_sample_t *sample)
+{
+    float sr = sinf(euler[0]), cr = cosf(euler[0]);
+    float sp = sinf(euler[1]), cp = cosf(euler[1]);
+    float sy = sinf(euler[2]), cy = cosf(euler[2]);
+
+    // Body rates from Euler rates
+    sample->gyro[0] = euler_rate[0] - euler_rate[2] * sp;
+    sample->gyro[1] = euler_rate[1] * cr + euler_rate[2] * cp * sr;
+    sample->gyro[2] = -euler_rate[1] * sr + euler_rate[2] * cp * cr;
+
+    // Gravity (earth z-up) seen from the body
+    sample->accel[0] = -sp;
+    sample->accel[1] = cp * sr;
+    sample->accel[2] = cp * cr;
+
+    // Earth field (SYNTH_MAG_H north, SYNTH_MAG_Z up) seen from the body
+    sample->mag[0] = cy * cp * SYNTH_MAG_H - sp * SYNTH_MAG_Z;
+    sample->mag[1] = (cy * sp * sr - sy * cr) * SYNTH_MAG_H + cp * sr * SYNTH_MAG_Z;
+    sample->mag[2] = (cy * sp * cr + sy * sr) * SYNTH_MAG_H + cp * cr * SYNTH_MAG_Z;
+    sample->has_mag = true;
+}
+
+/**
+ * Initialize the vehicle attitude estimator
+ */
+void ahrs_init(void)
+{
+    ahrs_filter_init(&ahrs_state, AHRS_KP, AHRS_KI, AHRS_SAMPLE_RATE_HZ);
+    ahrs_filter_snapshot(&ahrs_state, &snapshot);
+
+    LOG_INF("AHRS (Mahony) ready: kp %.2f, ki %.3f, %d Hz",
+            (double)AHRS_KP, (double)AHRS_KI, AHRS_SAMPLE_RATE_HZ);
+}
+
+/**
+ * Fuse an IMU sample into the vehicle estimate and publish the result
+ * Must only be called from one thread (the IMU consumer).
+ * @param sample: IMU sample at AHRS_SAMPLE_RATE_HZ
+ */
+void ahrs_feed(const ahrs_sample_t *sample)
+{
+    ahrs_snapshot_t next;
+
+    ahrs_filter_update(&ahrs_state, sample);
+    ahrs_filter_snapshot(&ahrs_state, &next);
+
+    // Sequence lock: odd while writing, readers retry if it changed
+    atomic_inc(&snapshot_seq);
+    barrier_dmem_fence_full();
+    snapshot = next;
+    barrier_dmem_fence_full();
+    atomic_inc(&snapshot_seq);
+}
+
+/**
+ * Read the latest attitude without blocking the writer
+ * @param out: Output snapshot
+ */
+void ahrs_get_snapshot(ahrs_snapshot_t *out)
+{
+    atomic_val_t start, end;
+
+    do {
+        start = atomic_get(&snapshot_seq);
+        barrier_dmem_fence_full();
+        *out = snapshot;
+        barrier_dmem_fence_full();
+        end = atomic_get(&snapshot_seq);
+    } while ((start & 1) || start != end);
+}
+
+// Deterministic uniform noise in -1..+1 for the synthetic traces
+static float synth_noise(uint32_t *state)
+{
+    *state = *state * 1664525u + 1013904223u;
+    return (float)(int32_t)*state / 2147483648.0f;
+}
+
+static float wrap_err_deg(float err)
+{
+    while (err > 180.0f) {
+        err -= 360.0f;
+    }
+    while (err < -180.0f) {
+        err += 360.0f;
+    }
+    return err;
+}
+
+static int cmd_ahrs_show(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    ahrs_snapshot_t s;
+    ahrs_get_snapshot(&s);
+
+    shell_print(sh, "q (%.4f, %.4f, %.4f, %.4f)", (double)s.q[0], (double)s.q[1],
+                (double)s.q[2], (double)s.q[3]);
+    shell_print(sh, "roll %.2f  pitch %.2f  heading %.2f deg  (%u updates)",
+                (double)s.roll_deg, (double)s.pitch_deg, (double)s.heading_deg, s.updates);
+    return 0;
+}
+
+static int cmd_ahrs_bench(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    static ahrs_state_t bench_state;
+    const float euler[3] = { 0.2f, -0.1f, 1.0f };
+    const float rate[3] = { 0.05f, 0.02f, 0.1f };
+    ahrs_sample_t sample;
+
+    ahrs_synthesize(euler, rate, &sample);
+
+    for (int with_mag = 0; with_mag <= 1; with_mag++) {
+        uint32_t min = UINT32_MAX, max = 0;
+        uint64_t total = 0;
+
+        sample.has_mag = with_mag;
+        ahrs_filter_init(&bench_state, AHRS_KP, AHRS_KI, AHRS_SAMPLE_RATE_HZ);
+
+        for (int i = 0; i < BENCH_ITERATIONS; i++) {
+            uint32_t start = rov_cycles_now();
+            ahrs_filter_update(&bench_state, &sample);
+            uint32_t cycles = rov_cycles_now() - start;
+
+            min = MIN(min, cycles);
+            max = MAX(max, cycles);
+            total += cycles;
+        }
+
+        uint32_t mean = (uint32_t)(total / BENCH_ITERATIONS);
+        shell_print(sh, "%s: min %u  mean %u  max %u cycles/update (mean %u ns)",
+                    with_mag ? "accel+gyro+mag" : "accel+gyro    ",
+                    min, mean, max, rov_cycles_to_ns(mean));
+    }
+    return 0;
+}
+
+static int cmd_ahrs_validate(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    static ahrs_state_t val_state;
+    const float dt = 1.0f / AHRS_SAMPLE_RATE_HZ;
+    const float gyro_bias[3] = { 0.01f, -0.008f, 0.005f };   // rad/s
+    uint32_t noise = 42;
+    float sq_err[3] = { 0 }, max_err[3] = { 0 };
+    uint32_t counted = 0;
+
+    ahrs_filter_init(&val_state, AHRS_KP, AHRS_KI, AHRS_SAMPLE_RATE_HZ);
+
+    for (int i = 0; i < VALIDATE_DURATION_S * AHRS_SAMPLE_RATE_HZ; i++) {
+        float t = i * dt;
+        float w_roll = 2.0f * 3.14159265f * 0.2f;
+        float w_pitch = 2.0f * 3.14159265f * 0.13f;
+        float euler[3] = {
+            20.0f * DEG_TO_RAD * sinf(w_roll * t),
+            15.0f * DEG_TO_RAD * sinf(w_pitch * t),
+            10.0f * DEG_TO_RAD * t,
+        };
+        float rate[3] = {
+            20.0f * DEG_TO_RAD * w_roll * cosf(w_roll * t),
+            15.0f * DEG_TO_RAD * w_pitch * cosf(w_pitch * t),
+            10.0f * DEG_TO_RAD,
+        };
+        ahrs_sample_t sample;
+
+        // Truth -> ideal sample -> bias and noise
+        ahrs_synthesize(euler, rate, &sample);
+        for (int k = 0; k < 3; k++) {
+            sample.gyro[k] += gyro_bias[k] + 0.005f * synth_noise(&noise);
+            sample.accel[k] += 0.02f * synth_noise(&noise);
+            sample.mag[k] += 0.01f * synth_noise(&noise);
+        }
+        ahrs_filter_update(&val_state, &sample);
+
+        if (t < VALIDATE_SETTLE_S) {
+            continue;
+        }
+
+        ahrs_snapshot_t est;
+        ahrs_filter_snapshot(&val_state, &est);
+
+        float yaw_deg = euler[2] * RAD_TO_DEG;
+        float err[3] = {
+            est.roll_deg - euler[0] * RAD_TO_DEG,
+            est.pitch_deg - euler[1] * RAD_TO_DEG,
+            wrap_err_deg(est.heading_deg + yaw_deg),   // heading = -yaw
+        };
+        for (int k = 0; k < 3; k++) {
+            sq_err[k] += err[k] * err[k];
+            max_err[k] = fmaxf(max_err[k], fabsf(err[k]));
+        }
+        counted++;
+    }
+
+    static const char *const names[3] = { "roll", "pitch", "heading" };
+    shell_print(sh, "Synthetic trace: %d s at %d Hz, gyro bias + noise, first %d s skipped",
+                VALIDATE_DURATION_S, AHRS_SAMPLE_RATE_HZ, VALIDATE_SETTLE_S);
+    for (int k = 0; k < 3; k++) {
+        shell_print(sh, "%-8s rms %.3f deg  max %.3f deg", names[k],
+                    (double)sqrtf(sq_err[k] / counted), (double)max_err[k]);
+    }
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(ahrs_cmds,
+    SHELL_CMD(show, NULL, "Show the latest attitude estimate", cmd_ahrs_show),
+    SHELL_CMD(bench, NULL, "Measure cycles per filter update", cmd_ahrs_bench),
+    SHELL_CMD(validate, NULL, "Run the filter on a synthetic IMU trace", cmd_ahrs_validate),
+    SHELL_SUBCMD_SET_END
+);
+
+SHELL_SUBCMD_ADD((rov), ahrs, &ahrs_cmds, "Attitude estimator", NULL, 1, 0);
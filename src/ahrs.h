@@ -0,0 +1,60 @@
+#pragma once
+
+#include <zephyr/kernel.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Rate at which IMU samples are fed to the filter (the IMU sampling rate)
+#define AHRS_SAMPLE_RATE_HZ 1000
+
+// One IMU sample in the sensor (body) frame: x forward, y left, z up
+typedef struct {
+    float gyro[3];   // Angular rate, rad/s
+    float accel[3];  // Specific force, any unit (normalized internally)
+    float mag[3];    // Magnetic field, any unit (ignored unless has_mag)
+    bool has_mag;
+} ahrs_sample_t;
+
+// Latest attitude estimate, published to the control loop
+typedef struct {
+    float q[4];           // Orientation quaternion (w, x, y, z), body to earth
+    float roll_deg;
+    float pitch_deg;
+    float heading_deg;    // Compass heading, 0..360 clockwise from magnetic north
+    uint32_t updates;     // Number of samples fused so far
+} ahrs_snapshot_t;
+
+/*
+ * Mahony filter state, aligned to the Cortex-M7 32-byte D-cache line.
+ * The read-modify-write fields (quaternion, integral, dt) fill exactly
+ * the first line; the read-mostly gains and counter share the second.
+ */
+typedef struct __aligned(32) {
+    float q[4];          // Orientation quaternion
+    float integral[3];   // Integral of the attitude error (gyro bias estimate)
+    float dt;            // Sample period, s
+    float two_kp;        // Proportional feedback gain (x2)
+    float two_ki;        // Integral feedback gain (x2)
+    uint32_t updates;
+} ahrs_state_t;
+
+// Filter primitives, usable on any instance (validation, benchmarks)
+void ahrs_filter_init(ahrs_state_t *state, float kp, float ki, float sample_rate_hz);
+void ahrs_filter_update(ahrs_state_t *state, const ahrs_sample_t *sample);
+void ahrs_filter_snapshot(const ahrs_state_t *state, ahrs_snapshot_t *snapshot);
+
+// Ideal IMU sample for a known attitude (simulation and validation traces)
+void ahrs_synthesize(const float euler[3], const float euler_rate[3], ahrs_sample_t *sample);
+
+// Vehicle attitude estimator
+void ahrs_init(void);
+void ahrs_feed(const ahrs_sample_t *sample);        // Single producer (IMU path)
+void ahrs_get_snapshot(ahrs_snapshot_t *snapshot);  // Lock-free, any thread
+
+#ifdef __cplusplus
+}
+#endif
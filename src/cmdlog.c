@@ -0,0 +1,316 @@
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/logging/log_ctrl.h>
+#include <zephyr/shell/shell.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cmdlog.h"
+#include "cycles.h"
+#include "hotpath.h"
+
+LOG_MODULE_DECLARE(k2_app);
+
+// Bench: keep the log backlog under this many messages so nothing is dropped
+#define CMDLOG_BENCH_BACKLOG     16
+#define CMDLOG_BENCH_DEFAULT     200
+#define CMDLOG_BENCH_MAX         5000
+#define CMDLOG_BENCH_TIMEOUT_MS  60000
+
+static atomic_t level = ATOMIC_INIT(CMDLOG_DEFAULT_LEVEL);
+static atomic_t decimate = ATOMIC_INIT(1);
+
+// Written by the control thread only; the shell reads the words as they are
+// and asks for a reset, applied with the next command
+static cmdlog_stats_t stats;
+static uint32_t countdown;
+static atomic_t reset_requested;
+
+static const char *const level_names[CMDLOG_LEVEL_COUNT] = {
+    "off", "record", "verbose"
+};
+
+/**
+ * Log one command as a single compact record
+ * Integer arguments only: the record is packaged without formatting here.
+ * Fields: sequence, timestamp_us, surge, sway, heave, roll, pitch, yaw,
+ * light, manipulator (parsed by log_decode.py).
+ * @param command: Command dequeued by the control thread
+ */
+static inline void cmdlog_record(const rov_command_t *command)
+{
+    LOG_INF("cmd #%u @%u %d %d %d %d %d %d L%u M%u", command->sequence, command->timestamp_us,
+            command->surge, command->sway, command->heave, command->roll, command->pitch,
+            command->yaw, command->light, command->manipulator);
+}
+
+/**
+ * Per-command log hook of the control thread
+ * @param command: Command dequeued by the control thread
+ */
+ROV_HOT_CODE void cmdlog_log_command(const rov_command_t *command)
+{
+    uint32_t start = rov_cycles_now();
+    bool logged = false;
+
+    if (atomic_get(&level) != CMDLOG_OFF) {
+        uint32_t every = (uint32_t)atomic_get(&decimate);
+
+        // Also restarts the count when the decimation was lowered
+        if (countdown == 0 || countdown >= every) {
+            cmdlog_record(command);
+            countdown = every;
+            logged = true;
+        }
+        countdown--;
+    }
+
+    uint32_t cycles = rov_cycles_now() - start;
+
+    if (atomic_get(&reset_requested) != 0) {
+        atomic_clear(&reset_requested);
+        memset(&stats, 0, sizeof(stats));
+    }
+    stats.commands++;
+    if (logged) {
+        stats.records++;
+        if (cycles > stats.max_cycles) {
+            stats.max_cycles = cycles;
+        }
+    }
+}
+
+/**
+ * Whether light/manipulator changes get their own log line
+ * @return: true at CMDLOG_VERBOSE
+ */
+bool cmdlog_verbose(void)
+{
+    return atomic_get(&level) == CMDLOG_VERBOSE;
+}
+
+/**
+ * Set the per-command log level
+ * @param new_level: CMDLOG_OFF, CMDLOG_RECORD or CMDLOG_VERBOSE
+ * @return: 0 on success, -EINVAL if out of range
+ */
+int cmdlog_set_level(cmdlog_level_t new_level)
+{
+    if ((unsigned int)new_level >= CMDLOG_LEVEL_COUNT) {
+        return -EINVAL;
+    }
+    atomic_set(&level, new_level);
+    return 0;
+}
+
+cmdlog_level_t cmdlog_get_level(void)
+{
+    return (cmdlog_level_t)atomic_get(&level);
+}
+
+/**
+ * Log only one command in every N (records keep their sequence numbers,
+ * so the decoder tells decimation from drops)
+ * @param every: 1..CMDLOG_MAX_DECIMATE
+ * @return: 0 on success, -EINVAL if out of range
+ */
+int cmdlog_set_decimate(uint32_t every)
+{
+    if (every < 1 || every > CMDLOG_MAX_DECIMATE) {
+        return -EINVAL;
+    }
+    atomic_set(&decimate, (atomic_val_t)every);
+    return 0;
+}
+
+uint32_t cmdlog_get_decimate(void)
+{
+    return (uint32_t)atomic_get(&decimate);
+}
+
+const char *cmdlog_level_name(cmdlog_level_t value)
+{
+    return ((unsigned int)value < CMDLOG_LEVEL_COUNT) ? level_names[value] : "?";
+}
+
+void cmdlog_get_stats(cmdlog_stats_t *out)
+{
+    if (atomic_get(&reset_requested) != 0) {
+        memset(out, 0, sizeof(*out));
+        return;
+    }
+    *out = stats;
+}
+
+void cmdlog_reset_stats(void)
+{
+    atomic_set(&reset_requested, 1);
+}
+
+/**
+ * The per-command output this module replaced (nine formatted lines),
+ * kept for the bench only
+ */
+static void cmdlog_legacy(const rov_command_t *command)
+{
+    LOG_INF("Processing ROV command #%u", command->sequence);
+    LOG_INF("=== 6DOF CONTROL ===");
+    LOG_INF("Surge: %+4d", command->surge);
+    LOG_INF("Sway:  %+4d", command->sway);
+    LOG_INF("Heave: %+4d", command->heave);
+    LOG_INF("Roll:  %+4d", command->roll);
+    LOG_INF("Pitch: %+4d", command->pitch);
+    LOG_INF("Yaw:   %+4d", command->yaw);
+    LOG_INF("==================");
+}
+
+typedef struct {
+    uint32_t call_cycles;    // Total, at the call site
+    uint32_t elapsed_ms;     // Until the backlog drained
+    bool timed_out;
+} cmdlog_bench_t;
+
+/**
+ * Push synthetic commands through one log path as fast as the backend
+ * drains them: the call site waits while more than CMDLOG_BENCH_BACKLOG
+ * messages are pending, so the rate measured is the sustained one.
+ */
+static void cmdlog_bench_run(void (*log_fn)(const rov_command_t *), uint32_t count,
+                             cmdlog_bench_t *result)
+{
+    rov_command_t command = { 0 };
+    int64_t start = k_uptime_get();
+    int64_t deadline = start + CMDLOG_BENCH_TIMEOUT_MS;
+
+    memset(result, 0, sizeof(*result));
+    for (uint32_t i = 0; i < count && !result->timed_out; i++) {
+        while (log_buffered_cnt() >= CMDLOG_BENCH_BACKLOG) {
+            if (k_uptime_get() > deadline) {
+                result->timed_out = true;
+                break;
+            }
+            k_sleep(K_MSEC(1));
+        }
+
+        command.sequence = i + 1;
+        command.timestamp_us = (uint32_t)(k_uptime_get() * 1000);
+        command.surge = (int8_t)(i & 0x7F);
+        command.yaw = (int8_t)-(int8_t)(i & 0x7F);
+
+        uint32_t t0 = rov_cycles_now();
+        log_fn(&command);
+        result->call_cycles += rov_cycles_now() - t0;
+    }
+
+    while (log_buffered_cnt() > 0 && k_uptime_get() <= deadline) {
+        k_sleep(K_MSEC(1));
+    }
+    result->timed_out |= log_buffered_cnt() > 0;
+    result->elapsed_ms = (uint32_t)(k_uptime_get() - start);
+}
+
+static void cmdlog_bench_print(const struct shell *sh, const char *name, uint32_t count,
+                               const cmdlog_bench_t *r)
+{
+    uint32_t ms = MAX(r->elapsed_ms, 1U);
+
+    shell_print(sh, "%-8s %6u commands in %6u ms: %7u commands/s, %6u ns/command at the call site%s",
+                name, count, r->elapsed_ms, (uint32_t)((uint64_t)count * 1000U / ms),
+                rov_cycles_to_ns(r->call_cycles / MAX(count, 1U)),
+                r->timed_out ? " (timed out)" : "");
+}
+
+static int cmd_log_show(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    cmdlog_stats_t s;
+    cmdlog_get_stats(&s);
+
+    shell_print(sh, "Per-command log: %s, every %u command(s)",
+                cmdlog_level_name(cmdlog_get_level()), cmdlog_get_decimate());
+    shell_print(sh, "Commands %u, records %u, worst record cost %u ns",
+                s.commands, s.records, rov_cycles_to_ns(s.max_cycles));
+    shell_print(sh, "Log messages pending: %u", log_buffered_cnt());
+    return 0;
+}
+
+static int cmd_log_level(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+
+    for (int i = 0; i < CMDLOG_LEVEL_COUNT; i++) {
+        if (strcmp(argv[1], level_names[i]) == 0) {
+            cmdlog_set_level((cmdlog_level_t)i);
+            return 0;
+        }
+    }
+    shell_error(sh, "Level must be off, record or verbose");
+    return -EINVAL;
+}
+
+static int cmd_log_every(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+
+    long every = strtol(argv[1], NULL, 10);
+
+    if (cmdlog_set_decimate(every > 0 ? (uint32_t)every : 0) < 0) {
+        shell_error(sh, "Decimation must be 1..%d", CMDLOG_MAX_DECIMATE);
+        return -EINVAL;
+    }
+    return 0;
+}
+
+static int cmd_log_reset(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    cmdlog_reset_stats();
+    shell_print(sh, "Log statistics reset");
+    return 0;
+}
+
+static int cmd_log_bench(const struct shell *sh, size_t argc, char **argv)
+{
+    uint32_t count = CMDLOG_BENCH_DEFAULT;
+    cmdlog_bench_t legacy;
+    cmdlog_bench_t record;
+
+    if (argc > 1) {
+        long n = strtol(argv[1], NULL, 10);
+
+        if (n < 1 || n > CMDLOG_BENCH_MAX) {
+            shell_error(sh, "Commands must be 1..%d", CMDLOG_BENCH_MAX);
+            return -EINVAL;
+        }
+        count = (uint32_t)n;
+    }
+
+    cmdlog_bench_run(cmdlog_legacy, count, &legacy);
+    cmdlog_bench_run(cmdlog_record, count, &record);
+
+    cmdlog_bench_print(sh, "legacy", count, &legacy);
+    cmdlog_bench_print(sh, "record", count, &record);
+    if (legacy.elapsed_ms > 0 && record.elapsed_ms > 0) {
+        shell_print(sh, "Throughput gain: x%u.%02u",
+                    legacy.elapsed_ms / record.elapsed_ms,
+                    (legacy.elapsed_ms % record.elapsed_ms) * 100U / record.elapsed_ms);
+    }
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(log_cmds,
+    SHELL_CMD(show, NULL, "Per-command log level and statistics", cmd_log_show),
+    SHELL_CMD_ARG(level, NULL, "<off|record|verbose> Per-command verbosity", cmd_log_level, 2, 0),
+    SHELL_CMD_ARG(every, NULL, "<n> Log one command in every n", cmd_log_every, 2, 0),
+    SHELL_CMD(reset, NULL, "Clear log statistics", cmd_log_reset),
+    SHELL_CMD_ARG(bench, NULL, "[commands] Compare the old per-command output with the record",
+                  cmd_log_bench, 1, 1),
+    SHELL_SUBCMD_SET_END
+);
+
+SHELL_SUBCMD_ADD((rov), log, &log_cmds, "Per-command logging", NULL, 1, 0);
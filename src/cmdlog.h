@@ -0,0 +1,52 @@
+#pragma once
+
+#include <zephyr/kernel.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "control.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Per-command logging for the control path.
+ *
+ * A command produces at most one compact record: a single log call with
+ * integer arguments only, so deferred logging stores it as a small binary
+ * package and formats it in the log thread, and with dictionary output
+ * (log_dict.conf) only the arguments go over the UART. log_decode.py
+ * decodes either form on the host.
+ */
+typedef enum {
+    CMDLOG_OFF = 0,       // No per-command output
+    CMDLOG_RECORD,        // One compact record per logged command
+    CMDLOG_VERBOSE,       // Record plus light/manipulator changes
+    CMDLOG_LEVEL_COUNT
+} cmdlog_level_t;
+
+#define CMDLOG_DEFAULT_LEVEL  CMDLOG_RECORD
+#define CMDLOG_MAX_DECIMATE   1000
+
+typedef struct {
+    uint32_t commands;      // Commands seen by the control thread
+    uint32_t records;       // Records logged
+    uint32_t max_cycles;    // Worst control thread cost of one record
+} cmdlog_stats_t;
+
+void cmdlog_log_command(const rov_command_t *command);
+bool cmdlog_verbose(void);
+
+int cmdlog_set_level(cmdlog_level_t level);
+cmdlog_level_t cmdlog_get_level(void);
+int cmdlog_set_decimate(uint32_t every);   // Log one command in every N
+uint32_t cmdlog_get_decimate(void);
+const char *cmdlog_level_name(cmdlog_level_t level);
+
+void cmdlog_get_stats(cmdlog_stats_t *stats);
+void cmdlog_reset_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
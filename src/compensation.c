@@ -0,0 +1,349 @@
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/shell/shell.h>
+#include <zephyr/settings/settings.h>
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "compensation.h"
+#include "hotpath.h"
+
+LOG_MODULE_DECLARE(k2_app);
+
+#define COMP_SEGMENTS (COMP_TABLE_POINTS - 1)
+
+// Forces below this are treated as zero (no deadband jump on idle thrusters)
+#define COMP_ZERO_FORCE 1e-4f
+
+/*
+ * Per-tick tables as base + slope per segment, laid out so the frame is
+ * processed in one loop: index from |force|, pick the direction row, one
+ * multiply-add, restore the sign. Double-buffered like the filter bank,
+ * with an atomic index swap to publish a new set.
+ */
+typedef struct {
+    float base[ROV_THRUSTER_COUNT][COMP_DIRECTION_COUNT][COMP_SEGMENTS];
+    float slope[ROV_THRUSTER_COUNT][COMP_DIRECTION_COUNT][COMP_SEGMENTS];
+} comp_tables_t;
+
+static comp_tables_t ROV_HOT_BSS table_sets[2];
+static atomic_t active_set = ATOMIC_INIT(0);
+K_MUTEX_DEFINE(comp_lock);   // Serializes writers of the inactive set and the source tables
+
+// Source tables, as loaded from settings or set from the shell
+static float tables[ROV_THRUSTER_COUNT][COMP_DIRECTION_COUNT][COMP_TABLE_POINTS];
+
+static const char *const direction_names[COMP_DIRECTION_COUNT] = { "fwd", "rev" };
+
+static void comp_publish(void)
+{
+    int active = atomic_get(&active_set);
+    comp_tables_t *next = &table_sets[!active];
+
+    for (int t = 0; t < ROV_THRUSTER_COUNT; t++) {
+        for (int d = 0; d < COMP_DIRECTION_COUNT; d++) {
+            for (int i = 0; i < COMP_SEGMENTS; i++) {
+                next->base[t][d][i] = tables[t][d][i];
+                next->slope[t][d][i] = tables[t][d][i + 1] - tables[t][d][i];
+            }
+        }
+    }
+
+    // The control loop picks up the new set on its next tick
+    atomic_set(&active_set, !active);
+}
+
+static bool comp_table_valid(const float table[COMP_TABLE_POINTS])
+{
+    for (int i = 0; i < COMP_TABLE_POINTS; i++) {
+        if (!(table[i] >= 0.0f && table[i] <= 1.0f)) {
+            return false;
+        }
+        if (i > 0 && table[i] < table[i - 1]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void comp_identity(void)
+{
+    for (int t = 0; t < ROV_THRUSTER_COUNT; t++) {
+        for (int d = 0; d < COMP_DIRECTION_COUNT; d++) {
+            for (int i = 0; i < COMP_TABLE_POINTS; i++) {
+                tables[t][d][i] = (float)i / COMP_SEGMENTS;
+            }
+        }
+    }
+}
+
+static int comp_direction_from_name(const char *name, size_t len)
+{
+    for (int d = 0; d < COMP_DIRECTION_COUNT; d++) {
+        if (strlen(direction_names[d]) == len && strncmp(name, direction_names[d], len) == 0) {
+            return d;
+        }
+    }
+    return -1;
+}
+
+/**
+ * Settings handler: "comp/<thruster>/<fwd|rev>" = float[COMP_TABLE_POINTS]
+ */
+static int comp_settings_set(const char *key, size_t len, settings_read_cb read_cb, void *cb_arg)
+{
+    const char *next;
+    char *end;
+    float table[COMP_TABLE_POINTS];
+    long thruster = strtol(key, &end, 10);
+
+    if (end == key || *end != '/' || thruster < 0 || thruster >= ROV_THRUSTER_COUNT) {
+        return -ENOENT;
+    }
+    settings_name_next(key, &next);
+    if (next == NULL) {
+        return -ENOENT;
+    }
+    int dir = comp_direction_from_name(next, settings_name_next(next, NULL));
+    if (dir < 0) {
+        return -ENOENT;
+    }
+    if (len != sizeof(table) || read_cb(cb_arg, table, sizeof(table)) != sizeof(table)) {
+        return -EINVAL;
+    }
+    if (!comp_table_valid(table)) {
+        LOG_WRN("Ignoring invalid compensation table %s", key);
+        return -EINVAL;
+    }
+
+    k_mutex_lock(&comp_lock, K_FOREVER);
+    memcpy(tables[thruster][dir], table, sizeof(table));
+    k_mutex_unlock(&comp_lock);
+    return 0;
+}
+
+static int comp_settings_commit(void)
+{
+    k_mutex_lock(&comp_lock, K_FOREVER);
+    comp_publish();
+    k_mutex_unlock(&comp_lock);
+    return 0;
+}
+
+SETTINGS_STATIC_HANDLER_DEFINE(comp, "comp", NULL, comp_settings_set, comp_settings_commit, NULL);
+
+/**
+ * Initialize compensation (identity tables) and load saved tables
+ */
+void comp_init(void)
+{
+    k_mutex_lock(&comp_lock, K_FOREVER);
+    comp_identity();
+    comp_publish();
+    k_mutex_unlock(&comp_lock);
+
+    int ret = settings_subsys_init();
+    if (ret == 0) {
+        ret = settings_load_subtree("comp");
+    }
+    if (ret < 0) {
+        LOG_WRN("Compensation tables not loaded from settings: %d", ret);
+    }
+
+    LOG_INF("Thruster compensation: %d-point forward/reverse tables", COMP_TABLE_POINTS);
+}
+
+/**
+ * Convert normalized force to thruster command for one control tick
+ * @param thrust: Force per thruster (-1.0 to +1.0), replaced by the command
+ */
+ROV_HOT_CODE void comp_apply(float thrust[ROV_THRUSTER_COUNT])
+{
+    const comp_tables_t *c = &table_sets[atomic_get(&active_set)];
+
+    for (int t = 0; t < ROV_THRUSTER_COUNT; t++) {
+        float force = thrust[t];
+        float mag = fminf(fabsf(force), 1.0f);
+        int dir = force < 0.0f;
+        float x = mag * COMP_SEGMENTS;
+        int i = MIN((int)x, COMP_SEGMENTS - 1);
+        float command = c->base[t][dir][i] + (x - i) * c->slope[t][dir][i];
+
+        // Zero force stays at zero rather than jumping to the deadband edge
+        command = (mag > COMP_ZERO_FORCE) ? command : 0.0f;
+        thrust[t] = copysignf(command, force);
+    }
+}
+
+/**
+ * Replace one compensation table
+ * @param thruster: Thruster index
+ * @param dir: Forward or reverse
+ * @param table: Command magnitude at force 0, 1/16, ... 1 (non-decreasing, 0..1)
+ * @return: 0 on success, -EINVAL on bad arguments
+ */
+int comp_set_table(int thruster, enum comp_direction dir, const float table[COMP_TABLE_POINTS])
+{
+    if (thruster < 0 || thruster >= ROV_THRUSTER_COUNT ||
+        dir < 0 || dir >= COMP_DIRECTION_COUNT || !comp_table_valid(table)) {
+        return -EINVAL;
+    }
+
+    k_mutex_lock(&comp_lock, K_FOREVER);
+    memcpy(tables[thruster][dir], table, sizeof(tables[thruster][dir]));
+    comp_publish();
+    k_mutex_unlock(&comp_lock);
+    return 0;
+}
+
+/**
+ * Read back one compensation table
+ */
+void comp_get_table(int thruster, enum comp_direction dir, float table[COMP_TABLE_POINTS])
+{
+    k_mutex_lock(&comp_lock, K_FOREVER);
+    memcpy(table, tables[thruster][dir], sizeof(tables[thruster][dir]));
+    k_mutex_unlock(&comp_lock);
+}
+
+/**
+ * Go back to identity tables (no compensation); saved tables are kept
+ */
+void comp_reset(void)
+{
+    k_mutex_lock(&comp_lock, K_FOREVER);
+    comp_identity();
+    comp_publish();
+    k_mutex_unlock(&comp_lock);
+}
+
+/**
+ * Persist all tables to settings
+ * @return: 0 on success, negative error code from the settings backend
+ */
+int comp_save(void)
+{
+    char name[24];
+    int ret = 0;
+
+    k_mutex_lock(&comp_lock, K_FOREVER);
+    for (int t = 0; t < ROV_THRUSTER_COUNT && ret == 0; t++) {
+        for (int d = 0; d < COMP_DIRECTION_COUNT && ret == 0; d++) {
+            snprintf(name, sizeof(name), "comp/%d/%s", t, direction_names[d]);
+            ret = settings_save_one(name, tables[t][d], sizeof(tables[t][d]));
+        }
+    }
+    k_mutex_unlock(&comp_lock);
+    return ret;
+}
+
+static int comp_parse_thruster(const struct shell *sh, const char *arg, int *first, int *last)
+{
+    if (strcmp(arg, "all") == 0) {
+        *first = 0;
+        *last = ROV_THRUSTER_COUNT - 1;
+        return 0;
+    }
+
+    char *end;
+    long t = strtol(arg, &end, 10);
+
+    if (*end != '\0' || t < 0 || t >= ROV_THRUSTER_COUNT) {
+        shell_error(sh, "Thruster must be 0..%d or all", ROV_THRUSTER_COUNT - 1);
+        return -EINVAL;
+    }
+    *first = *last = (int)t;
+    return 0;
+}
+
+static int cmd_comp_show(const struct shell *sh, size_t argc, char **argv)
+{
+    int first = 0;
+    int last = ROV_THRUSTER_COUNT - 1;
+    float table[COMP_TABLE_POINTS];
+
+    if (argc > 1 && comp_parse_thruster(sh, argv[1], &first, &last) != 0) {
+        return -EINVAL;
+    }
+
+    for (int t = first; t <= last; t++) {
+        for (int d = 0; d < COMP_DIRECTION_COUNT; d++) {
+            comp_get_table(t, d, table);
+            shell_print(sh, "thr%d %s: deadband %.3f  25%% %.3f  50%% %.3f  75%% %.3f  full %.3f",
+                        t, direction_names[d], (double)table[0],
+                        (double)table[COMP_SEGMENTS / 4], (double)table[COMP_SEGMENTS / 2],
+                        (double)table[3 * COMP_SEGMENTS / 4], (double)table[COMP_SEGMENTS]);
+        }
+    }
+    return 0;
+}
+
+static int cmd_comp_set(const struct shell *sh, size_t argc, char **argv)
+{
+    float table[COMP_TABLE_POINTS];
+    int first;
+    int last;
+    int dir = comp_direction_from_name(argv[2], strlen(argv[2]));
+
+    if (comp_parse_thruster(sh, argv[1], &first, &last) != 0) {
+        return -EINVAL;
+    }
+    if (dir < 0) {
+        shell_error(sh, "Direction must be fwd or rev");
+        return -EINVAL;
+    }
+    if (argc != 3 + COMP_TABLE_POINTS) {
+        shell_error(sh, "Expected %d table values", COMP_TABLE_POINTS);
+        return -EINVAL;
+    }
+    for (int i = 0; i < COMP_TABLE_POINTS; i++) {
+        table[i] = strtof(argv[3 + i], NULL);
+    }
+
+    for (int t = first; t <= last; t++) {
+        if (comp_set_table(t, dir, table) != 0) {
+            shell_error(sh, "Table must be non-decreasing and within 0..1");
+            return -EINVAL;
+        }
+    }
+    return 0;
+}
+
+static int cmd_comp_save(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    int ret = comp_save();
+
+    if (ret < 0) {
+        shell_error(sh, "Failed to save compensation tables: %d", ret);
+        return ret;
+    }
+    shell_print(sh, "Compensation tables saved");
+    return 0;
+}
+
+static int cmd_comp_reset(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    comp_reset();
+    shell_print(sh, "Compensation disabled (identity tables), saved tables unchanged");
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(comp_cmds,
+    SHELL_CMD_ARG(show, NULL, "[thruster|all] Show compensation tables", cmd_comp_show, 1, 1),
+    SHELL_CMD_ARG(set, NULL, "<thruster|all> <fwd|rev> <17 values> Load a table",
+                  cmd_comp_set, 3, COMP_TABLE_POINTS),
+    SHELL_CMD(save, NULL, "Persist tables to settings", cmd_comp_save),
+    SHELL_CMD(reset, NULL, "Identity tables (saved tables unchanged)", cmd_comp_reset),
+    SHELL_SUBCMD_SET_END
+);
+
+SHELL_SUBCMD_ADD((rov), comp, &comp_cmds, "Thruster force compensation", NULL, 1, 0);
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <zephyr/kernel.h>
+#include <stdint.h>
+
+#include "control.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Per-thruster force linearization. Each thruster has a forward and a
+ * reverse table mapping normalized force magnitude (evenly spaced, 0..1)
+ * to command magnitude (0..1). Entry 0 is the deadband edge: the smallest
+ * command that produces thrust. Zero force always maps to zero command.
+ */
+#define COMP_TABLE_POINTS 17
+
+enum comp_direction {
+    COMP_FORWARD = 0,
+    COMP_REVERSE,
+    COMP_DIRECTION_COUNT
+};
+
+void comp_init(void);
+
+// Control tick: force -> command for the whole thruster frame, in place
+void comp_apply(float thrust[ROV_THRUSTER_COUNT]);
+
+// Tables take effect on the next tick; comp_save() persists them to settings
+int comp_set_table(int thruster, enum comp_direction dir, const float table[COMP_TABLE_POINTS]);
+void comp_get_table(int thruster, enum comp_direction dir, float table[COMP_TABLE_POINTS]);
+void comp_reset(void);
+int comp_save(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,106 +1,345 @@
 #include <zephyr/kernel.h>
 #include <zephyr/logging/log.h>
-#include <zephyr/drivers/gpio.h>
+#include <zephyr/sys/barrier.h>
+#include <string.h>
 
 #include "control.h"
 #include "led.h"
+#include "setpoint.h"
+#include "filter.h"
+#include "hold.h"
+#include "ahrs.h"
+#include "cycles.h"
+#include "wcet.h"
+#include "cmdlog.h"
+#include "latency.h"
+#include "actuator.h"
+#include "light.h"
+#include "manipulator.h"
+#include "power.h"
+#include "compensation.h"
+#include "hotpath.h"
+#include "trace.h"
+#include "sensors.h"
+#if defined(CONFIG_ARCH_POSIX)
+#include "sim.h"
+#endif
 
 LOG_MODULE_DECLARE(k2_app);
 
 // Thread stack and data
-K_THREAD_STACK_DEFINE(rov_control_stack, 2048);
+ROV_HOT_STACK_DEFINE(rov_control_stack, 2048);
 static struct k_thread rov_control_thread_data;
 
-// Message queue for receiving commands from network thread
-K_MSGQ_DEFINE(rov_command_queue, sizeof(rov_command_t), 10, 4);
+// Message queue for receiving commands from network thread (buffer with the hot data)
+static char __aligned(4) ROV_HOT_BSS rov_command_buffer[ROV_COMMAND_QUEUE_DEPTH * sizeof(rov_command_t)];
+static struct k_msgq rov_command_queue;
+
+// Periodic timer that paces the control loop
+K_TIMER_DEFINE(rov_control_timer, NULL, NULL);
+
+// Newest command taken by the control thread, for telemetry (sequence lock,
+// so readers never hold up the control thread)
+static rov_command_t last_command;
+static atomic_t last_command_seq;
+
+// Commands lost because the queue was full, and the deepest queue seen
+// (both written by the UDP thread only)
+static atomic_t command_drops;
+static atomic_t queue_high_water;
+
+// Completed control ticks since boot (health supervisor liveness check)
+static atomic_t control_ticks;
+
+static const char *const axis_names[ROV_AXIS_COUNT] = {
+    "surge", "sway", "heave", "roll", "pitch", "yaw"
+};
 
 /**
- * 6DOF ROV control function - perfect for matrix calculations
- * @param surge: Forward/backward movement (-128 to +127)
- * @param sway: Left/right movement (-128 to +127) 
- * @param heave: Up/down movement (-128 to +127)
- * @param roll: Roll rotation (-128 to +127)
- * @param pitch: Pitch rotation (-128 to +127)
- * @param yaw: Yaw rotation (-128 to +127)
- */
-void rov_6dof_control(int8_t surge, int8_t sway, int8_t heave, 
-                     int8_t roll, int8_t pitch, int8_t yaw)
+ * Get the name of an axis
+ * @param axis: Axis index (enum rov_axis)
+ * @return: Axis name, or "?" if out of range
+ */
+const char *rov_axis_name(int axis)
 {
-    LOG_INF("=== 6DOF CONTROL ===");
-    LOG_INF("Surge: %+4d", surge);   // Forward/Back
-    LOG_INF("Sway:  %+4d", sway);    // Left/Right
-    LOG_INF("Heave: %+4d", heave);   // Up/Down
-    LOG_INF("Roll:  %+4d", roll);    // Roll rotation
-    LOG_INF("Pitch: %+4d", pitch);   // Pitch rotation
-    LOG_INF("Yaw:   %+4d", yaw);     // Yaw rotation
-    
-    // TODO: Apply your matrix calculations here
-    // Example: thruster_output = thruster_matrix * [surge, sway, heave, roll, pitch, yaw]
-    
-    LOG_INF("==================");
+    if (axis < 0 || axis >= ROV_AXIS_COUNT) {
+        return "?";
+    }
+    return axis_names[axis];
+}
+
+/**
+ * Look up an axis by name
+ * @param name: Axis name (surge, sway, heave, roll, pitch, yaw)
+ * @return: Axis index, or -1 if unknown
+ */
+int rov_axis_from_name(const char *name)
+{
+    for (int i = 0; i < ROV_AXIS_COUNT; i++) {
+        if (strcmp(name, axis_names[i]) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/*
+ * Thruster allocation matrix (vectored frame).
+ * Thrusters 0-3 are horizontal (front-right, front-left, rear-right, rear-left),
+ * thrusters 4-7 are vertical in the same order.
+ */
+static const float ROV_HOT_RODATA thruster_matrix[ROV_THRUSTER_COUNT][ROV_AXIS_COUNT] = {
+    //  surge   sway  heave   roll  pitch    yaw
+    {  1.0f, -1.0f,  0.0f,  0.0f,  0.0f, -1.0f },
+    {  1.0f,  1.0f,  0.0f,  0.0f,  0.0f,  1.0f },
+    {  1.0f,  1.0f,  0.0f,  0.0f,  0.0f, -1.0f },
+    {  1.0f, -1.0f,  0.0f,  0.0f,  0.0f,  1.0f },
+    {  0.0f,  0.0f,  1.0f, -1.0f,  1.0f,  0.0f },
+    {  0.0f,  0.0f,  1.0f,  1.0f,  1.0f,  0.0f },
+    {  0.0f,  0.0f,  1.0f, -1.0f, -1.0f,  0.0f },
+    {  0.0f,  0.0f,  1.0f,  1.0f, -1.0f,  0.0f },
+};
+
+// Depth samples older than this no longer close the depth hold loop
+#define ROV_DEPTH_TIMEOUT_US 100000
+
+// Last manipulator command, to plan a new trajectory only on change
+static uint8_t manipulator_command;
+
+/**
+ * 6DOF ROV control function - thruster allocation
+ * Runs once per control tick with interpolated setpoints.
+ * @param axes: Normalized surge, sway, heave, roll, pitch, yaw (-1.0 to +1.0)
+ * @param thrust: Normalized thruster outputs (-1.0 to +1.0)
+ */
+ROV_HOT_CODE void rov_6dof_control(const float axes[ROV_AXIS_COUNT], float thrust[ROV_THRUSTER_COUNT])
+{
+    float peak = 1.0f;
+
+    for (int t = 0; t < ROV_THRUSTER_COUNT; t++) {
+        float sum = 0.0f;
+
+        for (int a = 0; a < ROV_AXIS_COUNT; a++) {
+            sum += thruster_matrix[t][a] * axes[a];
+        }
+        thrust[t] = sum;
+
+        float mag = sum < 0.0f ? -sum : sum;
+        if (mag > peak) {
+            peak = mag;
+        }
+    }
+
+    // Scale down uniformly so saturation keeps the commanded direction
+    if (peak > 1.0f) {
+        float scale = 1.0f / peak;
+
+        for (int t = 0; t < ROV_THRUSTER_COUNT; t++) {
+            thrust[t] *= scale;
+        }
+    }
 }
 
 /**
- * Control light brightness
+ * Control light brightness (0 turns the light off)
+ * The fade runs in the light engine, outside the control tick.
  */
 static void rov_set_light(uint8_t brightness)
 {
-    if (brightness > 0) {
+    if (light_set(brightness) && cmdlog_verbose()) {
         LOG_INF("Light: %d%% (%d/255)", (brightness * 100) / 255, brightness);
-        // TODO: Control light PWM
     }
 }
 
 /**
  * Control manipulator position
+ * The servo follows a velocity/acceleration limited trajectory to the target.
  */
 static void rov_set_manipulator(uint8_t position)
 {
-    if (position > 0) {
-        LOG_INF("Manipulator: %d", position);
-        // TODO: Control manipulator servo
+    if (position != manipulator_command) {
+        if (cmdlog_verbose()) {
+            LOG_INF("Manipulator: %d", position);
+        }
+        manipulator_command = position;
+        manipulator_set_target(position / 255.0f);
+    }
+}
+
+/**
+ * Consume the sensor samples that arrived since the last tick, in place:
+ * every IMU sample goes through the AHRS, the newest depth sample is kept
+ * @param feedback: Hold feedback, depth fields updated
+ * @param depth_timestamp_us: Timestamp of the newest depth sample (in/out)
+ */
+static ROV_HOT_CODE void rov_read_sensors(hold_feedback_t *feedback, uint32_t *depth_timestamp_us)
+{
+    const sensor_imu_sample_t *imu;
+    const sensor_depth_sample_t *depth;
+
+    while ((imu = sensors_peek(SENSOR_IMU, SENSOR_CONSUMER_CONTROL)) != NULL) {
+        ahrs_feed(&imu->imu);
+        sensors_release(SENSOR_IMU, SENSOR_CONSUMER_CONTROL);
+    }
+
+    while ((depth = sensors_peek(SENSOR_DEPTH, SENSOR_CONSUMER_CONTROL)) != NULL) {
+        feedback->depth_m = depth->depth_m;
+        *depth_timestamp_us = depth->timestamp_us;
+        feedback->depth_valid = true;
+        sensors_release(SENSOR_DEPTH, SENSOR_CONSUMER_CONTROL);
+    }
+
+    if (feedback->depth_valid &&
+        setpoint_now_us() - *depth_timestamp_us > ROV_DEPTH_TIMEOUT_US) {
+        feedback->depth_valid = false;
     }
 }
 
 /**
- * ROV control thread - processes incoming commands from queue
+ * ROV control thread - runs the control loop at ROV_CONTROL_RATE_HZ
+ * Commands from the queue are folded into the setpoint interpolator,
+ * and every tick evaluates the interpolated setpoint.
  */
-static void rov_control_thread(void *arg1, void *arg2, void *arg3)
+static ROV_HOT_CODE void rov_control_thread(void *arg1, void *arg2, void *arg3)
 {
     ARG_UNUSED(arg1);
     ARG_UNUSED(arg2);
     ARG_UNUSED(arg3);
     
     rov_command_t command;
+    float axes[ROV_AXIS_COUNT];
+    actuator_frame_t frame = { 0 };
+    bool in_failsafe = false;
+    hold_feedback_t feedback = { 0 };
+    ahrs_snapshot_t attitude;
+    uint32_t depth_timestamp_us = 0;
     
     LOG_INF("ROV Control thread started");
     LOG_INF("Waiting for 6DOF commands...");
     
+    k_timer_start(&rov_control_timer, K_USEC(ROV_CONTROL_PERIOD_US),
+                  K_USEC(ROV_CONTROL_PERIOD_US));
+    actuator_start();
+    
     while (1) {
-        // Wait for a command from the network thread
-        if (k_msgq_get(&rov_command_queue, &command, K_FOREVER) == 0) {
+        // Wait for the next control tick
+        k_timer_status_sync(&rov_control_timer);
+        
+        uint32_t tick_start = rov_cycles_now();
+        uint32_t log_cycles = 0;
+        uint32_t output_cycles = 0;
+        uint32_t stage_start;
+        
+        // Commands consumed by this tick, timed to output when it is committed
+        frame.command_count = 0;
+        
+        // Drain every command that arrived since the previous tick
+        while (k_msgq_get(&rov_command_queue, &command, K_NO_WAIT) == 0) {
+            uint32_t dequeue_cycles = rov_cycles_now();
             
-            LOG_INF("Processing ROV command #%u", command.sequence);
+            ROV_TRACE_DEQUEUED(command.sequence, k_msgq_num_used_get(&rov_command_queue));
+            latency_record(LATENCY_DECODE, command.queued_cycles - command.rx_cycles);
+            latency_record(LATENCY_QUEUE, dequeue_cycles - command.queued_cycles);
             
-            // Call 6DOF function with parsed values
-            rov_6dof_control(command.surge, command.sway, command.heave,
-                           command.roll, command.pitch, command.yaw);
+            // One compact record (or none) per command, see cmdlog.h
+            stage_start = rov_cycles_now();
+            cmdlog_log_command(&command);
+            log_cycles += rov_cycles_now() - stage_start;
             
-            // Handle auxiliary controls
-            if (command.light > 0) {
-                rov_set_light(command.light);
-            }
+            atomic_inc(&last_command_seq);
+            barrier_dmem_fence_full();
+            last_command = command;
+            barrier_dmem_fence_full();
+            atomic_inc(&last_command_seq);
             
-            if (command.manipulator > 0) {
-                rov_set_manipulator(command.manipulator);
+            axes[ROV_AXIS_SURGE] = command.surge / 128.0f;
+            axes[ROV_AXIS_SWAY] = command.sway / 128.0f;
+            axes[ROV_AXIS_HEAVE] = command.heave / 128.0f;
+            axes[ROV_AXIS_ROLL] = command.roll / 128.0f;
+            axes[ROV_AXIS_PITCH] = command.pitch / 128.0f;
+            axes[ROV_AXIS_YAW] = command.yaw / 128.0f;
+            setpoint_push(axes, command.timestamp_us);
+            frame.sequence = command.sequence;
+            frame.command_timestamp_us = command.timestamp_us;
+            if (frame.command_count < ROV_COMMAND_QUEUE_DEPTH) {
+                actuator_command_stamp_t *stamp = &frame.commands[frame.command_count++];
+                
+                stamp->sequence = command.sequence;
+                stamp->rx_cycles = command.rx_cycles;
+                stamp->dequeue_cycles = dequeue_cycles;
             }
             
-            // Visual feedback
-            gpio_pin_toggle_dt(&led);
+            stage_start = rov_cycles_now();
             
-            // Small delay to prevent overwhelming the system
-            k_sleep(K_MSEC(10));
+            // Handle auxiliary controls
+            rov_set_light(command.light);
+            rov_set_manipulator(command.manipulator);
+            
+            // Visual feedback (pattern engine picks this up, no driver call here)
+            led_status_event(LED_EVENT_COMMAND);
+            output_cycles += rov_cycles_now() - stage_start;
+        }
+        
+        stage_start = rov_cycles_now();
+        wcet_record(WCET_STAGE_DEQUEUE, stage_start - tick_start - log_cycles - output_cycles);
+        wcet_record(WCET_STAGE_LOGGING, log_cycles);
+        
+        // Interpolated setpoint for this tick (neutral if the link went stale)
+        bool fresh = setpoint_sample(setpoint_now_us(), axes);
+        bool failsafe = !fresh && frame.sequence != 0;
+        if (failsafe != in_failsafe) {
+            in_failsafe = failsafe;
+            led_status_set(LED_STATUS_FAILSAFE, failsafe);
         }
+        
+        // Input shaping: expo, slew-rate limit and low-pass on all axes
+        filter_bank_process(axes);
+        
+        uint32_t now = rov_cycles_now();
+        wcet_record(WCET_STAGE_FILTERS, now - stage_start);
+        stage_start = now;
+        
+        // Closed-loop depth/heading hold replaces heave/yaw when engaged
+        rov_read_sensors(&feedback, &depth_timestamp_us);
+        ahrs_get_snapshot(&attitude);
+        feedback.heading_deg = attitude.heading_deg;
+        feedback.heading_valid = attitude.updates > 0;
+        hold_update(axes, &feedback);
+        
+        now = rov_cycles_now();
+        wcet_record(WCET_STAGE_HOLD, now - stage_start);
+        stage_start = now;
+        
+        rov_6dof_control(axes, frame.thrust);
+        
+        now = rov_cycles_now();
+        wcet_record(WCET_STAGE_MIXER, now - stage_start);
+        stage_start = now;
+        
+        // Keep the estimated total thruster current under the tether budget,
+        // then linearize force to thruster command (deadband, quadratic response)
+        power_limit(frame.thrust);
+        comp_apply(frame.thrust);
+        
+        now = rov_cycles_now();
+        wcet_record(WCET_STAGE_POWER, now - stage_start);
+        stage_start = now;
+        
+        // Publish this tick's outputs; the commit timer writes them at a fixed phase
+        frame.light = light_get_output();
+        frame.manipulator = manipulator_step();
+        frame.tick_cycles = tick_start;
+        actuator_publish(&frame);
+        
+        now = rov_cycles_now();
+        wcet_record(WCET_STAGE_OUTPUT, output_cycles + (now - stage_start));
+        wcet_tick_end(now - tick_start);
+        atomic_inc(&control_ticks);
+        
+#if defined(CONFIG_ARCH_POSIX)
+        // Advance the emulated vehicle with this tick's command
+        sim_step(axes);
+#endif
     }
 }
 
@@ -110,13 +349,28 @@ static void rov_control_thread(void *arg1, void *arg2, void *arg3)
 void rov_control_init(void)
 {
     LOG_INF("Initializing ROV 6DOF control system...");
-    LOG_INF("Command queue capacity: 10 commands");
+    LOG_INF("Command queue capacity: %d commands", ROV_COMMAND_QUEUE_DEPTH);
+    LOG_INF("Control loop rate: %d Hz", ROV_CONTROL_RATE_HZ);
     
-    // TODO: Initialize hardware components here
-    // Examples:
-    // - PWM controllers for thrusters
-    // - Servo controllers for manipulator
-    // - LED PWM for lights
+    k_msgq_init(&rov_command_queue, rov_command_buffer, sizeof(rov_command_t),
+                ROV_COMMAND_QUEUE_DEPTH);
+    rov_cycles_init();
+    wcet_init();
+    setpoint_init();
+    filter_bank_init();
+    ahrs_init();
+    hold_init();
+    light_init();
+    manipulator_init();
+    power_init();
+    comp_init();
+#if defined(CONFIG_ARCH_POSIX)
+    sim_init();
+#endif
+    
+    if (actuator_init() < 0) {
+        LOG_ERR("Actuator outputs unavailable");
+    }
     
     LOG_INF("ROV control system initialized");
 }
@@ -133,11 +387,12 @@ void rov_control_start(void)
                                K_THREAD_STACK_SIZEOF(rov_control_stack),
                                rov_control_thread,
                                NULL, NULL, NULL,
-                               K_PRIO_COOP(8),  // Lower priority than network
+                               K_PRIO_PREEMPT(2),  // Lower priority than network
                                0,
                                K_NO_WAIT);
     
     if (thread_id != NULL) {
+        k_thread_name_set(thread_id, "rov_control");
         LOG_INF("ROV 6DOF control thread started successfully");
     } else {
         LOG_ERR("Failed to start ROV control thread");
@@ -148,13 +403,15 @@ void rov_control_start(void)
  * Send a command to the ROV control thread
  * @param sequence: Command sequence number
  * @param payload: 64-bit payload containing control data
+ * @param rx_cycles: Cycle counter when the packet was received
  */
-void rov_send_command(uint32_t sequence, uint64_t payload)
+ROV_HOT_CODE void rov_send_command(uint32_t sequence, uint64_t payload, uint32_t rx_cycles)
 {
     rov_command_t command;
     
     // Parse the payload and convert to signed ranges
     command.sequence = sequence;
+    command.timestamp_us = setpoint_now_us();
     command.surge = (int8_t)((payload >> 0) & 0xFF) - 128;   // Bits 0-7
     command.sway = (int8_t)((payload >> 8) & 0xFF) - 128;    // Bits 8-15
     command.heave = (int8_t)((payload >> 16) & 0xFF) - 128;  // Bits 16-23
@@ -163,11 +420,78 @@ void rov_send_command(uint32_t sequence, uint64_t payload)
     command.yaw = (int8_t)((payload >> 40) & 0xFF) - 128;    // Bits 40-47
     command.light = (uint8_t)((payload >> 48) & 0xFF);       // Bits 48-55
     command.manipulator = (uint8_t)((payload >> 56) & 0xFF); // Bits 56-63
+    command.rx_cycles = rx_cycles;
+    command.queued_cycles = rov_cycles_now();
     
     // Send command to ROV control thread
     if (k_msgq_put(&rov_command_queue, &command, K_NO_WAIT) != 0) {
+        ROV_TRACE_DROPPED(sequence);
+        atomic_inc(&command_drops);
+        atomic_set(&queue_high_water, ROV_COMMAND_QUEUE_DEPTH);
         LOG_WRN("ROV command queue full! Command #%u dropped", sequence);
     } else {
+        uint32_t depth = k_msgq_num_used_get(&rov_command_queue);
+
+        ROV_TRACE_QUEUED(sequence, depth);
+        if (depth > (uint32_t)atomic_get(&queue_high_water)) {
+            atomic_set(&queue_high_water, (atomic_val_t)depth);
+        }
         LOG_DBG("6DOF command #%u queued", sequence);
     }
-}
\ No newline at end of file
+}
+
+/**
+ * Get the newest command taken by the control thread
+ * @param command: Output, all zero (sequence 0) before the first command
+ */
+void rov_get_last_command(rov_command_t *command)
+{
+    atomic_val_t start, end;
+
+    do {
+        start = atomic_get(&last_command_seq);
+        barrier_dmem_fence_full();
+        *command = last_command;
+        barrier_dmem_fence_full();
+        end = atomic_get(&last_command_seq);
+    } while ((start & 1) || start != end);
+}
+
+/**
+ * Number of commands dropped because the command queue was full
+ * @return: Drop count since boot
+ */
+uint32_t rov_command_drops(void)
+{
+    return (uint32_t)atomic_get(&command_drops);
+}
+
+/**
+ * Get the number of completed control ticks
+ * @return: Ticks since boot; stops advancing if the control thread stalls
+ */
+uint32_t rov_control_ticks(void)
+{
+    return (uint32_t)atomic_get(&control_ticks);
+}
+
+/**
+ * Get command queue occupancy
+ * @param stats: Output
+ */
+void rov_get_queue_stats(rov_queue_stats_t *stats)
+{
+    stats->depth = k_msgq_num_used_get(&rov_command_queue);
+    stats->capacity = ROV_COMMAND_QUEUE_DEPTH;
+    stats->high_water = (uint32_t)atomic_get(&queue_high_water);
+    stats->drops = (uint32_t)atomic_get(&command_drops);
+}
+
+/**
+ * Clear the queue high-water mark and drop count
+ */
+void rov_reset_queue_stats(void)
+{
+    atomic_clear(&queue_high_water);
+    atomic_clear(&command_drops);
+}
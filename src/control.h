@@ -18,16 +18,56 @@ typedef struct {
     int8_t yaw;          // Yaw rotation (-128 to +127)
     uint8_t light;       // Light brightness (0-255)
     uint8_t manipulator; // Manipulator position (0-255)
+    uint32_t timestamp_us; // Time the command was received (setpoint timebase)
+    uint32_t rx_cycles;    // Cycle counter when zsock_recvfrom() returned (latency.h)
+    uint32_t queued_cycles; // Cycle counter at k_msgq_put
 } rov_command_t;
 
+// Axis indices into a normalized setpoint vector (-1.0 to +1.0)
+enum rov_axis {
+    ROV_AXIS_SURGE = 0,
+    ROV_AXIS_SWAY,
+    ROV_AXIS_HEAVE,
+    ROV_AXIS_ROLL,
+    ROV_AXIS_PITCH,
+    ROV_AXIS_YAW,
+    ROV_AXIS_COUNT
+};
+
+// Number of thrusters driven by the 6DOF mixer
+#define ROV_THRUSTER_COUNT 8
+
+// Control loop rate (setpoints are interpolated between network updates)
+#define ROV_CONTROL_RATE_HZ 400
+#define ROV_CONTROL_PERIOD_US (1000000 / ROV_CONTROL_RATE_HZ)
+
+// Command queue (UDP thread -> control thread)
+#define ROV_COMMAND_QUEUE_DEPTH 10
+
+// Command queue occupancy
+typedef struct {
+    uint32_t depth;        // Commands waiting now
+    uint32_t capacity;
+    uint32_t high_water;   // Deepest since the last reset
+    uint32_t drops;        // Lost to a full queue since the last reset
+} rov_queue_stats_t;
+
 // Public functions
 void rov_control_init(void);
 void rov_control_start(void);
-void rov_send_command(uint32_t sequence, uint64_t payload);
+void rov_send_command(uint32_t sequence, uint64_t payload, uint32_t rx_cycles);
+void rov_get_last_command(rov_command_t *command);
+uint32_t rov_command_drops(void);
+uint32_t rov_control_ticks(void);
+void rov_get_queue_stats(rov_queue_stats_t *stats);
+void rov_reset_queue_stats(void);
+
+// Axis name helpers (surge, sway, heave, roll, pitch, yaw)
+const char *rov_axis_name(int axis);
+int rov_axis_from_name(const char *name);
 
-// 6DOF control function
-void rov_6dof_control(int8_t surge, int8_t sway, int8_t heave, 
-                     int8_t roll, int8_t pitch, int8_t yaw);
+// 6DOF control function, called once per control tick
+void rov_6dof_control(const float axes[ROV_AXIS_COUNT], float thrust[ROV_THRUSTER_COUNT]);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,369 @@
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/shell/shell.h>
+#include <string.h>
+
+#include "cpuload.h"
+#include "cycles.h"
+
+LOG_MODULE_DECLARE(k2_app);
+
+#define CPULOAD_SAMPLES_PER_SEC (1000 / CPULOAD_SAMPLE_MS)
+
+// Ring of cumulative cycle counts, one entry more than the longest window.
+// Entries are truncated to 32 bits: differences stay exact as long as the
+// longest window is shorter than the counter wrap (about 19 s at 216 MHz).
+#define CPULOAD_HISTORY (10 * CPULOAD_SAMPLES_PER_SEC + 1)
+
+BUILD_ASSERT(1000 % CPULOAD_SAMPLE_MS == 0, "Sample period must divide one second");
+BUILD_ASSERT(CPULOAD_HISTORY <= UINT8_MAX, "History index does not fit");
+
+static const uint8_t window_samples[CPULOAD_WINDOW_COUNT] = {
+    CPULOAD_SAMPLES_PER_SEC, 10 * CPULOAD_SAMPLES_PER_SEC
+};
+
+static const char *const window_names[CPULOAD_WINDOW_COUNT] = { "1s", "10s" };
+
+static const char *const group_names[CPULOAD_GROUP_COUNT] = {
+    "udp", "control", "net", "log", "sensors", "telemetry", "other", "idle"
+};
+
+// Thread name prefixes of each group; anything else is "other"
+static const struct {
+    const char *prefix;
+    cpuload_group_t group;
+} group_prefixes[] = {
+    { "udp_server", CPULOAD_GROUP_UDP },
+    { "rov_control", CPULOAD_GROUP_CONTROL },
+    { "actuator", CPULOAD_GROUP_CONTROL },  // CAN commit thread
+    { "rx_q", CPULOAD_GROUP_NET },
+    { "tx_q", CPULOAD_GROUP_NET },
+    { "net_", CPULOAD_GROUP_NET },
+    { "eth", CPULOAD_GROUP_NET },
+    { "stm_eth", CPULOAD_GROUP_NET },
+    { "logging", CPULOAD_GROUP_LOG },
+    { "telemetry", CPULOAD_GROUP_TELEMETRY },
+    { "imu", CPULOAD_GROUP_SENSORS },        // Sensor sources, see sensors.c
+    { "depth", CPULOAD_GROUP_SENSORS },
+    { "leak", CPULOAD_GROUP_SENSORS },
+    { "voltage", CPULOAD_GROUP_SENSORS },
+    { "idle", CPULOAD_GROUP_IDLE },
+};
+
+struct cpuload_slot {
+    const struct k_thread *thread;      // NULL when free
+    bool seen;                          // Still alive in this sample
+    uint8_t group;
+    uint8_t samples;                    // Valid history entries
+    char name[16];
+    uint32_t history[CPULOAD_HISTORY];  // Cumulative execution cycles
+};
+
+// Sampler state, telemetry thread only
+static struct cpuload_slot slots[CPULOAD_MAX_THREADS];
+static uint32_t total_history[CPULOAD_HISTORY];    // All threads, idle included
+static uint32_t idle_history[CPULOAD_HISTORY];
+static uint8_t total_samples;
+static uint8_t head;                               // Newest history entry
+static bool truncated;
+static cpuload_report_t report;
+
+// Published copy for everyone else
+static cpuload_report_t published;
+static struct k_spinlock report_lock;
+static atomic_t reset_requested;
+
+/**
+ * Name and group of a thread; retried while the thread has no name yet
+ */
+static void cpuload_name_slot(struct cpuload_slot *slot, const struct k_thread *thread)
+{
+    const char *name = k_thread_name_get((k_tid_t)thread);
+
+    slot->group = CPULOAD_GROUP_OTHER;
+    if (name == NULL || name[0] == '\0') {
+        slot->name[0] = '\0';
+        return;
+    }
+    strncpy(slot->name, name, sizeof(slot->name) - 1);
+    slot->name[sizeof(slot->name) - 1] = '\0';
+    for (size_t i = 0; i < ARRAY_SIZE(group_prefixes); i++) {
+        if (strncmp(name, group_prefixes[i].prefix, strlen(group_prefixes[i].prefix)) == 0) {
+            slot->group = group_prefixes[i].group;
+            break;
+        }
+    }
+}
+
+static void cpuload_collect(const struct k_thread *thread, void *user_data)
+{
+    ARG_UNUSED(user_data);
+
+    struct cpuload_slot *slot = NULL;
+    struct cpuload_slot *free_slot = NULL;
+    k_thread_runtime_stats_t rt;
+
+    for (int i = 0; i < CPULOAD_MAX_THREADS; i++) {
+        if (slots[i].thread == thread) {
+            slot = &slots[i];
+            break;
+        }
+        if (slots[i].thread == NULL && free_slot == NULL) {
+            free_slot = &slots[i];
+        }
+    }
+    if (slot == NULL) {
+        if (free_slot == NULL) {
+            truncated = true;
+            return;
+        }
+        slot = free_slot;
+        slot->thread = thread;
+        slot->samples = 0;
+        slot->name[0] = '\0';
+    }
+    if (slot->name[0] == '\0') {
+        cpuload_name_slot(slot, thread);
+    }
+
+    slot->seen = true;
+    if (k_thread_runtime_stats_get((k_tid_t)thread, &rt) != 0) {
+        return;
+    }
+    slot->history[head] = (uint32_t)rt.execution_cycles;
+    slot->samples = MIN(slot->samples + 1, CPULOAD_HISTORY);
+}
+
+/**
+ * Cycles accumulated over a window, or over the history available so far
+ * @param history: Ring of cumulative counts
+ * @param samples: Valid entries in the ring
+ * @param window: Window to cover
+ */
+static uint32_t cpuload_delta(const uint32_t *history, uint8_t samples, int window)
+{
+    if (samples < 2) {
+        return 0;
+    }
+
+    uint8_t span = MIN(window_samples[window], samples - 1);
+    uint8_t oldest = (head + CPULOAD_HISTORY - span) % CPULOAD_HISTORY;
+
+    return history[head] - history[oldest];
+}
+
+static uint16_t cpuload_share(uint64_t cycles, uint32_t total)
+{
+    return total > 0 ? (uint16_t)MIN(cycles * 10000U / total, 10000U) : 0;
+}
+
+/**
+ * Take one sample of every thread's execution time and publish the loads
+ * Telemetry thread only, every CPULOAD_SAMPLE_MS.
+ */
+void cpuload_sample(void)
+{
+#if defined(CONFIG_SCHED_THREAD_USAGE_ALL)
+    uint32_t start = rov_cycles_now();
+    cpuload_summary_t *s = &report.summary;
+    k_thread_runtime_stats_t all;
+    uint32_t total[CPULOAD_WINDOW_COUNT];
+    uint64_t group_cycles[CPULOAD_GROUP_COUNT][CPULOAD_WINDOW_COUNT] = { 0 };
+
+    if (k_thread_runtime_stats_all_get(&all) != 0) {
+        return;
+    }
+    if (atomic_clear(&reset_requested)) {
+        s->peak = 0;
+        report.sample_max_cycles = 0;
+    }
+
+    head = (head + 1) % CPULOAD_HISTORY;
+    total_history[head] = (uint32_t)all.execution_cycles;
+    idle_history[head] = (uint32_t)all.idle_cycles;
+    total_samples = MIN(total_samples + 1, CPULOAD_HISTORY);
+
+    for (int i = 0; i < CPULOAD_MAX_THREADS; i++) {
+        slots[i].seen = false;
+    }
+    truncated = false;
+    k_thread_foreach_unlocked(cpuload_collect, NULL);
+
+    for (int w = 0; w < CPULOAD_WINDOW_COUNT; w++) {
+        uint32_t idle = cpuload_delta(idle_history, total_samples, w);
+
+        total[w] = cpuload_delta(total_history, total_samples, w);
+        s->total[w] = cpuload_share(total[w] - MIN(idle, total[w]), total[w]);
+    }
+    if (total_samples > window_samples[CPULOAD_WINDOW_1S]) {
+        s->peak = MAX(s->peak, s->total[CPULOAD_WINDOW_1S]);
+    }
+
+    report.thread_count = 0;
+    for (int i = 0; i < CPULOAD_MAX_THREADS; i++) {
+        struct cpuload_slot *slot = &slots[i];
+
+        if (slot->thread == NULL) {
+            continue;
+        }
+        if (!slot->seen) {
+            slot->thread = NULL;    // Exited
+            continue;
+        }
+
+        cpuload_thread_t *t = &report.threads[report.thread_count++];
+
+        memcpy(t->name, slot->name, sizeof(t->name));
+        t->group = slot->group;
+        for (int w = 0; w < CPULOAD_WINDOW_COUNT; w++) {
+            uint32_t cycles = cpuload_delta(slot->history, slot->samples, w);
+
+            t->load[w] = cpuload_share(cycles, total[w]);
+            group_cycles[slot->group][w] += cycles;
+        }
+    }
+    for (int g = 0; g < CPULOAD_GROUP_COUNT; g++) {
+        for (int w = 0; w < CPULOAD_WINDOW_COUNT; w++) {
+            s->group[g][w] = cpuload_share(group_cycles[g][w], total[w]);
+        }
+    }
+    report.truncated = truncated;
+    report.timestamp_ms = k_uptime_get_32();
+    report.sample_cycles = rov_cycles_now() - start;
+    report.sample_max_cycles = MAX(report.sample_max_cycles, report.sample_cycles);
+
+    k_spinlock_key_t key = k_spin_lock(&report_lock);
+    published = report;
+    k_spin_unlock(&report_lock, key);
+#endif
+}
+
+void cpuload_get_report(cpuload_report_t *out)
+{
+    k_spinlock_key_t key = k_spin_lock(&report_lock);
+    *out = published;
+    k_spin_unlock(&report_lock, key);
+}
+
+void cpuload_get_summary(cpuload_summary_t *summary)
+{
+    k_spinlock_key_t key = k_spin_lock(&report_lock);
+    *summary = published.summary;
+    k_spin_unlock(&report_lock, key);
+}
+
+/**
+ * Share of the CPU not spent idle
+ * @param window: Sliding window
+ * @return: Load in 0.01 %
+ */
+uint16_t cpuload_total(cpuload_window_t window)
+{
+    k_spinlock_key_t key = k_spin_lock(&report_lock);
+    uint16_t load = published.summary.total[window];
+    k_spin_unlock(&report_lock, key);
+
+    return load;
+}
+
+/**
+ * Clear the peak load and the sampler's worst cost (applied by the next sample)
+ */
+void cpuload_reset(void)
+{
+    atomic_set(&reset_requested, 1);
+}
+
+const char *cpuload_group_name(int group)
+{
+    return (group >= 0 && group < CPULOAD_GROUP_COUNT) ? group_names[group] : "?";
+}
+
+const char *cpuload_window_name(int window)
+{
+    return (window >= 0 && window < CPULOAD_WINDOW_COUNT) ? window_names[window] : "?";
+}
+
+static int cmd_cpu_show(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    static cpuload_report_t r;
+    const cpuload_summary_t *s = &r.summary;
+
+    cpuload_get_report(&r);
+    if (r.timestamp_ms == 0) {
+        shell_print(sh, "No sample yet");
+        return 0;
+    }
+    shell_print(sh, "total %3u.%02u%% (1s)  %3u.%02u%% (10s)  peak %u.%02u%% (1s)",
+                s->total[CPULOAD_WINDOW_1S] / 100U, s->total[CPULOAD_WINDOW_1S] % 100U,
+                s->total[CPULOAD_WINDOW_10S] / 100U, s->total[CPULOAD_WINDOW_10S] % 100U,
+                s->peak / 100U, s->peak % 100U);
+    shell_print(sh, "group          1s      10s");
+    for (int g = 0; g < CPULOAD_GROUP_COUNT; g++) {
+        shell_print(sh, "  %-9s %3u.%02u%% %3u.%02u%%", group_names[g],
+                    s->group[g][CPULOAD_WINDOW_1S] / 100U, s->group[g][CPULOAD_WINDOW_1S] % 100U,
+                    s->group[g][CPULOAD_WINDOW_10S] / 100U, s->group[g][CPULOAD_WINDOW_10S] % 100U);
+    }
+    shell_print(sh, "sampler: every %d ms, %u ns (max %u ns)", CPULOAD_SAMPLE_MS,
+                rov_cycles_to_ns(r.sample_cycles), rov_cycles_to_ns(r.sample_max_cycles));
+    return 0;
+}
+
+static int cmd_cpu_threads(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    static cpuload_report_t r;
+    uint8_t order[CPULOAD_MAX_THREADS];
+
+    cpuload_get_report(&r);
+
+    // Busiest first (insertion sort on the 1 s load)
+    for (int i = 0; i < r.thread_count; i++) {
+        int j = i;
+
+        while (j > 0 && r.threads[order[j - 1]].load[CPULOAD_WINDOW_1S] <
+                        r.threads[i].load[CPULOAD_WINDOW_1S]) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = (uint8_t)i;
+    }
+
+    shell_print(sh, "thread           group          1s      10s");
+    for (int i = 0; i < r.thread_count; i++) {
+        const cpuload_thread_t *t = &r.threads[order[i]];
+
+        shell_print(sh, "%-16s %-9s %3u.%02u%% %3u.%02u%%", t->name[0] ? t->name : "?",
+                    group_names[t->group],
+                    t->load[CPULOAD_WINDOW_1S] / 100U, t->load[CPULOAD_WINDOW_1S] % 100U,
+                    t->load[CPULOAD_WINDOW_10S] / 100U, t->load[CPULOAD_WINDOW_10S] % 100U);
+    }
+    if (r.truncated) {
+        shell_warn(sh, "More than %d threads, list truncated", CPULOAD_MAX_THREADS);
+    }
+    return 0;
+}
+
+static int cmd_cpu_reset(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    cpuload_reset();
+    shell_print(sh, "Peak load and sampler cost reset");
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(cpu_cmds,
+    SHELL_CMD(show, NULL, "Total, peak and per-group load over 1 s and 10 s", cmd_cpu_show),
+    SHELL_CMD(threads, NULL, "Per-thread load, busiest first", cmd_cpu_threads),
+    SHELL_CMD(reset, NULL, "Clear the peak load", cmd_cpu_reset),
+    SHELL_SUBCMD_SET_END
+);
+
+SHELL_SUBCMD_ADD((rov), cpu, &cpu_cmds, "CPU utilization over sliding windows", NULL, 1, 0);
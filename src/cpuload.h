@@ -0,0 +1,78 @@
+#pragma once
+
+#include <zephyr/kernel.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * CPU utilization from the kernel's thread runtime statistics.
+ *
+ * Every CPULOAD_SAMPLE_MS the telemetry thread records each thread's
+ * cumulative execution cycles in a short history ring; loads over the
+ * sliding windows below are differences between ring entries. Time spent
+ * in ISRs is charged to the thread they interrupted.
+ */
+#define CPULOAD_SAMPLE_MS    100
+#define CPULOAD_MAX_THREADS  24
+
+typedef enum {
+    CPULOAD_WINDOW_1S = 0,
+    CPULOAD_WINDOW_10S,
+    CPULOAD_WINDOW_COUNT
+} cpuload_window_t;
+
+// Threads grouped by role (telemetry sends groups, the shell lists threads)
+typedef enum {
+    CPULOAD_GROUP_UDP = 0,       // udp_server
+    CPULOAD_GROUP_CONTROL,       // rov_control
+    CPULOAD_GROUP_NET,           // Network stack: RX/TX queues, net_mgmt, Ethernet driver
+    CPULOAD_GROUP_LOG,           // Deferred logging
+    CPULOAD_GROUP_SENSORS,       // Sensor sampling threads
+    CPULOAD_GROUP_TELEMETRY,     // Telemetry uplink (includes this sampler)
+    CPULOAD_GROUP_OTHER,         // Shell, work queue, main, ...
+    CPULOAD_GROUP_IDLE,
+    CPULOAD_GROUP_COUNT
+} cpuload_group_t;
+
+typedef struct {
+    char name[16];
+    uint8_t group;                           // cpuload_group_t
+    uint16_t load[CPULOAD_WINDOW_COUNT];     // 0.01 % of the CPU
+} cpuload_thread_t;
+
+// Loads in 0.01 % of the CPU (telemetry `cpu` topic)
+typedef struct {
+    uint16_t total[CPULOAD_WINDOW_COUNT];    // Everything but idle
+    uint16_t peak;                           // Highest 1 s total since the last reset
+    uint16_t group[CPULOAD_GROUP_COUNT][CPULOAD_WINDOW_COUNT];
+} cpuload_summary_t;
+
+// Published after every sample
+typedef struct {
+    uint32_t timestamp_ms;                   // Uptime of the newest sample
+    cpuload_summary_t summary;
+    uint8_t thread_count;
+    bool truncated;                          // More threads than CPULOAD_MAX_THREADS
+    cpuload_thread_t threads[CPULOAD_MAX_THREADS];
+    uint32_t sample_cycles;                  // Cost of the newest sample
+    uint32_t sample_max_cycles;              // Since the last reset
+} cpuload_report_t;
+
+// Telemetry thread only, every CPULOAD_SAMPLE_MS
+void cpuload_sample(void);
+
+// Any thread
+void cpuload_get_report(cpuload_report_t *report);
+void cpuload_get_summary(cpuload_summary_t *summary);
+uint16_t cpuload_total(cpuload_window_t window);
+void cpuload_reset(void);
+const char *cpuload_group_name(int group);
+const char *cpuload_window_name(int window);
+
+#ifdef __cplusplus
+}
+#endif
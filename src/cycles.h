@@ -0,0 +1,52 @@
+#pragma once
+
+#include <zephyr/kernel.h>
+#include <stdint.h>
+
+#if defined(CONFIG_CPU_CORTEX_M7)
+#include <cmsis_core.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Cycle counter used for per-tick cost measurements.
+ * Cortex-M7: DWT CYCCNT (core clock, no syscall, ~1 cycle to read).
+ * Everything else (native_sim): k_cycle_get_32().
+ */
+
+static inline void rov_cycles_init(void)
+{
+#if defined(CONFIG_CPU_CORTEX_M7)
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->LAR = 0xC5ACCE55;  // Unlock DWT registers (required on M7)
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+}
+
+static inline uint32_t rov_cycles_now(void)
+{
+#if defined(CONFIG_CPU_CORTEX_M7)
+    return DWT->CYCCNT;
+#else
+    return k_cycle_get_32();
+#endif
+}
+
+// SysTick runs from the core clock on the F7, so both sources share this rate
+static inline uint32_t rov_cycles_per_sec(void)
+{
+    return sys_clock_hw_cycles_per_sec();
+}
+
+static inline uint32_t rov_cycles_to_ns(uint32_t cycles)
+{
+    return (uint32_t)(((uint64_t)cycles * 1000000000ULL) / rov_cycles_per_sec());
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,244 @@
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/shell/shell.h>
+#include <errno.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "filter.h"
+#include "hotpath.h"
+
+LOG_MODULE_DECLARE(k2_app);
+
+#define FILTER_DT_S (1.0f / ROV_CONTROL_RATE_HZ)
+
+// Default tuning applied to every axis at startup
+#define FILTER_DEFAULT_EXPO      0.0f
+#define FILTER_DEFAULT_CUTOFF_HZ 10.0f
+#define FILTER_DEFAULT_SLEW_RATE 4.0f   // Full stick reversal (2.0) in 0.5 s
+
+/*
+ * Per-tick coefficients, stored structure-of-arrays so the six axes are
+ * processed in one straight loop without branches. Two copies exist: the
+ * control loop reads the active one while a tuning call fills the other
+ * and publishes it with a single atomic index swap.
+ */
+typedef struct {
+    float expo[ROV_AXIS_COUNT];       // Cubic blend factor
+    float slew_step[ROV_AXIS_COUNT];  // Maximum change per tick
+    float lpf_alpha[ROV_AXIS_COUNT];  // Low-pass smoothing factor per tick
+} filter_coeffs_t;
+
+static filter_coeffs_t ROV_HOT_BSS coeff_sets[2];
+static atomic_t active_set = ATOMIC_INIT(0);
+K_MUTEX_DEFINE(filter_tune_lock);   // Serializes writers of the inactive set
+
+// User-facing parameters, kept for read-back and to rebuild coefficient sets
+static filter_axis_params_t axis_params[ROV_AXIS_COUNT];
+
+// Filter state, touched only by the control thread
+static float ROV_HOT_BSS slew_state[ROV_AXIS_COUNT];
+static float ROV_HOT_BSS lpf_state[ROV_AXIS_COUNT];
+
+static void filter_coeffs_from_params(filter_coeffs_t *coeffs, int axis,
+                                      const filter_axis_params_t *params)
+{
+    coeffs->expo[axis] = params->expo;
+
+    // A step of 2.0 covers the full -1..+1 range, i.e. no limiting
+    coeffs->slew_step[axis] = (params->slew_rate > 0.0f) ?
+                              params->slew_rate * FILTER_DT_S : 2.0f;
+
+    // Discretized first-order low-pass: alpha = 1 - e^(-2*pi*fc*dt)
+    coeffs->lpf_alpha[axis] = (params->cutoff_hz > 0.0f) ?
+                              1.0f - expf(-2.0f * 3.14159265f * params->cutoff_hz * FILTER_DT_S) :
+                              1.0f;
+}
+
+/**
+ * Initialize the filter bank with default tuning on every axis
+ */
+void filter_bank_init(void)
+{
+    for (int i = 0; i < ROV_AXIS_COUNT; i++) {
+        axis_params[i].expo = FILTER_DEFAULT_EXPO;
+        axis_params[i].cutoff_hz = FILTER_DEFAULT_CUTOFF_HZ;
+        axis_params[i].slew_rate = FILTER_DEFAULT_SLEW_RATE;
+        filter_coeffs_from_params(&coeff_sets[0], i, &axis_params[i]);
+    }
+    coeff_sets[1] = coeff_sets[0];
+    atomic_set(&active_set, 0);
+
+    filter_bank_reset();
+
+    LOG_INF("Input filter bank: expo %.2f, cutoff %.1f Hz, slew %.1f /s",
+            (double)FILTER_DEFAULT_EXPO, (double)FILTER_DEFAULT_CUTOFF_HZ,
+            (double)FILTER_DEFAULT_SLEW_RATE);
+}
+
+/**
+ * Reset filter state to neutral
+ */
+void filter_bank_reset(void)
+{
+    memset(slew_state, 0, sizeof(slew_state));
+    memset(lpf_state, 0, sizeof(lpf_state));
+}
+
+/**
+ * Process one control tick for all six axes
+ * @param axes: Normalized axes (-1.0 to +1.0), filtered in place
+ */
+ROV_HOT_CODE void filter_bank_process(float axes[ROV_AXIS_COUNT])
+{
+    const filter_coeffs_t *c = &coeff_sets[atomic_get(&active_set)];
+
+    for (int i = 0; i < ROV_AXIS_COUNT; i++) {
+        float x = axes[i];
+
+        // Expo: blend linear and cubic response, y = x * ((1 - e) + e * x^2)
+        x = x * ((1.0f - c->expo[i]) + c->expo[i] * x * x);
+
+        // Slew-rate limit, branch-free (fminf/fmaxf map to VMINNM/VMAXNM on the M7)
+        float step = fmaxf(-c->slew_step[i], fminf(x - slew_state[i], c->slew_step[i]));
+        slew_state[i] += step;
+
+        // First-order low-pass
+        lpf_state[i] += c->lpf_alpha[i] * (slew_state[i] - lpf_state[i]);
+
+        axes[i] = lpf_state[i];
+    }
+}
+
+/**
+ * Retune one axis without stopping the control loop
+ * @param axis: Axis index (enum rov_axis)
+ * @param params: New tuning
+ * @return: 0 on success, -EINVAL on bad arguments
+ */
+int filter_bank_set_axis(int axis, const filter_axis_params_t *params)
+{
+    // Written so that NaN fails every check
+    if (axis < 0 || axis >= ROV_AXIS_COUNT ||
+        !(params->expo >= 0.0f && params->expo <= 1.0f) ||
+        !(params->cutoff_hz >= 0.0f) || !(params->slew_rate >= 0.0f)) {
+        return -EINVAL;
+    }
+
+    k_mutex_lock(&filter_tune_lock, K_FOREVER);
+
+    int active = atomic_get(&active_set);
+    filter_coeffs_t *next = &coeff_sets[!active];
+
+    axis_params[axis] = *params;
+    *next = coeff_sets[active];
+    filter_coeffs_from_params(next, axis, params);
+
+    // Publish: the control loop picks up the new set on its next tick
+    atomic_set(&active_set, !active);
+
+    k_mutex_unlock(&filter_tune_lock);
+    return 0;
+}
+
+/**
+ * Read back the tuning of one axis
+ * @param axis: Axis index (enum rov_axis)
+ * @param params: Output tuning
+ */
+void filter_bank_get_axis(int axis, filter_axis_params_t *params)
+{
+    k_mutex_lock(&filter_tune_lock, K_FOREVER);
+    *params = axis_params[axis];
+    k_mutex_unlock(&filter_tune_lock);
+}
+
+static int cmd_filter_show(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    shell_print(sh, "axis   expo  cutoff_hz  slew_rate");
+    for (int i = 0; i < ROV_AXIS_COUNT; i++) {
+        filter_axis_params_t params;
+
+        filter_bank_get_axis(i, &params);
+        shell_print(sh, "%-6s %4.2f  %9.1f  %9.1f", rov_axis_name(i),
+                    (double)params.expo, (double)params.cutoff_hz,
+                    (double)params.slew_rate);
+    }
+    return 0;
+}
+
+static int cmd_filter_set(const struct shell *sh, size_t argc, char **argv)
+{
+    filter_axis_params_t params;
+    int axis = rov_axis_from_name(argv[1]);
+
+    if (axis < 0) {
+        shell_error(sh, "Unknown axis: %s", argv[1]);
+        return -EINVAL;
+    }
+
+    params.expo = strtof(argv[2], NULL);
+    params.cutoff_hz = strtof(argv[3], NULL);
+    params.slew_rate = strtof(argv[4], NULL);
+
+    if (filter_bank_set_axis(axis, &params) != 0) {
+        shell_error(sh, "Invalid tuning (expo 0..1, cutoff and slew >= 0)");
+        return -EINVAL;
+    }
+    return 0;
+}
+
+/*
+ * Invalid tunings must be rejected and leave the axis as it was. None of
+ * them is applied, so this is safe while the control loop runs.
+ */
+static int cmd_filter_test(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    static const struct {
+        const char *name;
+        filter_axis_params_t params;
+    } cases[] = {
+        { "expo nan",    { NAN, FILTER_DEFAULT_CUTOFF_HZ, FILTER_DEFAULT_SLEW_RATE } },
+        { "cutoff nan",  { FILTER_DEFAULT_EXPO, NAN, FILTER_DEFAULT_SLEW_RATE } },
+        { "slew nan",    { FILTER_DEFAULT_EXPO, FILTER_DEFAULT_CUTOFF_HZ, NAN } },
+        { "expo -0.1",   { -0.1f, FILTER_DEFAULT_CUTOFF_HZ, FILTER_DEFAULT_SLEW_RATE } },
+        { "expo 1.1",    { 1.1f, FILTER_DEFAULT_CUTOFF_HZ, FILTER_DEFAULT_SLEW_RATE } },
+        { "expo inf",    { INFINITY, FILTER_DEFAULT_CUTOFF_HZ, FILTER_DEFAULT_SLEW_RATE } },
+        { "cutoff -1",   { FILTER_DEFAULT_EXPO, -1.0f, FILTER_DEFAULT_SLEW_RATE } },
+        { "slew -1",     { FILTER_DEFAULT_EXPO, FILTER_DEFAULT_CUTOFF_HZ, -1.0f } },
+    };
+    bool ok = true;
+
+    for (size_t i = 0; i < ARRAY_SIZE(cases); i++) {
+        filter_axis_params_t before;
+        filter_axis_params_t after;
+
+        filter_bank_get_axis(ROV_AXIS_SURGE, &before);
+        int ret = filter_bank_set_axis(ROV_AXIS_SURGE, &cases[i].params);
+        filter_bank_get_axis(ROV_AXIS_SURGE, &after);
+
+        bool pass = ret == -EINVAL && memcmp(&before, &after, sizeof(before)) == 0;
+
+        shell_print(sh, "%-12s %s", cases[i].name, pass ? "rejected" : "FAIL");
+        ok &= pass;
+    }
+
+    shell_print(sh, "filter tuning test %s", ok ? "passed" : "FAILED");
+    return ok ? 0 : -EIO;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(filter_cmds,
+    SHELL_CMD(show, NULL, "Show filter tuning", cmd_filter_show),
+    SHELL_CMD_ARG(set, NULL, "<axis> <expo> <cutoff_hz> <slew_rate>", cmd_filter_set, 5, 0),
+    SHELL_CMD(test, NULL, "Check that invalid and NaN tunings are rejected", cmd_filter_test),
+    SHELL_SUBCMD_SET_END
+);
+
+SHELL_SUBCMD_ADD((rov), filter, &filter_cmds, "Input filter bank", NULL, 1, 0);
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <zephyr/kernel.h>
+
+#include "control.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// User-facing tuning for one input axis
+typedef struct {
+    float expo;       // Stick curve: 0.0 = linear, 1.0 = fully cubic
+    float cutoff_hz;  // First-order low-pass cutoff, 0 = disabled
+    float slew_rate;  // Maximum change in full-scale units per second, 0 = unlimited
+} filter_axis_params_t;
+
+void filter_bank_init(void);
+
+// Reset filter state so the outputs start from neutral
+void filter_bank_reset(void);
+
+// Run all six axes through expo, slew-rate limit and low-pass (in place)
+void filter_bank_process(float axes[ROV_AXIS_COUNT]);
+
+// Runtime tuning, safe to call while the control loop runs
+int filter_bank_set_axis(int axis, const filter_axis_params_t *params);
+void filter_bank_get_axis(int axis, filter_axis_params_t *params);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,416 @@
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/devicetree.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/shell/shell.h>
+#if defined(CONFIG_WATCHDOG)
+#include <zephyr/drivers/watchdog.h>
+#endif
+#if defined(CONFIG_HWINFO)
+#include <zephyr/drivers/hwinfo.h>
+#endif
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "health.h"
+#include "control.h"
+#include "net.h"
+#include "led.h"
+#include "wcet.h"
+#include "cpuload.h"
+#include "stackmon.h"
+#include "latency.h"
+
+LOG_MODULE_DECLARE(k2_app);
+
+#if defined(CONFIG_WATCHDOG) && DT_NODE_HAS_STATUS(DT_ALIAS(watchdog0), okay)
+#define HEALTH_HAS_WATCHDOG 1
+static const struct device *const watchdog_dev = DEVICE_DT_GET(DT_ALIAS(watchdog0));
+static int watchdog_channel = -1;       // Main thread only
+#endif
+
+BUILD_ASSERT(CONFIG_K2_WATCHDOG_TIMEOUT_MS >= 3 * HEALTH_CHECK_MS,
+             "Watchdog timeout must span several liveness checks");
+
+static atomic_t period_ms = ATOMIC_INIT(CONFIG_K2_HEALTH_PERIOD_MS);
+static atomic_t log_enabled = ATOMIC_INIT(IS_ENABLED(CONFIG_K2_HEALTH_LOG));
+
+// Supervisor state, main thread only
+static bool stalled;
+static bool watchdog_reset;
+static uint32_t last_rx_packets;
+
+// Published copies for everyone else
+static health_record_t published;
+static bool published_valid;
+static health_watchdog_t watchdog = { .timeout_ms = CONFIG_K2_WATCHDOG_TIMEOUT_MS };
+static struct k_spinlock health_lock;
+
+/**
+ * Check whether the previous reset was caused by the watchdog, and clear the cause
+ */
+static bool health_read_reset_cause(void)
+{
+#if defined(CONFIG_HWINFO)
+    uint32_t cause;
+
+    if (hwinfo_get_reset_cause(&cause) == 0) {
+        hwinfo_clear_reset_cause();
+        return (cause & RESET_WATCHDOG) != 0;
+    }
+#endif
+    return false;
+}
+
+static void health_watchdog_start(void)
+{
+#if defined(HEALTH_HAS_WATCHDOG)
+    struct wdt_timeout_cfg cfg = {
+        .window = { .min = 0, .max = CONFIG_K2_WATCHDOG_TIMEOUT_MS },
+        .callback = NULL,
+        .flags = WDT_FLAG_RESET_SOC,
+    };
+    int ret;
+
+    if (!device_is_ready(watchdog_dev)) {
+        LOG_ERR("Watchdog device not ready");
+        return;
+    }
+    ret = wdt_install_timeout(watchdog_dev, &cfg);
+    if (ret < 0) {
+        LOG_ERR("Watchdog timeout install failed: %d", ret);
+        return;
+    }
+    watchdog_channel = ret;
+
+    // Keep it from firing while a debugger holds the core
+    ret = wdt_setup(watchdog_dev, WDT_OPT_PAUSE_HALTED_BY_DBG);
+    if (ret < 0) {
+        LOG_ERR("Watchdog setup failed: %d", ret);
+        watchdog_channel = -1;
+        return;
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&health_lock);
+    watchdog.armed = true;
+    k_spin_unlock(&health_lock, key);
+    LOG_INF("Watchdog armed, %d ms timeout", CONFIG_K2_WATCHDOG_TIMEOUT_MS);
+#else
+    LOG_WRN("No hardware watchdog, control loop stalls are only reported");
+#endif
+}
+
+/**
+ * Control loop liveness check; feeds the watchdog only while it passes
+ * @param elapsed_ms: Time since the previous check
+ * @param ticks: Control ticks completed since the previous check
+ */
+static void health_check(uint32_t elapsed_ms, uint32_t ticks)
+{
+    // Half the nominal tick count: overruns and a late supervisor still
+    // pass, a blocked control thread does not
+    uint32_t expected = elapsed_ms * ROV_CONTROL_RATE_HZ / MSEC_PER_SEC;
+    bool alive = ticks > 0 && ticks >= expected / 2;
+
+    if (!alive && !stalled) {
+        LOG_ERR("Control loop stalled: %u ticks in %u ms", ticks, elapsed_ms);
+    } else if (alive && stalled) {
+        LOG_WRN("Control loop running again");
+    }
+    stalled = !alive;
+
+#if defined(HEALTH_HAS_WATCHDOG)
+    if (alive && watchdog_channel >= 0) {
+        wdt_feed(watchdog_dev, watchdog_channel);
+    }
+#endif
+
+    k_spinlock_key_t key = k_spin_lock(&health_lock);
+    if (!alive) {
+        published.stalls++;
+    }
+    if (watchdog.armed) {
+        if (alive) {
+            watchdog.feeds++;
+        } else {
+            watchdog.withheld++;
+        }
+    }
+    k_spin_unlock(&health_lock, key);
+}
+
+/**
+ * Stack with the least headroom, as a share of its size
+ */
+static void health_collect_stacks(health_record_t *r)
+{
+    static stackmon_report_t stacks;    // Too large for the main stack
+    uint32_t worst_pct = 101;
+
+    stackmon_get_report(&stacks);
+    for (int i = 0; i < stacks.count; i++) {
+        const stackmon_entry_t *e = &stacks.stacks[i];
+        uint32_t free_bytes = e->size > e->high_water ? e->size - e->high_water : 0;
+        uint32_t pct;
+
+        if (e->size == 0) {
+            continue;
+        }
+        pct = free_bytes * 100U / e->size;
+        if (pct < HEALTH_STACK_LOW_PCT) {
+            r->flags |= HEALTH_FLAG_STACK_LOW;
+        }
+        if (pct < worst_pct) {
+            worst_pct = pct;
+            strncpy(r->stack_name, e->name, sizeof(r->stack_name) - 1);
+            r->stack_free = free_bytes;
+            r->stack_free_pct = (uint8_t)pct;
+        }
+    }
+}
+
+/**
+ * Gather, publish and optionally log one health record
+ * @param now_ms: Uptime
+ * @param elapsed_ms: Time since the previous record
+ */
+static void health_collect(int64_t now_ms, uint32_t elapsed_ms)
+{
+    health_record_t r = { 0 };
+    net_link_stats_t link;
+    rov_queue_stats_t queue;
+    wcet_report_t wcet;
+    cpuload_summary_t cpu;
+    latency_summary_t latency[LATENCY_SEGMENT_COUNT];
+    uint32_t commands;
+    uint32_t rate;
+
+    net_get_link_stats(&link);
+    rov_get_queue_stats(&queue);
+    wcet_get_report(&wcet);
+    cpuload_get_summary(&cpu);
+    latency_get_summary(latency);
+
+    r.uptime_s = (uint32_t)(now_ms / MSEC_PER_SEC);
+    if (atomic_test_bit(&led_status, LED_STATUS_LINK_UP)) {
+        r.flags |= HEALTH_FLAG_LINK_UP;
+    }
+    if (atomic_test_bit(&led_status, LED_STATUS_FAILSAFE)) {
+        r.flags |= HEALTH_FLAG_FAILSAFE;
+    }
+    if (stalled) {
+        r.flags |= HEALTH_FLAG_CONTROL_STALLED;
+    }
+    if (watchdog_reset) {
+        r.flags |= HEALTH_FLAG_WATCHDOG_RESET;
+    }
+
+    // The link counters can be reset under us (rov perf reset)
+    commands = link.rx_packets >= last_rx_packets ? link.rx_packets - last_rx_packets
+                                                  : link.rx_packets;
+    last_rx_packets = link.rx_packets;
+    rate = elapsed_ms > 0 ? (uint32_t)((uint64_t)commands * MSEC_PER_SEC / elapsed_ms) : 0;
+    r.command_rate_hz = (uint16_t)MIN(rate, UINT16_MAX);
+
+    r.rx_packets = link.rx_packets;
+    r.crc_errors = link.crc_errors;
+    r.size_errors = link.size_errors;
+    r.recv_errors = link.recv_errors;
+    r.queue_drops = queue.drops;
+    r.control_ticks = rov_control_ticks();
+    r.control_overruns = wcet.overruns;
+    r.cpu_load = cpu.total[CPULOAD_WINDOW_1S];
+    r.cpu_peak = cpu.peak;
+    r.latency_max_us = latency[LATENCY_TOTAL].max_ns / 1000U;
+    health_collect_stacks(&r);
+
+    k_spinlock_key_t key = k_spin_lock(&health_lock);
+    r.stalls = published.stalls;
+    if (watchdog.armed) {
+        r.flags |= HEALTH_FLAG_WATCHDOG;
+    }
+    published = r;
+    published_valid = true;
+    k_spin_unlock(&health_lock, key);
+
+    if (atomic_get(&log_enabled)) {
+        LOG_INF("Health %u s: link %s, %u cmd/s, rx %u, err %u, drop %u, overrun %u, "
+                "stall %u, cpu %u.%02u%%, stack %s %u%% free, latency %u us",
+                r.uptime_s,
+                !(r.flags & HEALTH_FLAG_LINK_UP) ? "down" :
+                (r.flags & HEALTH_FLAG_FAILSAFE) ? "failsafe" : "up",
+                r.command_rate_hz, r.rx_packets,
+                r.crc_errors + r.size_errors + r.recv_errors, r.queue_drops,
+                r.control_overruns, r.stalls, r.cpu_load / 100U, r.cpu_load % 100U,
+                r.stack_name, r.stack_free_pct, r.latency_max_us);
+    }
+}
+
+/**
+ * Supervisor loop of the main thread
+ */
+void health_run(void)
+{
+    int64_t last_check = k_uptime_get();
+    int64_t last_record = last_check;
+    uint32_t last_ticks = rov_control_ticks();
+
+    watchdog_reset = health_read_reset_cause();
+    if (watchdog_reset) {
+        LOG_WRN("Previous reset was caused by the watchdog");
+    }
+    health_watchdog_start();
+    LOG_INF("Health supervisor running, record every %u ms", health_get_period_ms());
+
+    while (1) {
+        k_sleep(K_MSEC(HEALTH_CHECK_MS));
+
+        int64_t now = k_uptime_get();
+        uint32_t ticks = rov_control_ticks();
+
+        health_check((uint32_t)(now - last_check), ticks - last_ticks);
+        last_check = now;
+        last_ticks = ticks;
+
+        if (now - last_record >= (int64_t)health_get_period_ms()) {
+            health_collect(now, (uint32_t)(now - last_record));
+            last_record = now;
+        }
+    }
+}
+
+/**
+ * Copy the newest health record
+ * @param record: Output
+ * @return: false (and a zeroed record) before the first one
+ */
+bool health_get_record(health_record_t *record)
+{
+    bool valid;
+
+    k_spinlock_key_t key = k_spin_lock(&health_lock);
+    *record = published;
+    valid = published_valid;
+    k_spin_unlock(&health_lock, key);
+
+    if (!valid) {
+        memset(record, 0, sizeof(*record));
+    }
+    return valid;
+}
+
+void health_get_watchdog(health_watchdog_t *out)
+{
+    k_spinlock_key_t key = k_spin_lock(&health_lock);
+    *out = watchdog;
+    k_spin_unlock(&health_lock, key);
+}
+
+/**
+ * Set the health record period
+ * @param ms: HEALTH_PERIOD_MIN_MS..HEALTH_PERIOD_MAX_MS, rounded to liveness checks
+ * @return: 0 or -EINVAL
+ */
+int health_set_period_ms(uint32_t ms)
+{
+    if (ms < HEALTH_PERIOD_MIN_MS || ms > HEALTH_PERIOD_MAX_MS) {
+        return -EINVAL;
+    }
+    atomic_set(&period_ms, (atomic_val_t)ms);
+    return 0;
+}
+
+uint32_t health_get_period_ms(void)
+{
+    return (uint32_t)atomic_get(&period_ms);
+}
+
+void health_set_log(bool enabled)
+{
+    atomic_set(&log_enabled, enabled ? 1 : 0);
+}
+
+bool health_get_log(void)
+{
+    return atomic_get(&log_enabled) != 0;
+}
+
+static int cmd_health_show(const struct shell *sh, size_t argc, char **argv)
+{
+    health_record_t r;
+    health_watchdog_t w;
+
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    health_get_watchdog(&w);
+    if (w.armed) {
+        shell_print(sh, "watchdog  %u ms, %u feeds, %u withheld", w.timeout_ms, w.feeds,
+                    w.withheld);
+    } else {
+        shell_print(sh, "watchdog  not armed");
+    }
+    shell_print(sh, "period    %u ms, log %s", health_get_period_ms(),
+                health_get_log() ? "on" : "off");
+
+    if (!health_get_record(&r)) {
+        shell_print(sh, "No record yet");
+        return 0;
+    }
+    shell_print(sh, "uptime    %u s%s%s", r.uptime_s,
+                (r.flags & HEALTH_FLAG_WATCHDOG_RESET) ? ", after a watchdog reset" : "",
+                (r.flags & HEALTH_FLAG_CONTROL_STALLED) ? ", CONTROL STALLED" : "");
+    shell_print(sh, "link      %s%s, %u cmd/s", (r.flags & HEALTH_FLAG_LINK_UP) ? "up" : "down",
+                (r.flags & HEALTH_FLAG_FAILSAFE) ? " (failsafe)" : "", r.command_rate_hz);
+    shell_print(sh, "counters  rx %u crc %u size %u recv %u drops %u", r.rx_packets,
+                r.crc_errors, r.size_errors, r.recv_errors, r.queue_drops);
+    shell_print(sh, "control   %u ticks, %u overruns, %u stalls", r.control_ticks,
+                r.control_overruns, r.stalls);
+    shell_print(sh, "cpu       %u.%02u%% (peak %u.%02u%%)", r.cpu_load / 100U, r.cpu_load % 100U,
+                r.cpu_peak / 100U, r.cpu_peak % 100U);
+    shell_print(sh, "stack     %s: %u bytes (%u%%) free%s", r.stack_name, r.stack_free,
+                r.stack_free_pct,
+                (r.flags & HEALTH_FLAG_STACK_LOW) ? ", LOW" : "");
+    shell_print(sh, "latency   %u us worst", r.latency_max_us);
+    return 0;
+}
+
+static int cmd_health_period(const struct shell *sh, size_t argc, char **argv)
+{
+    if (argc < 2) {
+        shell_print(sh, "%u ms", health_get_period_ms());
+        return 0;
+    }
+    if (health_set_period_ms(strtoul(argv[1], NULL, 10)) != 0) {
+        shell_error(sh, "Period must be %d..%d ms", HEALTH_PERIOD_MIN_MS, HEALTH_PERIOD_MAX_MS);
+        return -EINVAL;
+    }
+    return 0;
+}
+
+static int cmd_health_log(const struct shell *sh, size_t argc, char **argv)
+{
+    if (argc < 2) {
+        shell_print(sh, "%s", health_get_log() ? "on" : "off");
+        return 0;
+    }
+    if (strcmp(argv[1], "on") == 0) {
+        health_set_log(true);
+    } else if (strcmp(argv[1], "off") == 0) {
+        health_set_log(false);
+    } else {
+        shell_error(sh, "Use on or off");
+        return -EINVAL;
+    }
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(health_cmds,
+    SHELL_CMD(show, NULL, "Newest health record and watchdog state", cmd_health_show),
+    SHELL_CMD_ARG(period, NULL, "[<ms>] Health record period", cmd_health_period, 1, 1),
+    SHELL_CMD_ARG(log, NULL, "[on|off] Log every health record", cmd_health_log, 1, 1),
+    SHELL_SUBCMD_SET_END
+);
+
+SHELL_SUBCMD_ADD((rov), health, &health_cmds, "Health supervisor and watchdog", NULL, 1, 0);
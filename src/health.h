@@ -0,0 +1,78 @@
+#pragma once
+
+#include <zephyr/kernel.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Health supervisor, run by the main thread once everything is started.
+ *
+ * Every HEALTH_CHECK_MS it checks that the control loop is still ticking
+ * (at least half its rate since the previous check) and only then feeds
+ * the hardware watchdog (devicetree alias watchdog0, timeout
+ * CONFIG_K2_WATCHDOG_TIMEOUT_MS), so a stalled control thread resets the
+ * vehicle. Builds without a watchdog still run the check and report stalls.
+ *
+ * Every health period (CONFIG_K2_HEALTH_PERIOD_MS, `rov health period`) it
+ * gathers one compact record from the other modules. The newest record is
+ * served to subscribers of the telemetry health topic and, when enabled
+ * (CONFIG_K2_HEALTH_LOG, `rov health log`), logged as one line.
+ */
+#define HEALTH_CHECK_MS       100
+#define HEALTH_PERIOD_MIN_MS  HEALTH_CHECK_MS
+#define HEALTH_PERIOD_MAX_MS  60000
+#define HEALTH_STACK_LOW_PCT  10      // Free share of a stack that raises HEALTH_FLAG_STACK_LOW
+
+// Record flags
+#define HEALTH_FLAG_LINK_UP          BIT(0)
+#define HEALTH_FLAG_FAILSAFE         BIT(1)
+#define HEALTH_FLAG_CONTROL_STALLED  BIT(2)   // Last liveness check failed
+#define HEALTH_FLAG_WATCHDOG         BIT(3)   // Hardware watchdog armed
+#define HEALTH_FLAG_WATCHDOG_RESET   BIT(4)   // The previous reset was the watchdog
+#define HEALTH_FLAG_STACK_LOW        BIT(5)   // A stack has under HEALTH_STACK_LOW_PCT free
+
+typedef struct {
+    uint32_t uptime_s;
+    uint16_t flags;              // HEALTH_FLAG_*
+    uint16_t command_rate_hz;    // Valid commands per second over the last period
+    uint32_t rx_packets;         // Link counters (net.h), since boot or their reset
+    uint32_t crc_errors;
+    uint32_t size_errors;
+    uint32_t recv_errors;
+    uint32_t queue_drops;
+    uint32_t control_ticks;      // Since boot
+    uint32_t control_overruns;   // Ticks over the WCET budget since its reset
+    uint32_t stalls;             // Failed liveness checks since boot
+    uint16_t cpu_load;           // 0.01 %, last second
+    uint16_t cpu_peak;           // 0.01 %, highest second since the CPU load reset
+    char stack_name[16];         // Stack with the least headroom (percent of its size)
+    uint32_t stack_free;         // Bytes never touched on that stack
+    uint8_t stack_free_pct;
+    uint32_t latency_max_us;     // Worst packet-to-output since the latency reset
+} health_record_t;
+
+typedef struct {
+    bool armed;
+    uint32_t timeout_ms;
+    uint32_t feeds;
+    uint32_t withheld;           // Feeds skipped because the control loop stalled
+} health_watchdog_t;
+
+// Main thread only, after every other module has started; never returns
+void health_run(void);
+
+// Any thread
+bool health_get_record(health_record_t *record);   // false before the first record
+void health_get_watchdog(health_watchdog_t *watchdog);
+int health_set_period_ms(uint32_t period_ms);
+uint32_t health_get_period_ms(void);
+void health_set_log(bool enabled);
+bool health_get_log(void);
+
+#ifdef __cplusplus
+}
+#endif
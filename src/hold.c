@@ -0,0 +1,492 @@
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/shell/shell.h>
+#include <errno.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hold.h"
+#include "cycles.h"
+
+LOG_MODULE_DECLARE(k2_app);
+
+#define HOLD_DT_S (1.0f / ROV_CONTROL_RATE_HZ)
+
+// How fast a full stick deflection moves the setpoint of an active hold
+#define DEPTH_NUDGE_MPS    0.3f   // meters per second
+#define HEADING_NUDGE_DPS  45.0f  // degrees per second
+
+// Step response test: settle within max(2% of step, minimum band)
+#define HOLD_STEP_WINDOW_S    20
+#define HOLD_STEP_BAND_PCT    0.02f
+static const float step_min_band[HOLD_COUNT] = { 0.02f, 0.5f };  // m, deg
+
+// Derivative term low-pass (~5 Hz at 400 Hz): 1 - e^(-2*pi*5/400)
+#define HOLD_DERIV_ALPHA      0.0755f
+
+static const char *const hold_names[HOLD_COUNT] = { "depth", "heading" };
+
+// Runtime state of one hold controller, owned by the control thread
+typedef struct {
+    pid_gains_t gains;
+    bool enabled;
+    float setpoint;
+    float measurement;
+    float prev_measurement;
+    float rate_filtered;
+    float integral;
+    float output;
+    // Step response test
+    bool step_running;
+    float step_size;
+    uint32_t step_ticks;
+    uint32_t step_last_outside;
+    float step_peak;          // Largest excursion past the target, in step direction
+    float settling_time_s;
+    float overshoot_pct;
+} hold_ctrl_t;
+
+// Requests from other threads, consumed at the start of the next tick
+typedef struct {
+    uint32_t enable_mask;
+    uint32_t disable_mask;
+    uint32_t step_mask;
+    uint32_t gains_mask;
+    float step_delta[HOLD_COUNT];
+    pid_gains_t gains[HOLD_COUNT];
+} hold_requests_t;
+
+static hold_ctrl_t ctrl[HOLD_COUNT];
+static hold_requests_t pending;
+static hold_status_t published[HOLD_COUNT];
+static struct k_spinlock hold_lock;
+
+// Per-tick cost
+static uint32_t cost_max_cycles;
+static uint64_t cost_total_cycles;
+static uint32_t cost_ticks;
+
+static const pid_gains_t default_gains[HOLD_COUNT] = {
+    [HOLD_DEPTH]   = { .kp = 4.0f,  .ki = 0.3f,   .kd = 3.0f,  .integral_limit = 0.4f, .output_limit = 1.0f },
+    [HOLD_HEADING] = { .kp = 0.05f, .ki = 0.005f, .kd = 0.02f, .integral_limit = 0.2f, .output_limit = 0.8f },
+};
+
+static inline float clampf(float value, float limit)
+{
+    return fmaxf(-limit, fminf(value, limit));
+}
+
+// Wrap an angle difference into -180..+180 degrees
+static inline float wrap_deg(float angle)
+{
+    while (angle > 180.0f) {
+        angle -= 360.0f;
+    }
+    while (angle < -180.0f) {
+        angle += 360.0f;
+    }
+    return angle;
+}
+
+/**
+ * PID step with derivative on measurement and conditional-integration anti-windup
+ * @param c: Controller state
+ * @param error: Setpoint minus measurement
+ * @param measurement_rate: Rate of change of the measurement (units/s)
+ * @return: Controller output, clamped to the output limit
+ */
+static float pid_update(hold_ctrl_t *c, float error, float measurement_rate)
+{
+    const pid_gains_t *g = &c->gains;
+
+    // Derivative on the filtered measurement rate: no kick on setpoint nudges,
+    // and sensor noise is not amplified into the output
+    c->rate_filtered += HOLD_DERIV_ALPHA * (measurement_rate - c->rate_filtered);
+
+    float p = g->kp * error;
+    float d = -g->kd * c->rate_filtered;
+    float unsaturated = p + c->integral + d;
+    float output = clampf(unsaturated, g->output_limit);
+
+    // Only integrate while not saturated, or when the error unwinds saturation
+    if (output == unsaturated || (unsaturated > 0.0f) != (error > 0.0f)) {
+        c->integral = clampf(c->integral + g->ki * error * HOLD_DT_S, g->integral_limit);
+    }
+
+    return output;
+}
+
+static void hold_engage(hold_ctrl_t *c, float measurement)
+{
+    c->enabled = true;
+    c->setpoint = measurement;
+    c->prev_measurement = measurement;
+    c->rate_filtered = 0.0f;
+    c->integral = 0.0f;
+    c->output = 0.0f;
+}
+
+static void hold_step_track(hold_axis_t axis, hold_ctrl_t *c, float error)
+{
+    float band = fmaxf(fabsf(c->step_size) * HOLD_STEP_BAND_PCT, step_min_band[axis]);
+
+    c->step_ticks++;
+    if (fabsf(error) > band) {
+        c->step_last_outside = c->step_ticks;
+    }
+
+    // Overshoot = excursion past the target in the direction of the step
+    float past_target = (c->step_size > 0.0f) ? -error : error;
+    c->step_peak = fmaxf(c->step_peak, past_target);
+
+    if (c->step_ticks >= HOLD_STEP_WINDOW_S * ROV_CONTROL_RATE_HZ) {
+        c->step_running = false;
+        c->overshoot_pct = 100.0f * c->step_peak / fabsf(c->step_size);
+        c->settling_time_s = (c->step_last_outside < c->step_ticks) ?
+                             (float)c->step_last_outside * HOLD_DT_S : -1.0f;
+
+        LOG_INF("Hold %s step %.2f: settling %.2f s, overshoot %.1f%%",
+                hold_names[axis], (double)c->step_size,
+                (double)c->settling_time_s, (double)c->overshoot_pct);
+    }
+}
+
+/**
+ * Initialize the hold controllers (all disabled)
+ */
+void hold_init(void)
+{
+    memset(ctrl, 0, sizeof(ctrl));
+    memset(&pending, 0, sizeof(pending));
+    for (int i = 0; i < HOLD_COUNT; i++) {
+        ctrl[i].gains = default_gains[i];
+        ctrl[i].settling_time_s = -1.0f;
+    }
+
+    LOG_INF("Depth/heading hold controllers ready (disabled)");
+}
+
+/**
+ * Request a hold mode on or off
+ * @param axis: Hold controller
+ * @param enable: true to engage at the current measurement
+ * @return: 0 on success, -EINVAL on bad axis
+ */
+int hold_enable(hold_axis_t axis, bool enable)
+{
+    if (axis >= HOLD_COUNT) {
+        return -EINVAL;
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&hold_lock);
+    if (enable) {
+        pending.enable_mask |= BIT(axis);
+        pending.disable_mask &= ~BIT(axis);
+    } else {
+        pending.disable_mask |= BIT(axis);
+        pending.enable_mask &= ~BIT(axis);
+    }
+    k_spin_unlock(&hold_lock, key);
+    return 0;
+}
+
+/**
+ * Start a step response test: engage the hold and move its setpoint by delta
+ * @param axis: Hold controller
+ * @param delta: Step size (m for depth, deg for heading)
+ * @return: 0 on success, -EINVAL on bad arguments
+ */
+int hold_step(hold_axis_t axis, float delta)
+{
+    if (axis >= HOLD_COUNT || delta == 0.0f) {
+        return -EINVAL;
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&hold_lock);
+    pending.step_mask |= BIT(axis);
+    pending.step_delta[axis] = delta;
+    k_spin_unlock(&hold_lock, key);
+    return 0;
+}
+
+/**
+ * Change PID gains, applied on the next tick
+ * @param axis: Hold controller
+ * @param gains: New gains
+ * @return: 0 on success, -EINVAL on bad arguments
+ */
+int hold_set_gains(hold_axis_t axis, const pid_gains_t *gains)
+{
+    if (axis >= HOLD_COUNT || gains->output_limit <= 0.0f || gains->output_limit > 1.0f ||
+        gains->integral_limit < 0.0f) {
+        return -EINVAL;
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&hold_lock);
+    pending.gains_mask |= BIT(axis);
+    pending.gains[axis] = *gains;
+    k_spin_unlock(&hold_lock, key);
+    return 0;
+}
+
+/**
+ * Read the gains of a hold controller (pending changes included)
+ */
+void hold_get_gains(hold_axis_t axis, pid_gains_t *gains)
+{
+    k_spinlock_key_t key = k_spin_lock(&hold_lock);
+    *gains = (pending.gains_mask & BIT(axis)) ? pending.gains[axis] : ctrl[axis].gains;
+    k_spin_unlock(&hold_lock, key);
+}
+
+/**
+ * Snapshot the state of a hold controller as of the last tick
+ */
+void hold_get_status(hold_axis_t axis, hold_status_t *status)
+{
+    k_spinlock_key_t key = k_spin_lock(&hold_lock);
+    *status = published[axis];
+    k_spin_unlock(&hold_lock, key);
+}
+
+/**
+ * Per-tick cost of the hold controllers
+ */
+void hold_get_cost(uint32_t *max_cycles, uint32_t *mean_cycles)
+{
+    k_spinlock_key_t key = k_spin_lock(&hold_lock);
+    *max_cycles = cost_max_cycles;
+    *mean_cycles = cost_ticks ? (uint32_t)(cost_total_cycles / cost_ticks) : 0;
+    k_spin_unlock(&hold_lock, key);
+}
+
+/**
+ * Run depth and heading hold for one control tick
+ * @param axes: Filtered pilot axes; heave/yaw are replaced when a hold is active
+ * @param feedback: Latest depth and heading measurements
+ */
+void hold_update(float axes[ROV_AXIS_COUNT], const hold_feedback_t *feedback)
+{
+    uint32_t start = rov_cycles_now();
+    hold_requests_t req;
+
+    // Take pending requests in one short critical section
+    k_spinlock_key_t key = k_spin_lock(&hold_lock);
+    req = pending;
+    pending.enable_mask = 0;
+    pending.disable_mask = 0;
+    pending.step_mask = 0;
+    pending.gains_mask = 0;
+    k_spin_unlock(&hold_lock, key);
+
+    const float measurement[HOLD_COUNT] = { feedback->depth_m, feedback->heading_deg };
+    const bool valid[HOLD_COUNT] = { feedback->depth_valid, feedback->heading_valid };
+
+    for (int i = 0; i < HOLD_COUNT; i++) {
+        hold_ctrl_t *c = &ctrl[i];
+
+        if (req.gains_mask & BIT(i)) {
+            c->gains = req.gains[i];
+        }
+        if (req.disable_mask & BIT(i)) {
+            c->enabled = false;
+            c->step_running = false;
+        }
+        if (!valid[i]) {
+            // Lost the sensor: fall back to open-loop pilot control
+            c->enabled = false;
+            c->step_running = false;
+            continue;
+        }
+        if ((req.enable_mask | req.step_mask) & BIT(i) && !c->enabled) {
+            hold_engage(c, measurement[i]);
+        }
+        if (req.step_mask & BIT(i)) {
+            c->setpoint += req.step_delta[i];
+            c->step_running = true;
+            c->step_size = req.step_delta[i];
+            c->step_ticks = 0;
+            c->step_last_outside = 0;
+            c->step_peak = 0.0f;
+        }
+        c->measurement = measurement[i];
+    }
+
+    hold_ctrl_t *depth = &ctrl[HOLD_DEPTH];
+    if (depth->enabled) {
+        // Stick up (+heave) makes the target shallower, unless a step test runs
+        if (!depth->step_running) {
+            depth->setpoint -= axes[ROV_AXIS_HEAVE] * DEPTH_NUDGE_MPS * HOLD_DT_S;
+            depth->setpoint = fmaxf(depth->setpoint, 0.0f);
+        }
+        float error = depth->setpoint - depth->measurement;
+        float rate = (depth->measurement - depth->prev_measurement) / HOLD_DT_S;
+        depth->prev_measurement = depth->measurement;
+
+        // Too shallow (positive error) needs downward thrust, i.e. negative heave
+        depth->output = pid_update(depth, error, rate);
+        axes[ROV_AXIS_HEAVE] = -depth->output;
+
+        if (depth->step_running) {
+            hold_step_track(HOLD_DEPTH, depth, error);
+        }
+    }
+
+    hold_ctrl_t *heading = &ctrl[HOLD_HEADING];
+    if (heading->enabled) {
+        if (!heading->step_running) {
+            heading->setpoint += axes[ROV_AXIS_YAW] * HEADING_NUDGE_DPS * HOLD_DT_S;
+        }
+        heading->setpoint = fmodf(heading->setpoint + 360.0f, 360.0f);
+        float error = wrap_deg(heading->setpoint - heading->measurement);
+        float rate = wrap_deg(heading->measurement - heading->prev_measurement) / HOLD_DT_S;
+        heading->prev_measurement = heading->measurement;
+
+        // Positive yaw turns clockwise, increasing the heading
+        heading->output = pid_update(heading, error, rate);
+        axes[ROV_AXIS_YAW] = heading->output;
+
+        if (heading->step_running) {
+            hold_step_track(HOLD_HEADING, heading, error);
+        }
+    }
+
+    uint32_t cycles = rov_cycles_now() - start;
+
+    // Publish status for the shell
+    key = k_spin_lock(&hold_lock);
+    for (int i = 0; i < HOLD_COUNT; i++) {
+        hold_status_t *s = &published[i];
+
+        s->enabled = ctrl[i].enabled;
+        s->setpoint = ctrl[i].setpoint;
+        s->measurement = ctrl[i].measurement;
+        s->output = ctrl[i].output;
+        s->integral = ctrl[i].integral;
+        s->step_running = ctrl[i].step_running;
+        s->step_size = ctrl[i].step_size;
+        s->settling_time_s = ctrl[i].settling_time_s;
+        s->overshoot_pct = ctrl[i].overshoot_pct;
+    }
+    cost_max_cycles = MAX(cost_max_cycles, cycles);
+    cost_total_cycles += cycles;
+    cost_ticks++;
+    k_spin_unlock(&hold_lock, key);
+}
+
+static int hold_axis_from_name(const char *name)
+{
+    for (int i = 0; i < HOLD_COUNT; i++) {
+        if (strcmp(name, hold_names[i]) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static int cmd_hold_status(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    for (int i = 0; i < HOLD_COUNT; i++) {
+        hold_status_t s;
+
+        hold_get_status(i, &s);
+        shell_print(sh, "%-7s %s  sp %.2f  meas %.2f  out %+.3f  i %+.3f",
+                    hold_names[i], s.enabled ? "ON " : "off",
+                    (double)s.setpoint, (double)s.measurement,
+                    (double)s.output, (double)s.integral);
+        if (s.step_running) {
+            shell_print(sh, "        step %.2f running...", (double)s.step_size);
+        } else if (s.step_size != 0.0f) {
+            shell_print(sh, "        last step %.2f: settling %.2f s, overshoot %.1f%%",
+                        (double)s.step_size, (double)s.settling_time_s,
+                        (double)s.overshoot_pct);
+        }
+    }
+
+    uint32_t max_cycles, mean_cycles;
+    hold_get_cost(&max_cycles, &mean_cycles);
+    shell_print(sh, "cost per tick: mean %u cycles (%u ns), max %u cycles (%u ns)",
+                mean_cycles, rov_cycles_to_ns(mean_cycles),
+                max_cycles, rov_cycles_to_ns(max_cycles));
+    return 0;
+}
+
+static int cmd_hold_switch(const struct shell *sh, size_t argc, char **argv, bool enable)
+{
+    int axis = hold_axis_from_name(argv[1]);
+
+    if (axis < 0) {
+        shell_error(sh, "Unknown hold: %s (depth|heading)", argv[1]);
+        return -EINVAL;
+    }
+    return hold_enable(axis, enable);
+}
+
+static int cmd_hold_on(const struct shell *sh, size_t argc, char **argv)
+{
+    return cmd_hold_switch(sh, argc, argv, true);
+}
+
+static int cmd_hold_off(const struct shell *sh, size_t argc, char **argv)
+{
+    return cmd_hold_switch(sh, argc, argv, false);
+}
+
+static int cmd_hold_step(const struct shell *sh, size_t argc, char **argv)
+{
+    int axis = hold_axis_from_name(argv[1]);
+
+    if (axis < 0 || hold_step(axis, strtof(argv[2], NULL)) != 0) {
+        shell_error(sh, "Usage: step <depth|heading> <delta>");
+        return -EINVAL;
+    }
+    shell_print(sh, "Step test started, results in %d s", HOLD_STEP_WINDOW_S);
+    return 0;
+}
+
+static int cmd_hold_gains(const struct shell *sh, size_t argc, char **argv)
+{
+    int axis = hold_axis_from_name(argv[1]);
+    pid_gains_t gains;
+
+    if (axis < 0) {
+        shell_error(sh, "Unknown hold: %s (depth|heading)", argv[1]);
+        return -EINVAL;
+    }
+
+    hold_get_gains(axis, &gains);
+    if (argc == 2) {
+        shell_print(sh, "kp %.4f  ki %.4f  kd %.4f  ilim %.2f  olim %.2f",
+                    (double)gains.kp, (double)gains.ki, (double)gains.kd,
+                    (double)gains.integral_limit, (double)gains.output_limit);
+        return 0;
+    }
+    if (argc != 5 && argc != 7) {
+        shell_error(sh, "Usage: gains <depth|heading> [kp ki kd [ilim olim]]");
+        return -EINVAL;
+    }
+
+    gains.kp = strtof(argv[2], NULL);
+    gains.ki = strtof(argv[3], NULL);
+    gains.kd = strtof(argv[4], NULL);
+    if (argc == 7) {
+        gains.integral_limit = strtof(argv[5], NULL);
+        gains.output_limit = strtof(argv[6], NULL);
+    }
+    return hold_set_gains(axis, &gains);
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(hold_cmds,
+    SHELL_CMD(status, NULL, "Show hold controllers and per-tick cost", cmd_hold_status),
+    SHELL_CMD_ARG(on, NULL, "<depth|heading>", cmd_hold_on, 2, 0),
+    SHELL_CMD_ARG(off, NULL, "<depth|heading>", cmd_hold_off, 2, 0),
+    SHELL_CMD_ARG(step, NULL, "<depth|heading> <delta> Step response test", cmd_hold_step, 3, 0),
+    SHELL_CMD_ARG(gains, NULL, "<depth|heading> [kp ki kd [ilim olim]]", cmd_hold_gains, 2, 5),
+    SHELL_SUBCMD_SET_END
+);
+
+SHELL_SUBCMD_ADD((rov), hold, &hold_cmds, "Depth and heading hold", NULL, 1, 0);
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <zephyr/kernel.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "control.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Closed-loop hold modes
+typedef enum {
+    HOLD_DEPTH = 0,
+    HOLD_HEADING,
+    HOLD_COUNT
+} hold_axis_t;
+
+// PID tuning for one hold controller (output is a normalized axis command)
+typedef struct {
+    float kp;
+    float ki;
+    float kd;
+    float integral_limit;  // Anti-windup clamp on the integral term
+    float output_limit;    // Clamp on the controller output (0..1)
+} pid_gains_t;
+
+// Measurements the hold controllers close the loop on
+typedef struct {
+    float depth_m;      // Depth below surface, positive down
+    float heading_deg;  // Compass heading, 0..360
+    bool depth_valid;
+    bool heading_valid;
+} hold_feedback_t;
+
+// Snapshot of one hold controller for inspection
+typedef struct {
+    bool enabled;
+    float setpoint;
+    float measurement;
+    float output;
+    float integral;
+    // Last step response test
+    bool step_running;
+    float step_size;
+    float settling_time_s;   // < 0 if it never settled in the test window
+    float overshoot_pct;
+} hold_status_t;
+
+void hold_init(void);
+
+// Requests take effect on the next control tick
+int hold_enable(hold_axis_t axis, bool enable);
+int hold_step(hold_axis_t axis, float delta);
+int hold_set_gains(hold_axis_t axis, const pid_gains_t *gains);
+void hold_get_gains(hold_axis_t axis, pid_gains_t *gains);
+void hold_get_status(hold_axis_t axis, hold_status_t *status);
+
+// Run the hold controllers for one control tick. Pilot heave/yaw nudge the
+// setpoints of enabled holds and are replaced by the controller output.
+void hold_update(float axes[ROV_AXIS_COUNT], const hold_feedback_t *feedback);
+
+// Per-tick cost of hold_update() in CPU cycles
+void hold_get_cost(uint32_t *max_cycles, uint32_t *mean_cycles);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,221 @@
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/shell/shell.h>
+#include <zephyr/devicetree.h>
+#include <zephyr/cache.h>
+#include <zephyr/linker/linker-defs.h>
+#include <errno.h>
+
+#include "hotpath.h"
+#include "control.h"
+#include "net.h"
+#include "setpoint.h"
+#include "filter.h"
+#include "power.h"
+#include "compensation.h"
+#include "actuator.h"
+#include "cycles.h"
+
+LOG_MODULE_DECLARE(k2_app);
+
+#define HOTPATH_BENCH_ITERATIONS 1000
+
+K_THREAD_STACK_DECLARE(rov_control_stack, 2048);
+K_THREAD_STACK_DECLARE(udp_thread_stack, 2048);
+
+// Hot-path symbols reported by `rov hotpath show`
+static const struct {
+    const char *name;
+    const void *addr;
+} hot_symbols[] = {
+    { "calculate_crc32", (const void *)calculate_crc32 },
+    { "rov_send_command", (const void *)rov_send_command },
+    { "rov_6dof_control", (const void *)rov_6dof_control },
+    { "setpoint_sample", (const void *)setpoint_sample },
+    { "filter_bank_process", (const void *)filter_bank_process },
+    { "power_limit", (const void *)power_limit },
+    { "comp_apply", (const void *)comp_apply },
+    { "actuator_publish", (const void *)actuator_publish },
+    { "rov_control_stack", (const void *)rov_control_stack },
+    { "udp_thread_stack", (const void *)udp_thread_stack },
+};
+
+static bool hotpath_in_region(uintptr_t addr, uintptr_t base, size_t size)
+{
+    return addr - base < size;
+}
+
+/**
+ * Name the memory region an address lives in
+ * @param addr: Code or data address (Thumb bit ignored)
+ * @return: Region name
+ */
+static const char *hotpath_region(const void *addr)
+{
+    uintptr_t a = (uintptr_t)addr & ~(uintptr_t)1;
+
+    ARG_UNUSED(a);
+#if DT_HAS_CHOSEN(zephyr_itcm)
+    if (hotpath_in_region(a, DT_REG_ADDR(DT_CHOSEN(zephyr_itcm)),
+                          DT_REG_SIZE(DT_CHOSEN(zephyr_itcm)))) {
+        return "ITCM";
+    }
+#endif
+#if DT_HAS_CHOSEN(zephyr_dtcm)
+    if (hotpath_in_region(a, DT_REG_ADDR(DT_CHOSEN(zephyr_dtcm)),
+                          DT_REG_SIZE(DT_CHOSEN(zephyr_dtcm)))) {
+        return "DTCM";
+    }
+#endif
+#if defined(CONFIG_FLASH_BASE_ADDRESS) && !defined(CONFIG_ARCH_POSIX)
+    if (hotpath_in_region(a, CONFIG_FLASH_BASE_ADDRESS, CONFIG_FLASH_SIZE * 1024)) {
+        return "flash";
+    }
+#endif
+#if defined(CONFIG_SRAM_BASE_ADDRESS) && !defined(CONFIG_ARCH_POSIX)
+    if (hotpath_in_region(a, CONFIG_SRAM_BASE_ADDRESS, CONFIG_SRAM_SIZE * 1024)) {
+        return "SRAM";
+    }
+#endif
+    return "host";
+}
+
+static int cmd_hotpath_show(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    shell_print(sh, "hot path in TCM: %s",
+                IS_ENABLED(CONFIG_K2_HOTPATH_TCM) ? "yes" : "no (CONFIG_K2_HOTPATH_TCM=n)");
+    for (size_t i = 0; i < ARRAY_SIZE(hot_symbols); i++) {
+        shell_print(sh, "  %-20s %p  %s", hot_symbols[i].name, hot_symbols[i].addr,
+                    hotpath_region(hot_symbols[i].addr));
+    }
+
+#if defined(CONFIG_K2_HOTPATH_TCM)
+    shell_print(sh, "ITCM: %u of %u bytes (code)", (uint32_t)(__itcm_end - __itcm_start),
+                (uint32_t)DT_REG_SIZE(DT_CHOSEN(zephyr_itcm)));
+    shell_print(sh, "DTCM: %u of %u bytes (data %u, bss %u, noinit/stacks %u)",
+                (uint32_t)(__dtcm_end - __dtcm_start),
+                (uint32_t)DT_REG_SIZE(DT_CHOSEN(zephyr_dtcm)),
+                (uint32_t)(__dtcm_data_end - __dtcm_data_start),
+                (uint32_t)(__dtcm_bss_end - __dtcm_bss_start),
+                (uint32_t)(__dtcm_noinit_end - __dtcm_noinit_start));
+#endif
+    return 0;
+}
+
+/*
+ * Per-call cost of the hot-path kernels. "warm" repeats the call with the
+ * caches populated; "cold" invalidates the I- and D-caches before each
+ * call, which is closer to the control tick after the network stack ran.
+ * TCM code and data do not go through the caches, so only the flash/SRAM
+ * build slows down when cold. Build with CONFIG_K2_HOTPATH_TCM=y and =n
+ * to get the before/after numbers. Without CONFIG_CACHE_MANAGEMENT the
+ * invalidates do nothing, so no cold numbers are reported.
+ */
+typedef void (*hotpath_kernel_t)(void);
+
+static const uint8_t bench_packet[12] = {
+    0x00, 0x00, 0x00, 0x2A, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x00, 0x00,
+};
+static const float bench_axes[ROV_AXIS_COUNT] = { 0.5f, -0.25f, 0.75f, 0.1f, -0.1f, 0.3f };
+static float bench_thrust[ROV_THRUSTER_COUNT];
+static volatile uint32_t bench_sink;
+
+static void bench_crc32(void)
+{
+    bench_sink = calculate_crc32(bench_packet, sizeof(bench_packet));
+}
+
+static void bench_mixer(void)
+{
+    rov_6dof_control(bench_axes, bench_thrust);
+}
+
+static void bench_power(void)
+{
+    rov_6dof_control(bench_axes, bench_thrust);
+    bench_sink = (uint32_t)power_estimate(bench_thrust);
+}
+
+static void bench_comp(void)
+{
+    rov_6dof_control(bench_axes, bench_thrust);
+    comp_apply(bench_thrust);
+}
+
+static const struct {
+    const char *name;
+    hotpath_kernel_t fn;
+} bench_kernels[] = {
+    { "crc32 (12 B)", bench_crc32 },
+    { "mixer", bench_mixer },
+    { "mixer+power", bench_power },
+    { "mixer+comp", bench_comp },
+};
+
+static uint32_t hotpath_time(hotpath_kernel_t fn, bool cold, uint32_t *min_cycles)
+{
+    uint64_t total = 0;
+
+    *min_cycles = UINT32_MAX;
+    for (int n = 0; n < HOTPATH_BENCH_ITERATIONS; n++) {
+        unsigned int key = irq_lock();
+
+        if (cold) {
+            sys_cache_data_flush_and_invd_all();
+            sys_cache_instr_invd_all();
+        }
+
+        uint32_t start = rov_cycles_now();
+        fn();
+        uint32_t cycles = rov_cycles_now() - start;
+
+        irq_unlock(key);
+        total += cycles;
+        *min_cycles = MIN(*min_cycles, cycles);
+    }
+    return (uint32_t)(total / HOTPATH_BENCH_ITERATIONS);
+}
+
+static int cmd_hotpath_bench(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    // -ENOTSUP from either call: the caches cannot be invalidated here
+    bool can_invalidate = sys_cache_data_flush_and_invd_all() != -ENOTSUP &&
+                          sys_cache_instr_invd_all() != -ENOTSUP;
+
+    shell_print(sh, "%d calls each, CONFIG_K2_HOTPATH_TCM=%s (cycles: min / mean)",
+                HOTPATH_BENCH_ITERATIONS, IS_ENABLED(CONFIG_K2_HOTPATH_TCM) ? "y" : "n");
+    if (!can_invalidate) {
+        shell_print(sh, "No cache management (CONFIG_CACHE_MANAGEMENT), warm only");
+    }
+    for (size_t i = 0; i < ARRAY_SIZE(bench_kernels); i++) {
+        uint32_t warm_min;
+        uint32_t cold_min;
+        uint32_t warm = hotpath_time(bench_kernels[i].fn, false, &warm_min);
+
+        if (!can_invalidate) {
+            shell_print(sh, "  %-12s warm %5u / %5u", bench_kernels[i].name, warm_min, warm);
+            continue;
+        }
+
+        uint32_t cold = hotpath_time(bench_kernels[i].fn, true, &cold_min);
+
+        shell_print(sh, "  %-12s warm %5u / %5u   cold %5u / %5u",
+                    bench_kernels[i].name, warm_min, warm, cold_min, cold);
+    }
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(hotpath_cmds,
+    SHELL_CMD(show, NULL, "Where the hot-path code, data and stacks are placed", cmd_hotpath_show),
+    SHELL_CMD(bench, NULL, "Cycle cost of the hot-path kernels, warm and cold cache",
+              cmd_hotpath_bench),
+    SHELL_SUBCMD_SET_END
+);
+
+SHELL_SUBCMD_ADD((rov), hotpath, &hotpath_cmds, "Hot-path placement (ITCM/DTCM)", NULL, 1, 0);
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <zephyr/kernel.h>
+#include <zephyr/linker/section_tags.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Placement of the command and control hot path.
+ *
+ * With CONFIG_K2_HOTPATH_TCM the receive/decode/control functions run from
+ * ITCM (zero wait states, no flash or ART accelerator in the way) and their
+ * tables, working buffers and thread stacks live in DTCM (zero wait states,
+ * not behind the D-cache). The startup code copies .itcm and .dtcm_data
+ * from flash and clears .dtcm_bss. Without the option everything stays in
+ * flash and SRAM, which is the baseline for `rov hotpath bench`.
+ *
+ * ROV_HOT_RODATA is for const tables only: GCC rejects const and writable
+ * objects in the same named section of one file, so writable state goes
+ * in ROV_HOT_BSS.
+ */
+#if defined(CONFIG_K2_HOTPATH_TCM)
+#define ROV_HOT_CODE   __itcm_section __noinline
+#define ROV_HOT_RODATA __dtcm_data_section
+#define ROV_HOT_BSS    __dtcm_bss_section
+#define ROV_HOT_STACK_DEFINE(sym, size) \
+    Z_THREAD_STACK_DEFINE_IN(sym, size, __dtcm_noinit_section)
+#else
+#define ROV_HOT_CODE
+#define ROV_HOT_RODATA
+#define ROV_HOT_BSS
+#define ROV_HOT_STACK_DEFINE(sym, size) K_THREAD_STACK_DEFINE(sym, size)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
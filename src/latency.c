@@ -0,0 +1,290 @@
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/shell/shell.h>
+#include <zephyr/sys/barrier.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "latency.h"
+#include "cycles.h"
+#include "hotpath.h"
+
+LOG_MODULE_DECLARE(k2_app);
+
+#define LATENCY_SUB_BUCKETS BIT(LATENCY_SUB_BITS)
+#define LATENCY_BAR_WIDTH   40
+
+static const char *const segment_names[LATENCY_SEGMENT_COUNT] = {
+    "decode", "queue", "control", "total"
+};
+
+/*
+ * Each segment has a single writer (control thread: decode, queue; commit
+ * timer ISR: control, total), so recording takes no lock. Readers use the
+ * per-segment sequence lock and retry if a sample landed while they read;
+ * resets are requests the writer applies with its next sample.
+ */
+struct latency_slot {
+    atomic_t seq;           // Odd while the writer updates
+    latency_hist_t hist;
+};
+
+static struct latency_slot ROV_HOT_BSS slots[LATENCY_SEGMENT_COUNT];
+static atomic_t reset_pending;
+
+/**
+ * Bucket of a cycle count: exact below LATENCY_SUB_BUCKETS, then
+ * LATENCY_SUB_BUCKETS linear steps per power of two
+ */
+static inline int latency_bucket(uint32_t cycles)
+{
+    if (cycles < LATENCY_SUB_BUCKETS) {
+        return (int)cycles;
+    }
+
+    int octave = find_msb_set(cycles) - 1;
+    uint32_t step = (cycles >> (octave - LATENCY_SUB_BITS)) & (LATENCY_SUB_BUCKETS - 1);
+
+    return ((octave - LATENCY_SUB_BITS + 1) << LATENCY_SUB_BITS) + (int)step;
+}
+
+/**
+ * Lowest cycle count that falls into a bucket
+ * @param bucket: 0..LATENCY_BUCKETS (LATENCY_BUCKETS gives the end of the range)
+ * @return: Cycles, saturated at UINT32_MAX
+ */
+uint32_t latency_bucket_floor(int bucket)
+{
+    if (bucket < (int)LATENCY_SUB_BUCKETS) {
+        return (uint32_t)bucket;
+    }
+
+    int octave = (bucket >> LATENCY_SUB_BITS) + LATENCY_SUB_BITS - 1;
+    uint64_t floor = (uint64_t)(LATENCY_SUB_BUCKETS | (bucket & (LATENCY_SUB_BUCKETS - 1)))
+                   << (octave - LATENCY_SUB_BITS);
+
+    return (uint32_t)MIN(floor, UINT32_MAX);
+}
+
+/**
+ * Add one sample to a segment histogram
+ * Only from the segment's writer (see above).
+ * @param segment: Lifecycle segment
+ * @param cycles: Duration in cycle counter ticks
+ */
+ROV_HOT_CODE void latency_record(latency_segment_t segment, uint32_t cycles)
+{
+    struct latency_slot *s = &slots[segment];
+    latency_hist_t *h = &s->hist;
+    int bucket = latency_bucket(cycles);
+
+    atomic_inc(&s->seq);
+    barrier_dmem_fence_full();
+    if (atomic_get(&reset_pending) & BIT(segment)) {
+        atomic_clear_bit(&reset_pending, segment);
+        memset(h, 0, sizeof(*h));
+    }
+    h->buckets[bucket]++;
+    h->total_cycles += cycles;
+    h->min_cycles = (h->count == 0) ? cycles : MIN(h->min_cycles, cycles);
+    h->max_cycles = MAX(h->max_cycles, cycles);
+    h->count++;
+    barrier_dmem_fence_full();
+    atomic_inc(&s->seq);
+}
+
+/**
+ * Copy one segment histogram without blocking its writer
+ * @param segment: Lifecycle segment
+ * @param hist: Output copy
+ */
+void latency_get(latency_segment_t segment, latency_hist_t *hist)
+{
+    const struct latency_slot *s = &slots[segment];
+    atomic_val_t start, end;
+
+    if (atomic_test_bit(&reset_pending, segment)) {
+        memset(hist, 0, sizeof(*hist));
+        return;
+    }
+    do {
+        start = atomic_get(&s->seq);
+        barrier_dmem_fence_full();
+        *hist = s->hist;
+        barrier_dmem_fence_full();
+        end = atomic_get(&s->seq);
+    } while ((start & 1) || start != end);
+}
+
+/**
+ * Upper bound of the bucket holding a percentile
+ * @param h: Histogram with count > 0
+ * @param permille: Percentile in 0.1 % steps (500 = median)
+ * @return: Cycles, capped at the largest sample
+ */
+static uint32_t latency_percentile(const latency_hist_t *h, uint32_t permille)
+{
+    uint32_t rank = (uint32_t)(((uint64_t)h->count * permille + 999U) / 1000U);
+    uint32_t seen = 0;
+
+    for (int i = 0; i < LATENCY_BUCKETS; i++) {
+        seen += h->buckets[i];
+        if (seen >= rank) {
+            return MIN(latency_bucket_floor(i + 1) - 1, h->max_cycles);
+        }
+    }
+    return h->max_cycles;
+}
+
+/**
+ * Percentiles of every segment, computed on the live histograms (no copy)
+ * @param summary: Output, one entry per segment
+ */
+void latency_get_summary(latency_summary_t summary[LATENCY_SEGMENT_COUNT])
+{
+    for (int i = 0; i < LATENCY_SEGMENT_COUNT; i++) {
+        const struct latency_slot *slot = &slots[i];
+        const latency_hist_t *h = &slot->hist;
+        latency_summary_t *s = &summary[i];
+        uint32_t p50, p90, p99, max;
+        atomic_val_t start, end;
+
+        if (atomic_test_bit(&reset_pending, i)) {
+            memset(s, 0, sizeof(*s));
+            continue;
+        }
+        do {
+            p50 = p90 = p99 = max = 0;
+            start = atomic_get(&slot->seq);
+            barrier_dmem_fence_full();
+            s->count = h->count;
+            if (s->count > 0) {
+                p50 = latency_percentile(h, 500);
+                p90 = latency_percentile(h, 900);
+                p99 = latency_percentile(h, 990);
+                max = h->max_cycles;
+            }
+            barrier_dmem_fence_full();
+            end = atomic_get(&slot->seq);
+        } while ((start & 1) || start != end);
+
+        s->p50_ns = rov_cycles_to_ns(p50);
+        s->p90_ns = rov_cycles_to_ns(p90);
+        s->p99_ns = rov_cycles_to_ns(p99);
+        s->max_ns = rov_cycles_to_ns(max);
+    }
+}
+
+/**
+ * Clear all histograms (each writer clears its own on its next sample)
+ */
+void latency_reset(void)
+{
+    atomic_or(&reset_pending, BIT_MASK(LATENCY_SEGMENT_COUNT));
+}
+
+const char *latency_segment_name(int segment)
+{
+    return (segment >= 0 && segment < LATENCY_SEGMENT_COUNT) ? segment_names[segment] : "?";
+}
+
+static void latency_print_us(char *buf, size_t size, uint32_t cycles)
+{
+    uint32_t ns = rov_cycles_to_ns(cycles);
+
+    snprintf(buf, size, "%u.%03u", ns / 1000U, ns % 1000U);
+}
+
+static int cmd_latency_show(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    static latency_hist_t h;
+    char p50[16], p90[16], p99[16], max[16], mean[16];
+
+    shell_print(sh, "segment      count       p50       p90       p99       max      mean  (us)");
+    for (int i = 0; i < LATENCY_SEGMENT_COUNT; i++) {
+        latency_get((latency_segment_t)i, &h);
+        if (h.count == 0) {
+            shell_print(sh, "%-8s %9u", segment_names[i], 0U);
+            continue;
+        }
+        latency_print_us(p50, sizeof(p50), latency_percentile(&h, 500));
+        latency_print_us(p90, sizeof(p90), latency_percentile(&h, 900));
+        latency_print_us(p99, sizeof(p99), latency_percentile(&h, 990));
+        latency_print_us(max, sizeof(max), h.max_cycles);
+        latency_print_us(mean, sizeof(mean), (uint32_t)(h.total_cycles / h.count));
+        shell_print(sh, "%-8s %9u %9s %9s %9s %9s %9s", segment_names[i], h.count,
+                    p50, p90, p99, max, mean);
+    }
+    return 0;
+}
+
+static int cmd_latency_hist(const struct shell *sh, size_t argc, char **argv)
+{
+    static latency_hist_t h;
+    int segment = LATENCY_TOTAL;
+    uint32_t peak = 0;
+    char low[16], high[16];
+
+    if (argc > 1) {
+        for (segment = 0; segment < LATENCY_SEGMENT_COUNT; segment++) {
+            if (strcmp(argv[1], segment_names[segment]) == 0) {
+                break;
+            }
+        }
+        if (segment == LATENCY_SEGMENT_COUNT) {
+            shell_error(sh, "Segment must be decode, queue, control or total");
+            return -EINVAL;
+        }
+    }
+
+    latency_get((latency_segment_t)segment, &h);
+    if (h.count == 0) {
+        shell_print(sh, "No samples");
+        return 0;
+    }
+    for (int i = 0; i < LATENCY_BUCKETS; i++) {
+        peak = MAX(peak, h.buckets[i]);
+    }
+
+    shell_print(sh, "%s: %u samples (us)", segment_names[segment], h.count);
+    for (int i = 0; i < LATENCY_BUCKETS; i++) {
+        char bar[LATENCY_BAR_WIDTH + 1];
+        uint32_t width;
+
+        if (h.buckets[i] == 0) {
+            continue;
+        }
+        width = (uint32_t)((uint64_t)h.buckets[i] * LATENCY_BAR_WIDTH / peak);
+        memset(bar, '#', MAX(width, 1U));
+        bar[MAX(width, 1U)] = '\0';
+        latency_print_us(low, sizeof(low), latency_bucket_floor(i));
+        latency_print_us(high, sizeof(high), latency_bucket_floor(i + 1));
+        shell_print(sh, "%10s - %10s %8u %s", low, high, h.buckets[i], bar);
+    }
+    return 0;
+}
+
+static int cmd_latency_reset(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    latency_reset();
+    shell_print(sh, "Latency histograms reset");
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(latency_cmds,
+    SHELL_CMD(show, NULL, "Per-segment count and p50/p90/p99/max/mean", cmd_latency_show),
+    SHELL_CMD_ARG(hist, NULL, "[decode|queue|control|total] Histogram of one segment",
+                  cmd_latency_hist, 1, 1),
+    SHELL_CMD(reset, NULL, "Clear the histograms", cmd_latency_reset),
+    SHELL_SUBCMD_SET_END
+);
+
+SHELL_SUBCMD_ADD((rov), latency, &latency_cmds, "Packet to output latency", NULL, 1, 0);
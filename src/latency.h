@@ -0,0 +1,55 @@
+#pragma once
+
+#include <zephyr/kernel.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Command lifecycle latency: each command is stamped (cycle counter) when
+ * zsock_recvfrom() returns, when it is put on the command queue, when the
+ * control thread takes it, and when the first output frame carrying it is
+ * committed. Each segment goes into a log-bucket histogram in fixed memory.
+ */
+typedef enum {
+    LATENCY_DECODE = 0,    // recvfrom return -> k_msgq_put (CRC, decode, handoff)
+    LATENCY_QUEUE,         // k_msgq_put -> k_msgq_get in the control thread
+    LATENCY_CONTROL,       // k_msgq_get -> output commit (control tick + commit phase)
+    LATENCY_TOTAL,         // recvfrom return -> output commit
+    LATENCY_SEGMENT_COUNT
+} latency_segment_t;
+
+// Log-linear buckets: 4 per power of two (about 19 % wide) over the 32-bit cycle range
+#define LATENCY_SUB_BITS  2
+#define LATENCY_BUCKETS   ((33 - LATENCY_SUB_BITS) << LATENCY_SUB_BITS)
+
+typedef struct {
+    uint32_t count;
+    uint32_t min_cycles;
+    uint32_t max_cycles;
+    uint64_t total_cycles;
+    uint32_t buckets[LATENCY_BUCKETS];
+} latency_hist_t;
+
+// Histogram summary; percentiles are bucket upper bounds (never under-reported)
+typedef struct {
+    uint32_t count;
+    uint32_t p50_ns;
+    uint32_t p90_ns;
+    uint32_t p99_ns;
+    uint32_t max_ns;
+} latency_summary_t;
+
+void latency_record(latency_segment_t segment, uint32_t cycles);
+void latency_get(latency_segment_t segment, latency_hist_t *hist);
+void latency_get_summary(latency_summary_t summary[LATENCY_SEGMENT_COUNT]);
+void latency_reset(void);
+
+uint32_t latency_bucket_floor(int bucket);     // Lowest cycle count in a bucket
+const char *latency_segment_name(int segment);
+
+#ifdef __cplusplus
+}
+#endif
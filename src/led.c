@@ -1,10 +1,90 @@
+#include <zephyr/kernel.h>
 #include <zephyr/drivers/gpio.h>
 #include <zephyr/logging/log.h>
+#include <zephyr/shell/shell.h>
+
+#include "led.h"
 
 LOG_MODULE_DECLARE(k2_app);
 
 const struct gpio_dt_spec led = GPIO_DT_SPEC_GET(DT_ALIAS(led0), gpios);
 
+// Status bits written by the network and control paths
+atomic_t led_status = ATOMIC_INIT(0);
+
+/*
+ * Pattern engine: a timer steps through 20 slots of 50 ms. Bit n of a
+ * pattern is the LED state in slot n. At the start of each one-second
+ * cycle the highest priority status picks the pattern and the latched
+ * events are cleared, so a burst of commands or errors shows as one
+ * steady pattern instead of flicker.
+ */
+typedef struct {
+    const char *name;
+    uint32_t pattern;
+} led_pattern_t;
+
+enum {
+    LED_PATTERN_NO_LINK = 0,
+    LED_PATTERN_LINK_IDLE,
+    LED_PATTERN_COMMANDS,
+    LED_PATTERN_CRC_ERROR,
+    LED_PATTERN_FAILSAFE,
+};
+
+static const led_pattern_t patterns[] = {
+    [LED_PATTERN_NO_LINK]   = { "no link",        0x00001 },  // Short blip each second
+    [LED_PATTERN_LINK_IDLE] = { "link up, idle",  0xFFFFF },  // Solid
+    [LED_PATTERN_COMMANDS]  = { "commands",       0x33333 },  // 5 Hz blink
+    [LED_PATTERN_CRC_ERROR] = { "CRC errors",     0x00015 },  // Triple blink
+    [LED_PATTERN_FAILSAFE]  = { "failsafe",       0x55555 },  // 10 Hz blink
+};
+
+static uint32_t active_pattern = LED_PATTERN_NO_LINK;
+static uint32_t slot;
+static bool led_ready;
+
+static uint32_t led_select_pattern(void)
+{
+    // Consume the events latched during the last cycle
+    atomic_val_t status = atomic_and(&led_status,
+                                     ~(BIT(LED_EVENT_COMMAND) | BIT(LED_EVENT_CRC_ERROR)));
+
+    if (status & BIT(LED_STATUS_FAILSAFE)) {
+        return LED_PATTERN_FAILSAFE;
+    }
+    if (status & BIT(LED_EVENT_CRC_ERROR)) {
+        return LED_PATTERN_CRC_ERROR;
+    }
+    if (status & BIT(LED_EVENT_COMMAND)) {
+        return LED_PATTERN_COMMANDS;
+    }
+    if (status & BIT(LED_STATUS_LINK_UP)) {
+        return LED_PATTERN_LINK_IDLE;
+    }
+    return LED_PATTERN_NO_LINK;
+}
+
+/**
+ * Pattern timer expiry (ISR context): output one slot
+ */
+static void led_timer_handler(struct k_timer *timer)
+{
+    ARG_UNUSED(timer);
+
+    if (slot == 0) {
+        active_pattern = led_select_pattern();
+    }
+
+    gpio_pin_set_dt(&led, (patterns[active_pattern].pattern >> slot) & 1);
+
+    if (++slot >= LED_SLOTS) {
+        slot = 0;
+    }
+}
+
+K_TIMER_DEFINE(led_timer, led_timer_handler, NULL);
+
 void led_init(void)
 {
     if (!gpio_is_ready_dt(&led)) {
@@ -17,6 +97,32 @@ void led_init(void)
         LOG_ERR("Failed to configure LED GPIO: %d", ret);
     } else {
         gpio_pin_set_dt(&led, 0);
-        LOG_INF("LED initialized successfully on pin PA5");
+        led_ready = true;
+        k_timer_start(&led_timer, K_MSEC(LED_SLOT_MS), K_MSEC(LED_SLOT_MS));
+        LOG_INF("LED initialized successfully on pin PA5 (status patterns)");
     }
 }
+
+static int cmd_led_show(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    atomic_val_t status = atomic_get(&led_status);
+
+    shell_print(sh, "pattern: %s%s", patterns[active_pattern].name,
+                led_ready ? "" : " (LED not ready)");
+    shell_print(sh, "link %s  failsafe %s  pending events:%s%s",
+                (status & BIT(LED_STATUS_LINK_UP)) ? "up" : "down",
+                (status & BIT(LED_STATUS_FAILSAFE)) ? "on" : "off",
+                (status & BIT(LED_EVENT_COMMAND)) ? " command" : "",
+                (status & BIT(LED_EVENT_CRC_ERROR)) ? " crc" : "");
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(led_cmds,
+    SHELL_CMD(show, NULL, "Show the status LED pattern", cmd_led_show),
+    SHELL_SUBCMD_SET_END
+);
+
+SHELL_SUBCMD_ADD((rov), led, &led_cmds, "Status LED", NULL, 1, 0);
@@ -1,14 +1,45 @@
 #pragma once
 
 #include <zephyr/drivers/gpio.h>
+#include <zephyr/sys/atomic.h>
+#include <stdbool.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/*
+ * Status shown on the LED. Levels stay set until cleared; events are
+ * latched and consumed by the pattern engine once per pattern cycle.
+ */
+enum led_status_bit {
+    LED_STATUS_LINK_UP = 0,     // Level: network interface up
+    LED_STATUS_FAILSAFE,        // Level: command link lost, outputs neutral
+    LED_EVENT_COMMAND,          // Event: a command was received
+    LED_EVENT_CRC_ERROR,        // Event: a packet failed its CRC check
+    LED_STATUS_BIT_COUNT
+};
+
+// Pattern slot length and slots per pattern cycle (one second)
+#define LED_SLOT_MS      50
+#define LED_SLOTS        20
+
 extern const struct gpio_dt_spec led;
+extern atomic_t led_status;
+
 void led_init(void);
 
+// Hot-path safe: a single atomic operation, no driver call
+static inline void led_status_set(enum led_status_bit bit, bool value)
+{
+    atomic_set_bit_to(&led_status, bit, value);
+}
+
+static inline void led_status_event(enum led_status_bit bit)
+{
+    atomic_set_bit(&led_status, bit);
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,317 @@
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/shell/shell.h>
+#include <errno.h>
+#include <math.h>
+#include <stdlib.h>
+
+#include "light.h"
+#if defined(CONFIG_ARCH_POSIX)
+#include "actuator.h"
+#endif
+
+LOG_MODULE_DECLARE(k2_app);
+
+#define LIGHT_FADE_PERIOD_MS (1000 / LIGHT_FADE_RATE_HZ)
+#define LIGHT_DUTY_MAX       65535
+
+/*
+ * Light dimming engine.
+ *
+ * The 0-255 brightness command is mapped through a gamma lookup table to
+ * a 16-bit duty target. A low-rate work item ramps the output duty toward
+ * the target and stops rescheduling once it gets there. The command path
+ * only stores the target, and the control tick only loads the current duty,
+ * so neither pays for the fade. The PWM timer latches the duty on its next
+ * period.
+ *
+ * Two gamma tables exist: the command path reads the active one without a
+ * lock while a gamma change fills the other and publishes it with a single
+ * atomic index swap.
+ */
+
+static uint16_t gamma_luts[2][256];
+static atomic_t active_lut = ATOMIC_INIT(0);
+static float gamma_value = LIGHT_DEFAULT_GAMMA;
+K_MUTEX_DEFINE(light_config_lock);   // Serializes LUT rebuilds and fade changes
+
+static atomic_t command_level = ATOMIC_INIT(0);
+static atomic_t target_duty = ATOMIC_INIT(0);
+static atomic_t output_duty = ATOMIC_INIT(0);
+static atomic_t fade_step = ATOMIC_INIT(0);   // Duty change per fade period
+static uint32_t fade_ms = LIGHT_DEFAULT_FADE_MS;
+
+static void light_fade_handler(struct k_work *work);
+K_WORK_DELAYABLE_DEFINE(light_fade_work, light_fade_handler);
+
+static void light_build_lut(uint16_t lut[256], float gamma)
+{
+    for (int i = 0; i < 256; i++) {
+        lut[i] = (uint16_t)(powf(i / 255.0f, gamma) * LIGHT_DUTY_MAX + 0.5f);
+    }
+}
+
+static atomic_val_t light_fade_step_for(uint32_t ms)
+{
+    if (ms < LIGHT_FADE_PERIOD_MS) {
+        return LIGHT_DUTY_MAX;   // Jump in one step
+    }
+    return MAX(1, (atomic_val_t)((uint64_t)LIGHT_DUTY_MAX * LIGHT_FADE_PERIOD_MS / ms));
+}
+
+/**
+ * Fade work item: move the output one step toward the target
+ */
+static void light_fade_handler(struct k_work *work)
+{
+    ARG_UNUSED(work);
+
+    atomic_val_t target = atomic_get(&target_duty);
+    atomic_val_t duty = atomic_get(&output_duty);
+    atomic_val_t step = atomic_get(&fade_step);
+
+    if (duty < target) {
+        duty = MIN(duty + step, target);
+    } else if (duty > target) {
+        duty = MAX(duty - step, target);
+    }
+    atomic_set(&output_duty, duty);
+
+    if (duty != target) {
+        k_work_schedule(&light_fade_work, K_MSEC(LIGHT_FADE_PERIOD_MS));
+    }
+}
+
+/**
+ * Initialize the light engine (off, default gamma and fade time)
+ */
+void light_init(void)
+{
+    atomic_set(&active_lut, 0);
+    light_build_lut(gamma_luts[0], gamma_value);
+    atomic_set(&fade_step, light_fade_step_for(fade_ms));
+    atomic_set(&command_level, 0);
+    atomic_set(&target_duty, 0);
+    atomic_set(&output_duty, 0);
+
+    LOG_INF("Light: gamma %.1f, %u ms full-range fade at %d Hz",
+            (double)gamma_value, fade_ms, LIGHT_FADE_RATE_HZ);
+}
+
+/**
+ * Set a new brightness target, faded to by the work item
+ * @param brightness: 0 (off) to 255 (full)
+ * @return: true if the target changed
+ */
+bool light_set(uint8_t brightness)
+{
+    if (atomic_set(&command_level, brightness) == brightness) {
+        return false;
+    }
+
+    // Map again if a gamma change swapped tables meanwhile, so a re-map by
+    // light_set_gamma is never overwritten with a value from the old table
+    atomic_val_t lut;
+    do {
+        lut = atomic_get(&active_lut);
+        atomic_set(&target_duty, gamma_luts[lut][brightness]);
+    } while (atomic_get(&active_lut) != lut);
+
+    // No-op if a fade step is already pending; it picks up the new target
+    k_work_schedule(&light_fade_work, K_NO_WAIT);
+    return true;
+}
+
+/**
+ * Current light output
+ * @return: Duty cycle, 0.0 to 1.0
+ */
+float light_get_output(void)
+{
+    return (float)atomic_get(&output_duty) * (1.0f / LIGHT_DUTY_MAX);
+}
+
+/**
+ * Set the time for a full-range fade
+ * @param ms: Fade time in milliseconds (0 = switch instantly)
+ * @return: 0 on success, -EINVAL if out of range
+ */
+int light_set_fade_ms(uint32_t ms)
+{
+    if (ms > 60000) {
+        return -EINVAL;
+    }
+
+    k_mutex_lock(&light_config_lock, K_FOREVER);
+    fade_ms = ms;
+    atomic_set(&fade_step, light_fade_step_for(ms));
+    k_mutex_unlock(&light_config_lock);
+    return 0;
+}
+
+/**
+ * Set the gamma of the brightness curve and re-map the current command
+ * @param gamma: Exponent, 1.0 (linear) to 4.0
+ * @return: 0 on success, -EINVAL if out of range
+ */
+int light_set_gamma(float gamma)
+{
+    if (!(gamma >= 1.0f && gamma <= 4.0f)) {
+        return -EINVAL;
+    }
+
+    k_mutex_lock(&light_config_lock, K_FOREVER);
+
+    int active = atomic_get(&active_lut);
+
+    gamma_value = gamma;
+    light_build_lut(gamma_luts[!active], gamma);
+
+    // Publish, then re-map the current command through the new table
+    atomic_set(&active_lut, !active);
+    atomic_set(&target_duty, gamma_luts[!active][atomic_get(&command_level)]);
+    k_work_schedule(&light_fade_work, K_NO_WAIT);
+    k_mutex_unlock(&light_config_lock);
+    return 0;
+}
+
+/**
+ * Get the current state of the light engine
+ * @param status: Output snapshot
+ */
+void light_get_status(light_status_t *status)
+{
+    k_mutex_lock(&light_config_lock, K_FOREVER);
+    status->fade_ms = fade_ms;
+    status->gamma = gamma_value;
+    k_mutex_unlock(&light_config_lock);
+
+    status->command = (uint8_t)atomic_get(&command_level);
+    status->target_duty = (uint16_t)atomic_get(&target_duty);
+    status->duty = (uint16_t)atomic_get(&output_duty);
+    status->fading = status->duty != status->target_duty;
+}
+
+static int cmd_light_show(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    light_status_t s;
+    light_get_status(&s);
+
+    shell_print(sh, "command %u/255  target %.1f%%  output %.1f%%%s",
+                s.command, (double)(s.target_duty * 100.0f / LIGHT_DUTY_MAX),
+                (double)(s.duty * 100.0f / LIGHT_DUTY_MAX), s.fading ? "  (fading)" : "");
+    shell_print(sh, "gamma %.2f  fade %u ms", (double)s.gamma, s.fade_ms);
+    return 0;
+}
+
+static int cmd_light_set(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+
+    long value = strtol(argv[1], NULL, 10);
+
+    if (value < 0 || value > 255) {
+        shell_error(sh, "Brightness must be 0..255");
+        return -EINVAL;
+    }
+    light_set((uint8_t)value);
+    return 0;
+}
+
+static int cmd_light_fade(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+
+    if (light_set_fade_ms(strtoul(argv[1], NULL, 10)) != 0) {
+        shell_error(sh, "Fade time must be 0..60000 ms");
+        return -EINVAL;
+    }
+    return 0;
+}
+
+static int cmd_light_gamma(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+
+    if (light_set_gamma(strtof(argv[1], NULL)) != 0) {
+        shell_error(sh, "Gamma must be 1.0..4.0");
+        return -EINVAL;
+    }
+    return 0;
+}
+
+#if defined(CONFIG_ARCH_POSIX)
+/*
+ * Drive a fade and check what reached the (fake) outputs: the light ramps
+ * monotonically, lands on the gamma-corrected target within the fade
+ * time, and a command of 0 turns it fully off.
+ */
+static bool light_check_fade(const struct shell *sh, uint8_t from, uint8_t to)
+{
+    const uint32_t settle_ms = fade_ms + 4 * LIGHT_FADE_PERIOD_MS;
+    const uint16_t *lut = gamma_luts[atomic_get(&active_lut)];
+    const float expected = lut[to] * (1.0f / LIGHT_DUTY_MAX);
+    actuator_record_t rec;
+    uint32_t start_count;
+    uint32_t frames;
+    float prev = lut[from] * (1.0f / LIGHT_DUTY_MAX);
+    bool rising = to > from;
+    bool ok = true;
+
+    light_set(from);
+    k_msleep(settle_ms);
+
+    start_count = actuator_fake_count();
+    light_set(to);
+    k_msleep(settle_ms);
+    frames = MIN(actuator_fake_count() - start_count, 255U);
+
+    for (uint32_t age = frames; age-- > 0;) {
+        if (actuator_fake_get(age, &rec) != 0) {
+            continue;
+        }
+        if (rising ? rec.frame.light < prev : rec.frame.light > prev) {
+            ok = false;
+        }
+        prev = rec.frame.light;
+    }
+
+    ok = ok && frames > 0 && fabsf(prev - expected) < 1e-4f;
+    shell_print(sh, "%3u -> %3u: %u frames, final %.4f (expected %.4f) %s",
+                from, to, frames, (double)prev, (double)expected, ok ? "ok" : "FAIL");
+    return ok;
+}
+
+static int cmd_light_test(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    uint8_t restore = (uint8_t)atomic_get(&command_level);
+    bool ok = true;
+
+    ok &= light_check_fade(sh, 0, 255);
+    ok &= light_check_fade(sh, 255, 128);
+    ok &= light_check_fade(sh, 128, 0);
+    light_set(restore);
+
+    shell_print(sh, "light test %s", ok ? "passed" : "FAILED");
+    return ok ? 0 : -EIO;
+}
+#endif
+
+SHELL_STATIC_SUBCMD_SET_CREATE(light_cmds,
+    SHELL_CMD(show, NULL, "Show light command, target and output", cmd_light_show),
+    SHELL_CMD_ARG(set, NULL, "<0-255> Set brightness", cmd_light_set, 2, 0),
+    SHELL_CMD_ARG(fade, NULL, "<ms> Full-range fade time", cmd_light_fade, 2, 0),
+    SHELL_CMD_ARG(gamma, NULL, "<gamma> Brightness curve exponent", cmd_light_gamma, 2, 0),
+#if defined(CONFIG_ARCH_POSIX)
+    SHELL_CMD(test, NULL, "Fade test against the fake outputs", cmd_light_test),
+#endif
+    SHELL_SUBCMD_SET_END
+);
+
+SHELL_SUBCMD_ADD((rov), light, &light_cmds, "Light dimming", NULL, 1, 0);
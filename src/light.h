@@ -0,0 +1,44 @@
+#pragma once
+
+#include <zephyr/kernel.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Fade engine step rate (work item, independent of the control tick)
+#define LIGHT_FADE_RATE_HZ 100
+
+// Default time for a full 0 -> 255 fade
+#define LIGHT_DEFAULT_FADE_MS 250
+
+// Default perceptual gamma for the brightness command
+#define LIGHT_DEFAULT_GAMMA 2.2f
+
+void light_init(void);
+
+// Command path: new brightness target (0 = off). Returns true if it changed.
+bool light_set(uint8_t brightness);
+
+// Control tick: current output duty (0.0 to 1.0), a single atomic load
+float light_get_output(void);
+
+int light_set_fade_ms(uint32_t fade_ms);
+int light_set_gamma(float gamma);
+
+typedef struct {
+    uint8_t command;        // Last brightness command
+    uint16_t target_duty;   // Gamma-corrected target (0..65535)
+    uint16_t duty;          // Current output (0..65535)
+    uint32_t fade_ms;
+    float gamma;
+    bool fading;
+} light_status_t;
+
+void light_get_status(light_status_t *status);
+
+#ifdef __cplusplus
+}
+#endif
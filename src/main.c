@@ -16,11 +16,14 @@
 #include <zephyr/kernel.h>
 #include <zephyr/drivers/gpio.h>
 #include <zephyr/logging/log.h>
-#include <zephyr/net/socket.h> // added for zsock_close
 #include <stdint.h>
 #include "led.h"
 #include "net.h"
 #include "control.h"
+#include "sensors.h"
+#include "telemetry.h"
+#include "stackmon.h"
+#include "health.h"
 
 // Register this source file as a log module named "k2_app" with INFO level
 // This allows us to use LOG_INF(), LOG_ERR(), etc. in our code
@@ -53,48 +56,34 @@ int main(void)
     // Initialize ROV control system
     rov_control_init();
     
+    // Find the sensors and set up their sample rings
+    sensors_init();
+    
     // Initialize networking
     network_init();
+    telemetry_init();
 
-    // Start ROV control thread
+    // Start sensor sampling, then the ROV control thread that consumes it
+    sensors_start();
     rov_control_start();
     
-    // Start UDP server thread
+    // Start UDP server thread, and the telemetry uplink back to the pilot
     udp_server_start();
+    telemetry_start();
+
+    // Stack high-water marks of every thread, for rov stack show
+    stackmon_start();
 
     /*
      * MAIN APPLICATION LOOP
      * 
-     * Monitor network status and UDP server operation
-     * No LED blinking - UDP server now processes structured packets silently
+     * The main thread becomes the health supervisor: it checks that the
+     * control loop keeps ticking, feeds the hardware watchdog while it does,
+     * and gathers the health record for telemetry and the log (src/health.c)
      */
-
-    //uint32_t loop_count = 0; // Count main loop iterations
-    
-    LOG_INF("Starting main loop");
     LOG_INF("UDP server will validate structured packets (sequence + payload + CRC32)");
     LOG_INF("Payload will be forwarded to ROV control system");
     
-    while (1) {  // Infinite loop - runs forever
-        
-        // Increment counter and log current state
-        //loop_count++;
-        
-        if (network_ready) {
-            //LOG_INF("Loop #%u: Network ready, UDP server processing packets", loop_count);
-            LOG_INF("Network ready, UDP server processing packets");
-        } else {
-            //LOG_INF("Loop #%u: Waiting for network...", loop_count);
-            LOG_INF("Network not ready, waiting...");
-        }
-
-        // Sleep for 10 seconds (longer interval for status updates)
-        k_sleep(K_SECONDS(10));
-    }
-    
-    // Cleanup (never reached in embedded systems)
-    if (udp_sock >= 0) {
-        zsock_close(udp_sock);
-    }
+    health_run();  // Never returns
     return 0;
-}
\ No newline at end of file
+}
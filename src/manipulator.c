@@ -0,0 +1,280 @@
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/shell/shell.h>
+#include <errno.h>
+#include <math.h>
+#include <stdlib.h>
+
+#include "manipulator.h"
+#include "control.h"
+#include "cycles.h"
+
+LOG_MODULE_DECLARE(k2_app);
+
+#define MANIPULATOR_DT_S (1.0f / ROV_CONTROL_RATE_HZ)
+
+// Brake + accelerate + cruise + decelerate
+#define MANIPULATOR_MAX_SEGMENTS 4
+
+// Target handoff: 16-bit position plus a "new target" flag in one atomic
+#define TARGET_PENDING 0x10000
+#define TARGET_SCALE   65535.0f
+
+/*
+ * Trapezoidal motion profile for the manipulator servo.
+ *
+ * A new target is planned once, at the start of the next control tick,
+ * from the current position and velocity. Planning splits the move into
+ * at most four constant-acceleration segments: brake if moving away or
+ * unable to stop in time, then accelerate, cruise, decelerate. Each tick
+ * then evaluates p0 + t * (v0 + t * a/2) for the active segment, so
+ * preempting a move keeps position and velocity continuous.
+ */
+
+typedef struct {
+    float duration;   // s
+    float p0;         // Position at segment start
+    float v0;         // Velocity at segment start
+    float half_a;     // Acceleration / 2
+} motion_segment_t;
+
+// Trajectory state, touched only by the control thread
+static motion_segment_t segments[MANIPULATOR_MAX_SEGMENTS];
+static int segment_count;
+static int segment_index;
+static float segment_time;
+static float position;
+static float velocity;
+static float target;
+
+static atomic_t pending_target = ATOMIC_INIT(0);
+
+// Limits (shell) and published status (control thread)
+static struct k_spinlock manipulator_lock;
+static float max_vel = MANIPULATOR_DEFAULT_MAX_VEL;
+static float max_acc = MANIPULATOR_DEFAULT_MAX_ACC;
+static manipulator_status_t published;
+
+static void add_segment(float duration, float p0, float v0, float accel)
+{
+    if (duration < 1e-6f) {
+        return;
+    }
+    segments[segment_count++] = (motion_segment_t){
+        .duration = duration,
+        .p0 = p0,
+        .v0 = v0,
+        .half_a = 0.5f * accel,
+    };
+}
+
+/**
+ * Plan a move to goal from the current position and velocity
+ */
+static void manipulator_plan(float goal, float vmax, float amax)
+{
+    float p = position;
+    float v = velocity;
+    float d = goal - p;
+
+    segment_count = 0;
+    segment_index = 0;
+    segment_time = 0.0f;
+    target = goal;
+
+    // Moving away from the goal, or too fast to stop before it: brake to rest first
+    if (v != 0.0f && (v * d < 0.0f || v * v / (2.0f * amax) > fabsf(d))) {
+        float t = fabsf(v) / amax;
+
+        add_segment(t, p, v, v > 0.0f ? -amax : amax);
+        p += 0.5f * v * t;
+        v = 0.0f;
+        d = goal - p;
+    }
+
+    if (fabsf(d) < 1e-6f) {
+        return;
+    }
+
+    // Trapezoid in the direction of travel, starting at speed u >= 0
+    float s = d > 0.0f ? 1.0f : -1.0f;
+    float dist = fabsf(d);
+    float u = v * s;
+    float peak = MIN(sqrtf(amax * dist + 0.5f * u * u), vmax);
+    float a1 = peak >= u ? amax : -amax;
+    float d1 = (peak * peak - u * u) / (2.0f * a1);
+    float d3 = peak * peak / (2.0f * amax);
+    float dc = MAX(dist - d1 - d3, 0.0f);
+
+    add_segment(fabsf(peak - u) / amax, p, s * u, s * a1);
+    p += s * d1;
+    add_segment(dc / peak, p, s * peak, 0.0f);
+    p += s * dc;
+    add_segment(peak / amax, p, s * peak, -s * amax);
+}
+
+/**
+ * Initialize the trajectory generator at rest at position 0
+ */
+void manipulator_init(void)
+{
+    position = 0.0f;
+    velocity = 0.0f;
+    target = 0.0f;
+    segment_count = 0;
+    segment_index = 0;
+    atomic_set(&pending_target, 0);
+
+    LOG_INF("Manipulator profile: max vel %.2f /s, max acc %.2f /s^2",
+            (double)max_vel, (double)max_acc);
+}
+
+/**
+ * Request a new manipulator position
+ * @param goal: Position, 0.0 to 1.0
+ */
+void manipulator_set_target(float goal)
+{
+    atomic_set(&pending_target, TARGET_PENDING | (atomic_val_t)(CLAMP(goal, 0.0f, 1.0f) * TARGET_SCALE));
+}
+
+/**
+ * Advance the trajectory by one control period
+ * @return: Servo position for this tick, 0.0 to 1.0
+ */
+float manipulator_step(void)
+{
+    atomic_val_t request = atomic_clear(&pending_target);
+    uint32_t plan_cycles = 0;
+
+    if (request & TARGET_PENDING) {
+        uint32_t start = rov_cycles_now();
+
+        k_spinlock_key_t key = k_spin_lock(&manipulator_lock);
+        float vmax = max_vel;
+        float amax = max_acc;
+        k_spin_unlock(&manipulator_lock, key);
+
+        manipulator_plan((request & 0xFFFF) / TARGET_SCALE, vmax, amax);
+        plan_cycles = rov_cycles_now() - start;
+    }
+
+    uint32_t start = rov_cycles_now();
+
+    if (segment_index < segment_count) {
+        segment_time += MANIPULATOR_DT_S;
+        while (segment_index < segment_count &&
+               segment_time >= segments[segment_index].duration) {
+            segment_time -= segments[segment_index].duration;
+            segment_index++;
+        }
+
+        if (segment_index < segment_count) {
+            const motion_segment_t *seg = &segments[segment_index];
+            float t = segment_time;
+
+            position = seg->p0 + t * (seg->v0 + t * seg->half_a);
+            velocity = seg->v0 + 2.0f * seg->half_a * t;
+        } else {
+            position = target;
+            velocity = 0.0f;
+        }
+    }
+
+    uint32_t step_cycles = rov_cycles_now() - start;
+
+    k_spinlock_key_t key = k_spin_lock(&manipulator_lock);
+    published.target = target;
+    published.position = position;
+    published.velocity = velocity;
+    published.moving = segment_index < segment_count;
+    published.plan_max_cycles = MAX(published.plan_max_cycles, plan_cycles);
+    published.step_max_cycles = MAX(published.step_max_cycles, step_cycles);
+    k_spin_unlock(&manipulator_lock, key);
+
+    return CLAMP(position, 0.0f, 1.0f);
+}
+
+/**
+ * Set the motion limits (used from the next planned move)
+ * @param vel: Maximum velocity, full travel per second
+ * @param acc: Maximum acceleration, full travel per second squared
+ * @return: 0 on success, -EINVAL if not positive
+ */
+int manipulator_set_limits(float vel, float acc)
+{
+    if (!(vel > 0.0f) || !(acc > 0.0f)) {
+        return -EINVAL;
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&manipulator_lock);
+    max_vel = vel;
+    max_acc = acc;
+    k_spin_unlock(&manipulator_lock, key);
+    return 0;
+}
+
+/**
+ * Get the trajectory state as of the last control tick
+ * @param status: Output snapshot
+ */
+void manipulator_get_status(manipulator_status_t *status)
+{
+    k_spinlock_key_t key = k_spin_lock(&manipulator_lock);
+    *status = published;
+    status->max_vel = max_vel;
+    status->max_acc = max_acc;
+    k_spin_unlock(&manipulator_lock, key);
+}
+
+static int cmd_manipulator_show(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    manipulator_status_t s;
+    manipulator_get_status(&s);
+
+    shell_print(sh, "target %.3f  position %.3f  velocity %+.3f /s%s",
+                (double)s.target, (double)s.position, (double)s.velocity,
+                s.moving ? "  (moving)" : "");
+    shell_print(sh, "limits: vel %.2f /s  acc %.2f /s^2", (double)s.max_vel, (double)s.max_acc);
+    shell_print(sh, "cost: plan max %u ns, step max %u ns",
+                rov_cycles_to_ns(s.plan_max_cycles), rov_cycles_to_ns(s.step_max_cycles));
+    return 0;
+}
+
+static int cmd_manipulator_goto(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+
+    float goal = strtof(argv[1], NULL);
+
+    if (!(goal >= 0.0f && goal <= 1.0f)) {
+        shell_error(sh, "Position must be 0.0..1.0");
+        return -EINVAL;
+    }
+    manipulator_set_target(goal);
+    return 0;
+}
+
+static int cmd_manipulator_limits(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+
+    if (manipulator_set_limits(strtof(argv[1], NULL), strtof(argv[2], NULL)) != 0) {
+        shell_error(sh, "Limits must be positive");
+        return -EINVAL;
+    }
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(manipulator_cmds,
+    SHELL_CMD(show, NULL, "Show trajectory state and cost", cmd_manipulator_show),
+    SHELL_CMD_ARG(goto, NULL, "<0.0-1.0> Move to a position", cmd_manipulator_goto, 2, 0),
+    SHELL_CMD_ARG(limits, NULL, "<vel> <acc> Motion limits (travel/s, travel/s^2)",
+                  cmd_manipulator_limits, 3, 0),
+    SHELL_SUBCMD_SET_END
+);
+
+SHELL_SUBCMD_ADD((rov), manipulator, &manipulator_cmds, "Manipulator motion profile", NULL, 1, 0);
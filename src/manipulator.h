@@ -0,0 +1,39 @@
+#pragma once
+
+#include <zephyr/kernel.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Default motion limits, in normalized position units (0.0 to 1.0 = full travel)
+#define MANIPULATOR_DEFAULT_MAX_VEL 1.0f   // Full travel in 1 s at cruise
+#define MANIPULATOR_DEFAULT_MAX_ACC 4.0f   // Reaches cruise in 0.25 s
+
+typedef struct {
+    float target;
+    float position;
+    float velocity;
+    float max_vel;
+    float max_acc;
+    bool moving;
+    uint32_t plan_max_cycles;   // Worst cost of a (re)plan
+    uint32_t step_max_cycles;   // Worst cost of a per-tick step
+} manipulator_status_t;
+
+void manipulator_init(void);
+
+// New target (0.0 to 1.0), any thread. Preempts the running trajectory on the next tick.
+void manipulator_set_target(float position);
+
+// Control tick: advance the trajectory by one period, return the servo position
+float manipulator_step(void);
+
+int manipulator_set_limits(float max_vel, float max_acc);
+void manipulator_get_status(manipulator_status_t *status);
+
+#ifdef __cplusplus
+}
+#endif
@@ -6,6 +6,7 @@
 #include <zephyr/net/net_if.h>
 #include <zephyr/net/net_mgmt.h>
 #include <zephyr/net/net_ip.h>
+#include <zephyr/sys/barrier.h>
 // Standard C library headers for string manipulation and I/O
 #include <string.h>
 #include <stdio.h>
@@ -15,23 +16,18 @@
 // Include LED control header for visual feedback
 #include "led.h"
 #include "control.h"
+#include "net.h"
+#include "hotpath.h"
+#include "cycles.h"
+#include "trace.h"
 
 // Declare this module for logging purposes
 LOG_MODULE_DECLARE(k2_app);
 
-// Network configuration constants
-#define UDP_PORT 12345          // Port number for UDP server to listen on
+// Network configuration constants (UDP_PORT, udp_packet_t and STATIC_IP_ADDR in net.h)
 #define RECV_BUFFER_SIZE 64     // Buffer size for incoming UDP messages
 
-// Packet structure definition
-typedef struct {
-    uint32_t sequence;  // Sequence number
-    uint64_t payload;   // Payload data
-    uint32_t crc32;     // CRC32 checksum
-} __attribute__((packed)) udp_packet_t;
-
 // Static IP configuration - customize these for your network
-#define STATIC_IP_ADDR "192.168.1.100"   // Device's static IP address
 #define STATIC_NETMASK "255.255.255.0"   // Subnet mask
 #define STATIC_GATEWAY "192.168.1.1"     // Default gateway address
 
@@ -41,11 +37,26 @@ bool network_ready = false;  // Flag to track network interface status
 
 // UDP socket and thread management variables
 int udp_sock = -1;                                    // UDP socket file descriptor
-K_THREAD_STACK_DEFINE(udp_thread_stack, 2048);      // Stack space for UDP thread
+ROV_HOT_STACK_DEFINE(udp_thread_stack, 2048);       // Stack space for UDP thread
 struct k_thread udp_thread_data;                     // Thread control block
 
+// Link statistics (UDP thread writes, any thread reads)
+static atomic_t stat_rx_packets;
+static atomic_t stat_crc_errors;
+static atomic_t stat_size_errors;
+static atomic_t stat_recv_errors;
+
+// Active pilot endpoint: where the last valid command came from
+// (UDP thread writes under a sequence lock, readers retry)
+static struct sockaddr_in pilot_addr;
+static bool pilot_known;
+static atomic_t pilot_seq;
+
+// The vehicle's own address: commands from it (rov stack soak) never become the pilot
+static struct in_addr own_addr;
+
 // Pre-computed CRC32 lookup table for faster calculation
-static const uint32_t crc32_table[256] = {
+static const uint32_t ROV_HOT_RODATA crc32_table[256] = {
     0x00000000, 0x77073096, 0xEE0E612C, 0x990951BA, 0x076DC419, 0x706AF48F,
     0xE963A535, 0x9E6495A3, 0x0EDB8832, 0x79DCB8A4, 0xE0D5E91E, 0x97D2D988,
     0x09B64C2B, 0x7EB17CBD, 0xE7B82D07, 0x90BF1D91, 0x1DB71064, 0x6AB020F2,
@@ -104,11 +115,13 @@ static void net_mgmt_event_handler(struct net_mgmt_event_callback *cb,
     if (mgmt_event == NET_EVENT_IF_UP) {
         LOG_INF("Network interface is up - network is ready");
         network_ready = true;  // Set flag to indicate network is available
+        led_status_set(LED_STATUS_LINK_UP, true);
     } 
     // Check if network interface went down
     else if (mgmt_event == NET_EVENT_IF_DOWN) {
         LOG_WRN("Network interface is down");
         network_ready = false;  // Clear network ready flag
+        led_status_set(LED_STATUS_LINK_UP, false);
     }
 }
 
@@ -152,6 +165,7 @@ static int configure_static_ip(struct net_if *iface)
     }
     // Add the IP address to the interface with manual configuration
     net_if_ipv4_addr_add(iface, &addr, NET_ADDR_MANUAL, 0);
+    own_addr = addr;
 
     // Configure netmask (subnet mask)
     ret = parse_ipv4_addr(STATIC_NETMASK, &netmask);
@@ -217,6 +231,9 @@ void network_init(void)
     // Allow some time for the interface to become operational
     k_sleep(K_MSEC(200));
     network_ready = true;  // Mark network as ready for use
+
+    // IF_UP may have fired before the callback was registered; the events keep it current
+    led_status_set(LED_STATUS_LINK_UP, net_if_is_up(iface));
     
     LOG_INF("Static IP configuration complete");
 }
@@ -227,7 +244,7 @@ void network_init(void)
  * @param length: Length of data in bytes
  * @return: Calculated CRC32 value
  */
-static inline uint32_t calculate_crc32(const void *data, size_t length)
+ROV_HOT_CODE uint32_t calculate_crc32(const void *data, size_t length)
 {
     const uint8_t *bytes = (const uint8_t *)data;
     uint32_t crc = 0xFFFFFFFF;
@@ -255,6 +272,65 @@ static inline uint64_t net_to_host_64(uint64_t value)
 #endif
 }
 
+/**
+ * Validate and decode one received packet, then forward it to control
+ * @param packet: Packet as received (network byte order)
+ * @param source: Sender address
+ * @param rx_cycles: Cycle counter when zsock_recvfrom() returned
+ */
+static ROV_HOT_CODE void udp_process_packet(const udp_packet_t *packet,
+                                            const struct sockaddr_in *source,
+                                            uint32_t rx_cycles)
+{
+    //TESTING: Print all packet values
+    uint32_t recv_sequence = ntohl(packet->sequence);
+    uint64_t recv_payload = net_to_host_64(packet->payload);
+    uint32_t recv_crc = ntohl(packet->crc32);
+    
+    //LOG_INF("=== PACKET RECEIVED ===");
+    //LOG_INF("Sequence: %u", recv_sequence);
+    //LOG_INF("Payload:  0x%016llX", recv_payload);
+    //LOG_INF("CRC32:    0x%08X", recv_crc);
+    
+    // Calculate CRC32 for validation
+    uint32_t calculated_crc = calculate_crc32(packet, 
+        sizeof(packet->sequence) + sizeof(packet->payload));
+    
+    //LOG_INF("Calc CRC: 0x%08X", calculated_crc);
+    
+    //TESTING: Clear match/mismatch indication
+    if (calculated_crc == recv_crc) {
+        //LOG_INF("CRC MATCH - Packet is valid!");
+        //gpio_pin_toggle_dt(&led); // Visual feedback
+        ROV_TRACE_VALID(recv_sequence);
+
+        // Forward command to control system
+        rov_send_command(recv_sequence, recv_payload, rx_cycles);
+        atomic_inc(&stat_rx_packets);
+
+        // Telemetry follows the pilot that is currently sending commands,
+        // unless they come from the vehicle itself
+        bool own = source->sin_addr.s_addr == own_addr.s_addr ||
+                   (ntohl(source->sin_addr.s_addr) >> 24) == 127;
+
+        if (!own && (!pilot_known || pilot_addr.sin_addr.s_addr != source->sin_addr.s_addr ||
+                     pilot_addr.sin_port != source->sin_port)) {
+            atomic_inc(&pilot_seq);
+            barrier_dmem_fence_full();
+            pilot_addr = *source;
+            pilot_known = true;
+            barrier_dmem_fence_full();
+            atomic_inc(&pilot_seq);
+        }
+    } else {
+        ROV_TRACE_INVALID(recv_sequence);
+        atomic_inc(&stat_crc_errors);
+        led_status_event(LED_EVENT_CRC_ERROR);
+        LOG_ERR("CRC mismatch: expected 0x%08X, got 0x%08X", calculated_crc, recv_crc);
+    }
+    //LOG_INF("========================");
+}
+
 /**
  * UDP server thread function - handles incoming UDP messages
  * This thread runs continuously, listening for UDP packets and responding
@@ -300,42 +376,19 @@ void udp_server_thread(void *arg1, void *arg2, void *arg3)
         //PERFORMANCE: Direct struct receive (no buffer copying)
         ret = zsock_recvfrom(udp_sock, &packet, sizeof(packet), 0, // ⚡ Direct to struct
                              (struct sockaddr *)&client_addr, &client_addr_len);
+        uint32_t rx_cycles = rov_cycles_now();   // Start of the command lifecycle (latency.h)
 
         if (ret == sizeof(udp_packet_t)) {
-            //TESTING: Print all packet values
-            uint32_t recv_sequence = ntohl(packet.sequence);
-            uint64_t recv_payload = net_to_host_64(packet.payload);
-            uint32_t recv_crc = ntohl(packet.crc32);
-            
-            //LOG_INF("=== PACKET RECEIVED ===");
-            //LOG_INF("Sequence: %u", recv_sequence);
-            //LOG_INF("Payload:  0x%016llX", recv_payload);
-            //LOG_INF("CRC32:    0x%08X", recv_crc);
-            
-            // Calculate CRC32 for validation
-            uint32_t calculated_crc = calculate_crc32(&packet, 
-                sizeof(packet.sequence) + sizeof(packet.payload));
-            
-            //LOG_INF("Calc CRC: 0x%08X", calculated_crc);
-            
-            //TESTING: Clear match/mismatch indication
-            if (calculated_crc == recv_crc) {
-                //LOG_INF("CRC MATCH - Packet is valid!");
-                //gpio_pin_toggle_dt(&led); // Visual feedback
-
-                // Forward command to control system
-                rov_send_command(recv_sequence, recv_payload);
-            } else {
-                LOG_ERR("CRC MISMATCH - Packet corrupted!");
-                LOG_ERR("Expected: 0x%08X, Got: 0x%08X", calculated_crc, recv_crc);
-            }
-            //LOG_INF("========================");
-            
+            ROV_TRACE_RX(ntohl(packet.sequence), ret);
+            udp_process_packet(&packet, &client_addr, rx_cycles);
         } else if (ret < 0) {
+            atomic_inc(&stat_recv_errors);
             LOG_ERR("UDP recv error: %d", ret);
             k_sleep(K_MSEC(100));
         } else {
             //TESTING: Print wrong packet sizes for debugging
+            ROV_TRACE_RX(0, ret);
+            atomic_inc(&stat_size_errors);
             LOG_WRN("Wrong packet size: got %d bytes, expected %d bytes", 
                     ret, sizeof(udp_packet_t));
         }
@@ -356,13 +409,58 @@ void udp_server_start(void)
                                K_THREAD_STACK_SIZEOF(udp_thread_stack),
                                udp_server_thread,
                                NULL, NULL, NULL,
-                               K_PRIO_COOP(7),
+                               K_PRIO_PREEMPT(1),
                                0,
                                K_NO_WAIT);
     
     if (thread_id != NULL) {
+        k_thread_name_set(thread_id, "udp_server");
         LOG_INF("UDP server thread created successfully");
     } else {
         LOG_ERR("Failed to create UDP server thread");
     }
-}
\ No newline at end of file
+}
+
+/**
+ * Get uplink statistics
+ * @param stats: Output counters
+ */
+void net_get_link_stats(net_link_stats_t *stats)
+{
+    stats->rx_packets = (uint32_t)atomic_get(&stat_rx_packets);
+    stats->crc_errors = (uint32_t)atomic_get(&stat_crc_errors);
+    stats->size_errors = (uint32_t)atomic_get(&stat_size_errors);
+    stats->recv_errors = (uint32_t)atomic_get(&stat_recv_errors);
+}
+
+/**
+ * Get the active pilot endpoint
+ * @param addr: Output, address and port the last valid command came from
+ * @return: true if a command has been received
+ */
+bool net_get_pilot(struct sockaddr_in *addr)
+{
+    atomic_val_t start, end;
+    bool known;
+
+    do {
+        start = atomic_get(&pilot_seq);
+        barrier_dmem_fence_full();
+        known = pilot_known;
+        *addr = pilot_addr;
+        barrier_dmem_fence_full();
+        end = atomic_get(&pilot_seq);
+    } while ((start & 1) || start != end);
+    return known;
+}
+
+/**
+ * Clear the uplink counters
+ */
+void net_reset_link_stats(void)
+{
+    atomic_clear(&stat_rx_packets);
+    atomic_clear(&stat_crc_errors);
+    atomic_clear(&stat_size_errors);
+    atomic_clear(&stat_recv_errors);
+}
@@ -1,16 +1,39 @@
 #pragma once
 
 #include <zephyr/kernel.h>
+#include <zephyr/net/net_ip.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+#define UDP_PORT 12345                   // Port number for UDP server to listen on
+#define STATIC_IP_ADDR "192.168.1.100"   // Device's static IP address
+
+// Command packet, all fields in network byte order
+typedef struct {
+    uint32_t sequence;  // Sequence number
+    uint64_t payload;   // Payload data
+    uint32_t crc32;     // CRC32 checksum of sequence and payload
+} __attribute__((packed)) udp_packet_t;
+
 extern bool network_ready;
 
+// Uplink statistics since boot (or the last reset)
+typedef struct {
+    uint32_t rx_packets;    // Valid commands forwarded to control
+    uint32_t crc_errors;
+    uint32_t size_errors;   // Datagrams of the wrong length
+    uint32_t recv_errors;   // Socket receive failures
+} net_link_stats_t;
+
 void network_init(void);
 void udp_server_thread(void *arg1, void *arg2, void *arg3);
 void udp_server_start(void); // start the UDP server thread (creates it internally)
+uint32_t calculate_crc32(const void *data, size_t length); // CRC32 (IEEE 802.3) of a packet body
+void net_get_link_stats(net_link_stats_t *stats);
+void net_reset_link_stats(void);
+bool net_get_pilot(struct sockaddr_in *addr); // Source of the last valid command, false if none yet
 
 extern int udp_sock;
 
@@ -0,0 +1,158 @@
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/shell/shell.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "control.h"
+#include "net.h"
+#include "latency.h"
+#include "cmdlog.h"
+#include "telemetry.h"
+#include "wcet.h"
+#include "actuator.h"
+#include "sensors.h"
+#include "cpuload.h"
+#include "stackmon.h"
+
+LOG_MODULE_DECLARE(k2_app);
+
+/*
+ * Live performance overview (rov perf ...). Everything here reads
+ * counters the hot path publishes without locks (atomics and sequence
+ * locks), so inspecting does not hold up the UDP or control threads.
+ */
+
+/**
+ * Stack entry of a thread in the stack monitor report
+ * @return: Entry, or NULL if the thread was not scanned yet
+ */
+static const stackmon_entry_t *perf_find_stack(const stackmon_report_t *stacks,
+                                               const char *name, bool *matched)
+{
+    for (int i = 0; i < stacks->count; i++) {
+        if (!matched[i] && strcmp(stacks->stacks[i].name, name) == 0) {
+            matched[i] = true;
+            return &stacks->stacks[i];
+        }
+    }
+    return NULL;
+}
+
+static void perf_print_stack(const struct shell *sh, const char *name, const char *group,
+                             const char *load, const stackmon_entry_t *e)
+{
+    if (e == NULL || e->size == 0) {
+        shell_print(sh, "%-16s %-9s %-15s %15s", name, group, load, "-");
+        return;
+    }
+    shell_print(sh, "%-16s %-9s %-15s %7u/%-7u %7u%%", name, group, load, e->high_water,
+                e->size, (e->size - MIN(e->high_water, e->size)) * 100U / e->size);
+}
+
+/*
+ * One line per thread, joined from the CPU load sampler (cpuload.c) and the
+ * stack monitor (stackmon.c) reports, so the threads are walked only there
+ */
+static int cmd_perf_threads(const struct shell *sh, size_t argc, char **argv)
+{
+    static cpuload_report_t cpu;         // Shell thread only; too large for its stack
+    static stackmon_report_t stacks;
+    bool matched[STACKMON_MAX_STACKS] = { false };
+    char load[16];
+
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    cpuload_get_report(&cpu);
+    stackmon_get_report(&stacks);
+
+    shell_print(sh, "thread           group     cpu%% 1s/10s    stack used/size headroom");
+    for (int i = 0; i < cpu.thread_count; i++) {
+        const cpuload_thread_t *t = &cpu.threads[i];
+
+        snprintf(load, sizeof(load), "%3u.%02u/%3u.%02u",
+                 t->load[CPULOAD_WINDOW_1S] / 100U, t->load[CPULOAD_WINDOW_1S] % 100U,
+                 t->load[CPULOAD_WINDOW_10S] / 100U, t->load[CPULOAD_WINDOW_10S] % 100U);
+        perf_print_stack(sh, t->name, cpuload_group_name(t->group), load,
+                         perf_find_stack(&stacks, t->name, matched));
+    }
+    // Stacks without a thread in the CPU report (interrupt stack, new threads)
+    for (int i = 0; i < stacks.count; i++) {
+        if (!matched[i]) {
+            perf_print_stack(sh, stacks.stacks[i].name, stacks.stacks[i].isr ? "isr" : "-",
+                             "-", &stacks.stacks[i]);
+        }
+    }
+    if (cpu.truncated || stacks.truncated) {
+        shell_warn(sh, "Thread list truncated");
+    }
+    shell_print(sh, "CPU sampled %u ms ago, stacks scanned %u ms ago (rov cpu, rov stack)",
+                k_uptime_get_32() - cpu.timestamp_ms, k_uptime_get_32() - stacks.timestamp_ms);
+    return 0;
+}
+
+static int cmd_perf_show(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    net_link_stats_t link;
+    rov_queue_stats_t queue;
+    latency_summary_t latency[LATENCY_SEGMENT_COUNT];
+    cmdlog_stats_t log;
+
+    net_get_link_stats(&link);
+    rov_get_queue_stats(&queue);
+    latency_get_summary(latency);
+    cmdlog_get_stats(&log);
+
+    shell_print(sh, "uplink: rx %u  crc errors %u  size errors %u  recv errors %u",
+                link.rx_packets, link.crc_errors, link.size_errors, link.recv_errors);
+    shell_print(sh, "queue:  depth %u/%u  high-water %u  drops %u",
+                queue.depth, queue.capacity, queue.high_water, queue.drops);
+
+    shell_print(sh, "latency     count    p50_us    p99_us    max_us");
+    for (int i = 0; i < LATENCY_SEGMENT_COUNT; i++) {
+        const latency_summary_t *l = &latency[i];
+
+        shell_print(sh, "  %-8s %7u %5u.%03u %5u.%03u %5u.%03u", latency_segment_name(i), l->count,
+                    l->p50_ns / 1000U, l->p50_ns % 1000U, l->p99_ns / 1000U, l->p99_ns % 1000U,
+                    l->max_ns / 1000U, l->max_ns % 1000U);
+    }
+
+    shell_print(sh, "modes:  log %s every %u (rov log level|every)  "
+                "telemetry %u Hz batch %u (rov telemetry rate|batch)",
+                cmdlog_level_name(cmdlog_get_level()), cmdlog_get_decimate(),
+                telemetry_get_rate(), telemetry_get_batch());
+    shell_print(sh, "log:    commands %u  records %u", log.commands, log.records);
+    return 0;
+}
+
+static int cmd_perf_reset(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    net_reset_link_stats();
+    rov_reset_queue_stats();
+    latency_reset();
+    cmdlog_reset_stats();
+    wcet_reset();
+    actuator_reset_timing();
+    sensors_reset_stats();
+    telemetry_reset_stats();
+    cpuload_reset();
+    shell_print(sh, "Counters, histograms and timing statistics reset");
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(perf_cmds,
+    SHELL_CMD(show, NULL, "Uplink counters, queue, latency and runtime modes", cmd_perf_show),
+    SHELL_CMD(threads, NULL, "Per-thread CPU load and stack headroom (cpu + stack reports)",
+              cmd_perf_threads),
+    SHELL_CMD(reset, NULL, "Reset every counter and histogram", cmd_perf_reset),
+    SHELL_SUBCMD_SET_END
+);
+
+SHELL_SUBCMD_ADD((rov), perf, &perf_cmds, "Live performance counters", NULL, 1, 0);
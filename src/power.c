@@ -0,0 +1,436 @@
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/shell/shell.h>
+#include <errno.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "power.h"
+#include "cycles.h"
+#include "hotpath.h"
+
+LOG_MODULE_DECLARE(k2_app);
+
+#define POWER_SEGMENTS (POWER_CURVE_POINTS - 1)
+#define POWER_SEGMENTS_PER_UNIT (POWER_SEGMENTS / 2.0f)   // Curve spans -1..+1
+
+// Bisection steps for the scale factor: resolution 2^-10 of full scale
+#define POWER_BISECT_STEPS 10
+
+BUILD_ASSERT(POWER_CURVE_POINTS % 2 == 1, "curve needs a sample at zero thrust");
+
+/*
+ * Per-tick tables, stored as a base and slope per segment so a lookup is
+ * one multiply-add after the index. Two copies are kept as in the filter
+ * bank: the control loop reads the active one, a configuration call fills
+ * the other and publishes it with an atomic index swap.
+ */
+typedef struct {
+    float base[POWER_SEGMENTS];
+    float slope[POWER_SEGMENTS];
+    float limit_a;
+} power_table_t;
+
+static power_table_t ROV_HOT_BSS tables[2];
+static atomic_t active_table = ATOMIC_INIT(0);
+K_MUTEX_DEFINE(power_config_lock);   // Serializes writers of the inactive table
+
+// User-facing curve, kept for read-back
+static float curve_amps[POWER_CURVE_POINTS];
+
+static power_status_t published;
+static struct k_spinlock status_lock;
+
+static void power_table_from_curve(power_table_t *table, const float amps[POWER_CURVE_POINTS])
+{
+    for (int i = 0; i < POWER_SEGMENTS; i++) {
+        table->base[i] = amps[i];
+        table->slope[i] = amps[i + 1] - amps[i];
+    }
+}
+
+static inline float power_lookup(const power_table_t *table, float thrust)
+{
+    float x = (CLAMP(thrust, -1.0f, 1.0f) + 1.0f) * POWER_SEGMENTS_PER_UNIT;
+    int i = MIN((int)x, POWER_SEGMENTS - 1);
+
+    return table->base[i] + (x - i) * table->slope[i];
+}
+
+static ROV_HOT_CODE float power_total(const power_table_t *table,
+                                      const float thrust[ROV_THRUSTER_COUNT], float scale)
+{
+    float total = 0.0f;
+
+    for (int t = 0; t < ROV_THRUSTER_COUNT; t++) {
+        total += power_lookup(table, thrust[t] * scale);
+    }
+    return total;
+}
+
+/**
+ * Scale a frame to the table's budget. Bounded cost: one estimate when under
+ * budget, plus a fixed number of bisection steps when over.
+ * @return: Scale applied
+ */
+static ROV_HOT_CODE float power_apply(const power_table_t *table,
+                                      float thrust[ROV_THRUSTER_COUNT],
+                                      float *requested_a, float *delivered_a)
+{
+    float total = power_total(table, thrust, 1.0f);
+
+    *requested_a = total;
+    *delivered_a = total;
+    if (total <= table->limit_a) {
+        return 1.0f;
+    }
+
+    // Current grows with |thrust|, so total(scale) is monotonic: bisect for the budget
+    float lo = 0.0f;
+    float hi = 1.0f;
+    float lo_total = power_total(table, thrust, 0.0f);
+
+    for (int i = 0; i < POWER_BISECT_STEPS; i++) {
+        float mid = 0.5f * (lo + hi);
+        float mid_total = power_total(table, thrust, mid);
+
+        if (mid_total <= table->limit_a) {
+            lo = mid;
+            lo_total = mid_total;
+        } else {
+            hi = mid;
+        }
+    }
+
+    // Same scale on every thruster keeps the commanded direction
+    for (int t = 0; t < ROV_THRUSTER_COUNT; t++) {
+        thrust[t] *= lo;
+    }
+    *delivered_a = lo_total;
+    return lo;
+}
+
+/**
+ * Build a curve of the form I = I_full * |thrust|^exponent
+ * @param forward_a: Current at full forward thrust
+ * @param reverse_a: Current at full reverse thrust
+ * @param exponent: Curve shape (1.0 = linear)
+ * @param amps: Output curve
+ */
+void power_make_curve(float forward_a, float reverse_a, float exponent,
+                      float amps[POWER_CURVE_POINTS])
+{
+    for (int i = 0; i < POWER_CURVE_POINTS; i++) {
+        float thrust = i / POWER_SEGMENTS_PER_UNIT - 1.0f;
+        float full = thrust < 0.0f ? reverse_a : forward_a;
+
+        amps[i] = full * powf(fabsf(thrust), exponent);
+    }
+}
+
+/**
+ * Initialize the power limiter with the default curve and budget
+ */
+void power_init(void)
+{
+    power_make_curve(POWER_DEFAULT_FORWARD_A, POWER_DEFAULT_REVERSE_A,
+                     POWER_DEFAULT_EXPONENT, curve_amps);
+    power_table_from_curve(&tables[0], curve_amps);
+    tables[0].limit_a = POWER_DEFAULT_LIMIT_A;
+    tables[1] = tables[0];
+    atomic_set(&active_table, 0);
+
+    published = (power_status_t){ .limit_a = POWER_DEFAULT_LIMIT_A, .scale = 1.0f };
+
+    LOG_INF("Power limiter: %.1f A budget, %.1f A per thruster at full thrust",
+            (double)POWER_DEFAULT_LIMIT_A, (double)POWER_DEFAULT_FORWARD_A);
+}
+
+/**
+ * Limit the total thruster current for one control tick
+ * @param thrust: Thruster outputs (-1.0 to +1.0), scaled in place
+ * @return: Scale applied (1.0 if under budget)
+ */
+ROV_HOT_CODE float power_limit(float thrust[ROV_THRUSTER_COUNT])
+{
+    const power_table_t *table = &tables[atomic_get(&active_table)];
+    float requested_a;
+    float delivered_a;
+    float scale = power_apply(table, thrust, &requested_a, &delivered_a);
+
+    k_spinlock_key_t key = k_spin_lock(&status_lock);
+    published.limit_a = table->limit_a;
+    published.requested_a = requested_a;
+    published.delivered_a = delivered_a;
+    published.scale = scale;
+    memcpy(published.thrust, thrust, sizeof(published.thrust));
+    published.ticks++;
+    if (scale < 1.0f) {
+        published.limited_ticks++;
+    }
+    k_spin_unlock(&status_lock, key);
+
+    return scale;
+}
+
+/**
+ * Estimate the total current of a frame
+ * @param thrust: Thruster outputs (-1.0 to +1.0)
+ * @return: Estimated current, A
+ */
+float power_estimate(const float thrust[ROV_THRUSTER_COUNT])
+{
+    return power_total(&tables[atomic_get(&active_table)], thrust, 1.0f);
+}
+
+/**
+ * Set the total current budget
+ * @param limit_a: Budget in amps
+ * @return: 0 on success, -EINVAL if not positive
+ */
+int power_set_limit(float limit_a)
+{
+    if (!(limit_a > 0.0f)) {
+        return -EINVAL;
+    }
+
+    k_mutex_lock(&power_config_lock, K_FOREVER);
+    int active = atomic_get(&active_table);
+    tables[!active] = tables[active];
+    tables[!active].limit_a = limit_a;
+    atomic_set(&active_table, !active);
+    k_mutex_unlock(&power_config_lock);
+    return 0;
+}
+
+/**
+ * Replace the thrust-to-current curve
+ * @param amps: Current at evenly spaced thrust values from -1.0 to +1.0.
+ *              Must be non-negative and grow away from zero thrust.
+ * @return: 0 on success, -EINVAL if the curve is not valid
+ */
+int power_set_curve(const float amps[POWER_CURVE_POINTS])
+{
+    const int zero = POWER_SEGMENTS / 2;
+
+    for (int i = 0; i < POWER_CURVE_POINTS; i++) {
+        if (!(amps[i] >= 0.0f)) {
+            return -EINVAL;
+        }
+    }
+    for (int i = zero; i < POWER_SEGMENTS; i++) {
+        if (amps[i + 1] < amps[i]) {
+            return -EINVAL;
+        }
+    }
+    for (int i = zero; i > 0; i--) {
+        if (amps[i - 1] < amps[i]) {
+            return -EINVAL;
+        }
+    }
+
+    k_mutex_lock(&power_config_lock, K_FOREVER);
+    int active = atomic_get(&active_table);
+    for (int i = 0; i < POWER_CURVE_POINTS; i++) {
+        curve_amps[i] = amps[i];
+    }
+    tables[!active].limit_a = tables[active].limit_a;
+    power_table_from_curve(&tables[!active], amps);
+    atomic_set(&active_table, !active);
+    k_mutex_unlock(&power_config_lock);
+    return 0;
+}
+
+/**
+ * Get the limiter state as of the last control tick
+ * @param status: Output snapshot
+ */
+void power_get_status(power_status_t *status)
+{
+    k_spinlock_key_t key = k_spin_lock(&status_lock);
+    *status = published;
+    k_spin_unlock(&status_lock, key);
+}
+
+static int cmd_power_show(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    power_status_t s;
+    power_get_status(&s);
+
+    shell_print(sh, "budget %.1f A  requested %.1f A  delivered %.1f A  scale %.3f",
+                (double)s.limit_a, (double)s.requested_a, (double)s.delivered_a,
+                (double)s.scale);
+    shell_print(sh, "limited %u of %u ticks", s.limited_ticks, s.ticks);
+
+    k_mutex_lock(&power_config_lock, K_FOREVER);
+    shell_print(sh, "curve: %.1f A at -1, %.1f A at -0.5, %.1f A at +0.5, %.1f A at +1",
+                (double)curve_amps[0], (double)curve_amps[POWER_SEGMENTS / 4],
+                (double)curve_amps[3 * POWER_SEGMENTS / 4],
+                (double)curve_amps[POWER_SEGMENTS]);
+    k_mutex_unlock(&power_config_lock);
+    return 0;
+}
+
+static int cmd_power_limit(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+
+    if (power_set_limit(strtof(argv[1], NULL)) != 0) {
+        shell_error(sh, "Budget must be positive");
+        return -EINVAL;
+    }
+    return 0;
+}
+
+static int cmd_power_curve(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+
+    float amps[POWER_CURVE_POINTS];
+    float exponent = strtof(argv[3], NULL);
+
+    if (!(exponent >= 0.5f && exponent <= 4.0f)) {
+        shell_error(sh, "Exponent must be 0.5..4.0");
+        return -EINVAL;
+    }
+    power_make_curve(strtof(argv[1], NULL), strtof(argv[2], NULL), exponent, amps);
+    if (power_set_curve(amps) != 0) {
+        shell_error(sh, "Currents must be non-negative");
+        return -EINVAL;
+    }
+    return 0;
+}
+
+// Small PRNG so the benchmark and checks are repeatable
+static uint32_t power_rand_state;
+
+static float power_rand_thrust(void)
+{
+    power_rand_state ^= power_rand_state << 13;
+    power_rand_state ^= power_rand_state >> 17;
+    power_rand_state ^= power_rand_state << 5;
+    return (power_rand_state >> 8) * (2.0f / 16777216.0f) - 1.0f;
+}
+
+static int cmd_power_bench(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    const power_table_t *table = &tables[atomic_get(&active_table)];
+    const int iterations = 10000;
+    float thrust[ROV_THRUSTER_COUNT];
+    float requested_a;
+    float delivered_a;
+    uint64_t total_cycles = 0;
+    uint32_t max_cycles = 0;
+    int limited = 0;
+
+    power_rand_state = 0x12345678;
+    for (int n = 0; n < iterations; n++) {
+        for (int t = 0; t < ROV_THRUSTER_COUNT; t++) {
+            thrust[t] = power_rand_thrust();
+        }
+
+        uint32_t start = rov_cycles_now();
+        float scale = power_apply(table, thrust, &requested_a, &delivered_a);
+        uint32_t cycles = rov_cycles_now() - start;
+
+        total_cycles += cycles;
+        max_cycles = MAX(max_cycles, cycles);
+        limited += scale < 1.0f;
+    }
+
+    shell_print(sh, "%d random frames (%d over budget): mean %u cycles (%u ns), max %u cycles (%u ns)",
+                iterations, limited, (uint32_t)(total_cycles / iterations),
+                rov_cycles_to_ns((uint32_t)(total_cycles / iterations)),
+                max_cycles, rov_cycles_to_ns(max_cycles));
+    return 0;
+}
+
+static bool power_check_frame(const struct shell *sh, const power_table_t *table,
+                              const float frame[ROV_THRUSTER_COUNT], const char *name)
+{
+    float thrust[ROV_THRUSTER_COUNT];
+    float requested_a;
+    float delivered_a;
+    bool ok = true;
+
+    for (int t = 0; t < ROV_THRUSTER_COUNT; t++) {
+        thrust[t] = frame[t];
+    }
+    float scale = power_apply(table, thrust, &requested_a, &delivered_a);
+
+    // Under budget and within one bisection step of it when limited
+    if (delivered_a > table->limit_a + 1e-3f) {
+        ok = false;
+    }
+    if (scale < 1.0f &&
+        power_total(table, frame, scale + 2.0f / (1 << POWER_BISECT_STEPS)) <= table->limit_a) {
+        ok = false;
+    }
+    // Direction preserved: every thruster scaled by the same factor
+    for (int t = 0; t < ROV_THRUSTER_COUNT; t++) {
+        if (fabsf(thrust[t] - frame[t] * scale) > 1e-6f) {
+            ok = false;
+        }
+    }
+    if (name != NULL || !ok) {
+        shell_print(sh, "%-14s requested %6.1f A  delivered %5.1f A  scale %.3f  %s",
+                    name != NULL ? name : "random", (double)requested_a, (double)delivered_a,
+                    (double)scale, ok ? "ok" : "FAIL");
+    }
+    return ok;
+}
+
+static int cmd_power_test(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    const power_table_t *table = &tables[atomic_get(&active_table)];
+    static const float idle[ROV_THRUSTER_COUNT] = { 0 };
+    static const float one_full[ROV_THRUSTER_COUNT] = { 1.0f };
+    static const float all_full[ROV_THRUSTER_COUNT] = {
+        1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f
+    };
+    static const float mixed[ROV_THRUSTER_COUNT] = {
+        1.0f, -1.0f, 0.8f, -0.6f, 0.5f, 0.5f, -1.0f, -1.0f
+    };
+    float frame[ROV_THRUSTER_COUNT];
+    bool ok = true;
+
+    shell_print(sh, "budget %.1f A", (double)table->limit_a);
+    ok &= power_check_frame(sh, table, idle, "idle");
+    ok &= power_check_frame(sh, table, one_full, "one full");
+    ok &= power_check_frame(sh, table, all_full, "all full");
+    ok &= power_check_frame(sh, table, mixed, "mixed");
+
+    power_rand_state = 0xC0FFEE;
+    for (int n = 0; n < 1000; n++) {
+        for (int t = 0; t < ROV_THRUSTER_COUNT; t++) {
+            frame[t] = power_rand_thrust();
+        }
+        ok &= power_check_frame(sh, table, frame, NULL);
+    }
+
+    shell_print(sh, "power limiter test %s", ok ? "passed" : "FAILED");
+    return ok ? 0 : -EIO;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(power_cmds,
+    SHELL_CMD(show, NULL, "Show budget, estimated current and limiting", cmd_power_show),
+    SHELL_CMD_ARG(limit, NULL, "<amps> Total current budget", cmd_power_limit, 2, 0),
+    SHELL_CMD_ARG(curve, NULL, "<full_fwd_A> <full_rev_A> <exponent> Thrust-to-current curve",
+                  cmd_power_curve, 4, 0),
+    SHELL_CMD(bench, NULL, "Limiter cost on random frames", cmd_power_bench),
+    SHELL_CMD(test, NULL, "Check budget and direction on fixed and random frames",
+              cmd_power_test),
+    SHELL_SUBCMD_SET_END
+);
+
+SHELL_SUBCMD_ADD((rov), power, &power_cmds, "Thruster current budget", NULL, 1, 0);
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <zephyr/kernel.h>
+#include <stdint.h>
+
+#include "control.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Thrust-to-current curve: samples evenly spaced over thrust -1.0 .. +1.0
+#define POWER_CURVE_POINTS 33
+
+// Default curve (per thruster) and total budget for the tether supply
+#define POWER_DEFAULT_FORWARD_A  17.0f   // Current at full forward thrust
+#define POWER_DEFAULT_REVERSE_A  13.0f   // Current at full reverse thrust
+#define POWER_DEFAULT_EXPONENT   1.5f    // Current ~ |thrust|^exponent
+#define POWER_DEFAULT_LIMIT_A    60.0f
+
+typedef struct {
+    float limit_a;
+    float requested_a;     // Estimated total before limiting (last tick)
+    float delivered_a;     // Estimated total after limiting (last tick)
+    float scale;           // Applied to the frame (last tick), 1.0 = not limited
+    float thrust[ROV_THRUSTER_COUNT];   // Limited frame, before compensation (last tick)
+    uint32_t limited_ticks;
+    uint32_t ticks;
+} power_status_t;
+
+void power_init(void);
+
+// Control tick: scale the thruster frame in place to stay under the budget
+float power_limit(float thrust[ROV_THRUSTER_COUNT]);
+
+// Estimated total current for a frame with the active curve
+float power_estimate(const float thrust[ROV_THRUSTER_COUNT]);
+
+int power_set_limit(float limit_a);
+int power_set_curve(const float amps[POWER_CURVE_POINTS]);
+void power_make_curve(float forward_a, float reverse_a, float exponent,
+                      float amps[POWER_CURVE_POINTS]);
+void power_get_status(power_status_t *status);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,131 @@
+#define DT_DRV_COMPAT k2_sim_sensor
+
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/sensor.h>
+#include <errno.h>
+
+#include "sensors.h"
+#include "sim.h"
+
+/*
+ * Sensor API driver backed by the native_sim plant model. Each
+ * devicetree node is one sensor "kind"; sample_fetch latches a reading
+ * from src/sim.c and channel_get returns it in the units of the real
+ * parts (m/s^2, rad/s, kPa, V), so the ingestion path is the same as on
+ * hardware.
+ */
+
+// Order of the "kind" enum in dts/bindings/k2,sim-sensor.yaml
+enum sensor_sim_kind {
+    SENSOR_SIM_IMU = 0,
+    SENSOR_SIM_DEPTH,
+    SENSOR_SIM_LEAK,
+    SENSOR_SIM_VOLTAGE,
+};
+
+#define SENSOR_SIM_GRAVITY     9.80665f
+#define SENSOR_SIM_SURFACE_KPA 101.325f
+#define SENSOR_SIM_WATER_KPA_PER_M (1025.0f * SENSOR_SIM_GRAVITY / 1000.0f)
+#define SENSOR_SIM_WATER_TEMP_C 12.0f
+
+struct sensor_sim_config {
+    enum sensor_sim_kind kind;
+};
+
+struct sensor_sim_data {
+    ahrs_sample_t imu;
+    float pressure_kpa;
+    float voltage_v;
+    bool leak;
+};
+
+static int sensor_sim_sample_fetch(const struct device *dev, enum sensor_channel chan)
+{
+    const struct sensor_sim_config *config = dev->config;
+    struct sensor_sim_data *data = dev->data;
+    hold_feedback_t feedback;
+
+    ARG_UNUSED(chan);
+
+    switch (config->kind) {
+    case SENSOR_SIM_IMU:
+        sim_get_imu(&data->imu);
+        break;
+    case SENSOR_SIM_DEPTH:
+        sim_get_feedback(&feedback);
+        data->pressure_kpa = SENSOR_SIM_SURFACE_KPA + feedback.depth_m * SENSOR_SIM_WATER_KPA_PER_M;
+        break;
+    case SENSOR_SIM_LEAK:
+        data->leak = sim_get_leak();
+        break;
+    case SENSOR_SIM_VOLTAGE:
+        data->voltage_v = sim_get_battery_voltage();
+        break;
+    }
+    return 0;
+}
+
+static void sensor_sim_vector(const float in[3], float scale, struct sensor_value *val)
+{
+    for (int i = 0; i < 3; i++) {
+        sensor_value_from_float(&val[i], in[i] * scale);
+    }
+}
+
+static int sensor_sim_channel_get(const struct device *dev, enum sensor_channel chan,
+                                  struct sensor_value *val)
+{
+    const struct sensor_sim_config *config = dev->config;
+    struct sensor_sim_data *data = dev->data;
+
+    switch (config->kind) {
+    case SENSOR_SIM_IMU:
+        if (chan == SENSOR_CHAN_ACCEL_XYZ) {
+            sensor_sim_vector(data->imu.accel, SENSOR_SIM_GRAVITY, val);   // g to m/s^2
+        } else if (chan == SENSOR_CHAN_GYRO_XYZ) {
+            sensor_sim_vector(data->imu.gyro, 1.0f, val);
+        } else if (chan == SENSOR_CHAN_MAGN_XYZ && data->imu.has_mag) {
+            sensor_sim_vector(data->imu.mag, 1.0f, val);
+        } else {
+            return -ENOTSUP;
+        }
+        return 0;
+    case SENSOR_SIM_DEPTH:
+        if (chan == SENSOR_CHAN_PRESS) {
+            return sensor_value_from_float(val, data->pressure_kpa);
+        } else if (chan == SENSOR_CHAN_AMBIENT_TEMP) {
+            return sensor_value_from_float(val, SENSOR_SIM_WATER_TEMP_C);
+        }
+        return -ENOTSUP;
+    case SENSOR_SIM_LEAK:
+        if (chan == SENSOR_CHAN_K2_LEAK) {
+            val->val1 = data->leak;
+            val->val2 = 0;
+            return 0;
+        }
+        return -ENOTSUP;
+    case SENSOR_SIM_VOLTAGE:
+        if (chan == SENSOR_CHAN_VOLTAGE) {
+            return sensor_value_from_float(val, data->voltage_v);
+        }
+        return -ENOTSUP;
+    }
+    return -ENOTSUP;
+}
+
+static const struct sensor_driver_api sensor_sim_api = {
+    .sample_fetch = sensor_sim_sample_fetch,
+    .channel_get = sensor_sim_channel_get,
+};
+
+#define SENSOR_SIM_DEFINE(n)                                                        \
+    static struct sensor_sim_data sensor_sim_data_##n;                              \
+    static const struct sensor_sim_config sensor_sim_config_##n = {                 \
+        .kind = DT_INST_ENUM_IDX(n, kind),                                          \
+    };                                                                              \
+    SENSOR_DEVICE_DT_INST_DEFINE(n, NULL, NULL, &sensor_sim_data_##n,               \
+                                 &sensor_sim_config_##n, POST_KERNEL,               \
+                                 CONFIG_SENSOR_INIT_PRIORITY, &sensor_sim_api);
+
+DT_INST_FOREACH_STATUS_OKAY(SENSOR_SIM_DEFINE)
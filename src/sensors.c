@@ -0,0 +1,407 @@
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/shell/shell.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/sensor.h>
+#include <string.h>
+
+#include "sensors.h"
+#include "setpoint.h"
+#include "cycles.h"
+
+LOG_MODULE_DECLARE(k2_app);
+
+#define SENSORS_STACK_SIZE 1024
+
+// Surface pressure and water density for the depth conversion
+#define SENSORS_SURFACE_KPA     101.325f
+#define SENSORS_WATER_DENSITY   1025.0f   // kg/m^3, seawater
+#define SENSORS_GRAVITY         9.80665f
+
+#define CONSUMER_BIT(c) BIT(c)
+
+/*
+ * Sensor ingestion.
+ *
+ * Every fitted sensor gets its own thread, paced by a k_timer at the
+ * sensor's rate. Each sample is fetched through the sensor API,
+ * timestamped, converted to engineering units and published into one
+ * SPSC ring per consumer. Consumers read samples in place and release
+ * them; the producer never waits on a consumer and drops (and counts)
+ * samples for a consumer that has fallen behind.
+ */
+
+typedef int (*sensor_read_fn_t)(const struct device *dev, void *sample);
+
+struct sensor_source {
+    const char *name;
+    const struct device *dev;
+    uint32_t rate_hz;
+    int priority;
+    uint16_t sample_size;
+    uint8_t consumers;   // CONSUMER_BIT mask
+    sensor_read_fn_t read;
+};
+
+static int read_imu(const struct device *dev, void *sample);
+static int read_depth(const struct device *dev, void *sample);
+static int read_leak(const struct device *dev, void *sample);
+static int read_voltage(const struct device *dev, void *sample);
+
+static struct sensor_source sources[SENSOR_COUNT] = {
+    [SENSOR_IMU] = {
+        .name = "imu",
+        .dev = DEVICE_DT_GET_OR_NULL(DT_ALIAS(imu0)),
+        .rate_hz = SENSORS_IMU_RATE_HZ,
+        .priority = K_PRIO_PREEMPT(0),   // Ahead of the network and control threads
+        .sample_size = sizeof(sensor_imu_sample_t),
+        .consumers = CONSUMER_BIT(SENSOR_CONSUMER_CONTROL),  // Telemetry uses the AHRS output
+        .read = read_imu,
+    },
+    [SENSOR_DEPTH] = {
+        .name = "depth",
+        .dev = DEVICE_DT_GET_OR_NULL(DT_ALIAS(depth0)),
+        .rate_hz = SENSORS_DEPTH_RATE_HZ,
+        .priority = K_PRIO_PREEMPT(3),
+        .sample_size = sizeof(sensor_depth_sample_t),
+        .consumers = CONSUMER_BIT(SENSOR_CONSUMER_CONTROL) | CONSUMER_BIT(SENSOR_CONSUMER_TELEMETRY),
+        .read = read_depth,
+    },
+    [SENSOR_LEAK] = {
+        .name = "leak",
+        .dev = DEVICE_DT_GET_OR_NULL(DT_ALIAS(leak0)),
+        .rate_hz = SENSORS_LEAK_RATE_HZ,
+        .priority = K_PRIO_PREEMPT(8),
+        .sample_size = sizeof(sensor_leak_sample_t),
+        .consumers = CONSUMER_BIT(SENSOR_CONSUMER_TELEMETRY),
+        .read = read_leak,
+    },
+    [SENSOR_VOLTAGE] = {
+        .name = "voltage",
+        .dev = DEVICE_DT_GET_OR_NULL(DT_ALIAS(vbat0)),
+        .rate_hz = SENSORS_VOLTAGE_RATE_HZ,
+        .priority = K_PRIO_PREEMPT(8),
+        .sample_size = sizeof(sensor_voltage_sample_t),
+        .consumers = CONSUMER_BIT(SENSOR_CONSUMER_TELEMETRY),
+        .read = read_voltage,
+    },
+};
+
+// Ring storage, one ring per sensor and consumer
+static sensor_imu_sample_t imu_slots[SENSOR_CONSUMER_COUNT][SENSORS_RING_SIZE];
+static sensor_depth_sample_t depth_slots[SENSOR_CONSUMER_COUNT][SENSORS_RING_SIZE];
+static sensor_leak_sample_t leak_slots[SENSOR_CONSUMER_COUNT][SENSORS_RING_SIZE];
+static sensor_voltage_sample_t voltage_slots[SENSOR_CONSUMER_COUNT][SENSORS_RING_SIZE];
+static sensor_ring_t rings[SENSOR_COUNT][SENSOR_CONSUMER_COUNT];
+
+K_THREAD_STACK_ARRAY_DEFINE(sensor_stacks, SENSOR_COUNT, SENSORS_STACK_SIZE);
+static struct k_thread sensor_threads[SENSOR_COUNT];
+static struct k_timer sensor_timers[SENSOR_COUNT];
+
+// Ingestion statistics, written by the sampling threads
+static sensor_stats_t stats[SENSOR_COUNT];
+static uint32_t last_sample_cycles[SENSOR_COUNT];
+static int64_t stats_since_ms;
+static struct k_spinlock stats_lock;
+
+static void read_vector(const struct device *dev, enum sensor_channel chan, float out[3], int *ret)
+{
+    struct sensor_value v[3];
+
+    if (*ret == 0) {
+        *ret = sensor_channel_get(dev, chan, v);
+    }
+    for (int i = 0; *ret == 0 && i < 3; i++) {
+        out[i] = sensor_value_to_float(&v[i]);
+    }
+}
+
+static int read_imu(const struct device *dev, void *sample)
+{
+    sensor_imu_sample_t *s = sample;
+    int ret = sensor_sample_fetch(dev);
+
+    read_vector(dev, SENSOR_CHAN_ACCEL_XYZ, s->imu.accel, &ret);
+    read_vector(dev, SENSOR_CHAN_GYRO_XYZ, s->imu.gyro, &ret);
+    if (ret == 0) {
+        int mag_ret = 0;
+
+        // Magnetometer is optional; without it the AHRS heading free-runs on the gyro
+        read_vector(dev, SENSOR_CHAN_MAGN_XYZ, s->imu.mag, &mag_ret);
+        s->imu.has_mag = mag_ret == 0;
+    }
+    return ret;
+}
+
+static int read_depth(const struct device *dev, void *sample)
+{
+    sensor_depth_sample_t *s = sample;
+    struct sensor_value v;
+    int ret = sensor_sample_fetch(dev);
+
+    if (ret == 0) {
+        ret = sensor_channel_get(dev, SENSOR_CHAN_PRESS, &v);
+    }
+    if (ret == 0) {
+        s->pressure_kpa = sensor_value_to_float(&v);
+        s->depth_m = (s->pressure_kpa - SENSORS_SURFACE_KPA) * 1000.0f /
+                     (SENSORS_WATER_DENSITY * SENSORS_GRAVITY);
+        s->temperature_c = sensor_channel_get(dev, SENSOR_CHAN_AMBIENT_TEMP, &v) == 0 ?
+                           sensor_value_to_float(&v) : 0.0f;
+    }
+    return ret;
+}
+
+static int read_leak(const struct device *dev, void *sample)
+{
+    sensor_leak_sample_t *s = sample;
+    struct sensor_value v;
+    int ret = sensor_sample_fetch(dev);
+
+    if (ret == 0) {
+        ret = sensor_channel_get(dev, SENSOR_CHAN_K2_LEAK, &v);
+    }
+    if (ret == 0) {
+        s->leak = v.val1 != 0;
+    }
+    return ret;
+}
+
+static int read_voltage(const struct device *dev, void *sample)
+{
+    sensor_voltage_sample_t *s = sample;
+    struct sensor_value v;
+    int ret = sensor_sample_fetch(dev);
+
+    if (ret == 0) {
+        ret = sensor_channel_get(dev, SENSOR_CHAN_VOLTAGE, &v);
+    }
+    if (ret == 0) {
+        s->voltage_v = sensor_value_to_float(&v);
+    }
+    return ret;
+}
+
+/**
+ * Take one sample and publish it to every subscribed consumer
+ */
+static void sensors_sample(enum sensor_id id)
+{
+    const struct sensor_source *src = &sources[id];
+    union {
+        uint32_t timestamp_us;   // Common first member of every sample type
+        sensor_imu_sample_t imu;
+        sensor_depth_sample_t depth;
+        sensor_leak_sample_t leak;
+        sensor_voltage_sample_t voltage;
+    } sample;
+
+    uint32_t start = rov_cycles_now();
+    uint32_t timestamp_us = setpoint_now_us();
+    int ret = src->read(src->dev, &sample);
+    uint32_t fetched = rov_cycles_now();
+
+    if (ret == 0) {
+        sample.timestamp_us = timestamp_us;
+        for (int c = 0; c < SENSOR_CONSUMER_COUNT; c++) {
+            void *slot;
+
+            if ((src->consumers & CONSUMER_BIT(c)) && (slot = sensor_ring_claim(&rings[id][c]))) {
+                memcpy(slot, &sample, src->sample_size);
+                sensor_ring_publish(&rings[id][c]);
+            }
+        }
+    }
+    uint32_t end = rov_cycles_now();
+
+    k_spinlock_key_t key = k_spin_lock(&stats_lock);
+    sensor_stats_t *st = &stats[id];
+    if (ret == 0) {
+        if (st->samples > 0) {
+            uint32_t period = start - last_sample_cycles[id];
+
+            st->period_min_cycles = MIN(st->period_min_cycles, period);
+            st->period_max_cycles = MAX(st->period_max_cycles, period);
+        }
+        last_sample_cycles[id] = start;
+        st->samples++;
+        st->ingest_total_cycles += end - fetched;
+        st->ingest_max_cycles = MAX(st->ingest_max_cycles, end - fetched);
+    } else {
+        st->errors++;
+    }
+    st->fetch_total_cycles += fetched - start;
+    st->fetch_max_cycles = MAX(st->fetch_max_cycles, fetched - start);
+    k_spin_unlock(&stats_lock, key);
+}
+
+static void sensor_thread(void *arg1, void *arg2, void *arg3)
+{
+    ARG_UNUSED(arg2);
+    ARG_UNUSED(arg3);
+
+    enum sensor_id id = (enum sensor_id)(uintptr_t)arg1;
+    k_timeout_t period = K_USEC(1000000 / sources[id].rate_hz);
+
+    k_timer_start(&sensor_timers[id], period, period);
+    while (1) {
+        k_timer_status_sync(&sensor_timers[id]);
+        sensors_sample(id);
+    }
+}
+
+/**
+ * Set up rings for every fitted sensor
+ */
+void sensors_init(void)
+{
+    uint8_t *storage[SENSOR_COUNT][SENSOR_CONSUMER_COUNT];
+
+    for (int c = 0; c < SENSOR_CONSUMER_COUNT; c++) {
+        storage[SENSOR_IMU][c] = (uint8_t *)imu_slots[c];
+        storage[SENSOR_DEPTH][c] = (uint8_t *)depth_slots[c];
+        storage[SENSOR_LEAK][c] = (uint8_t *)leak_slots[c];
+        storage[SENSOR_VOLTAGE][c] = (uint8_t *)voltage_slots[c];
+    }
+
+    for (int id = 0; id < SENSOR_COUNT; id++) {
+        struct sensor_source *src = &sources[id];
+
+        if (src->dev != NULL && !device_is_ready(src->dev)) {
+            LOG_WRN("Sensor %s (%s) not ready", src->name, src->dev->name);
+            src->dev = NULL;
+        }
+        for (int c = 0; c < SENSOR_CONSUMER_COUNT; c++) {
+            rings[id][c] = (sensor_ring_t){
+                .slots = (src->consumers & CONSUMER_BIT(c)) ? storage[id][c] : NULL,
+                .slot_size = src->sample_size,
+            };
+        }
+        k_timer_init(&sensor_timers[id], NULL, NULL);
+        LOG_INF("Sensor %s: %s", src->name, src->dev ? src->dev->name : "not fitted");
+    }
+    sensors_reset_stats();
+}
+
+/**
+ * Start one sampling thread per fitted sensor
+ */
+void sensors_start(void)
+{
+    for (int id = 0; id < SENSOR_COUNT; id++) {
+        if (sources[id].dev == NULL) {
+            continue;
+        }
+        k_thread_create(&sensor_threads[id], sensor_stacks[id],
+                        K_THREAD_STACK_SIZEOF(sensor_stacks[id]),
+                        sensor_thread, (void *)(uintptr_t)id, NULL, NULL,
+                        sources[id].priority, 0, K_NO_WAIT);
+        k_thread_name_set(&sensor_threads[id], sources[id].name);
+    }
+}
+
+/**
+ * Next unread sample of a sensor for one consumer, read in place
+ * @param id: Sensor
+ * @param consumer: Calling consumer (one thread per consumer)
+ * @return: Sample (type per sensor), or NULL if none is pending
+ */
+const void *sensors_peek(enum sensor_id id, enum sensor_consumer consumer)
+{
+    sensor_ring_t *ring = &rings[id][consumer];
+
+    return ring->slots != NULL ? sensor_ring_peek(ring) : NULL;
+}
+
+/**
+ * Free the sample returned by the last sensors_peek()
+ */
+void sensors_release(enum sensor_id id, enum sensor_consumer consumer)
+{
+    sensor_ring_release(&rings[id][consumer]);
+}
+
+/**
+ * Get ingestion statistics for one sensor
+ * @param id: Sensor
+ * @param out: Output copy
+ */
+void sensors_get_stats(enum sensor_id id, sensor_stats_t *out)
+{
+    k_spinlock_key_t key = k_spin_lock(&stats_lock);
+    *out = stats[id];
+    k_spin_unlock(&stats_lock, key);
+
+    for (int c = 0; c < SENSOR_CONSUMER_COUNT; c++) {
+        out->dropped[c] = (uint32_t)atomic_get(&rings[id][c].dropped);
+    }
+}
+
+/**
+ * Clear ingestion statistics
+ */
+void sensors_reset_stats(void)
+{
+    k_spinlock_key_t key = k_spin_lock(&stats_lock);
+    for (int id = 0; id < SENSOR_COUNT; id++) {
+        stats[id] = (sensor_stats_t){
+            .name = sources[id].name,
+            .present = sources[id].dev != NULL,
+            .rate_hz = sources[id].rate_hz,
+            .period_min_cycles = UINT32_MAX,
+        };
+        for (int c = 0; c < SENSOR_CONSUMER_COUNT; c++) {
+            atomic_clear(&rings[id][c].dropped);
+        }
+    }
+    stats_since_ms = k_uptime_get();
+    k_spin_unlock(&stats_lock, key);
+}
+
+static int cmd_sensors_stats(const struct shell *sh, size_t argc, char **argv)
+{
+    if (argc > 1 && strcmp(argv[1], "reset") == 0) {
+        sensors_reset_stats();
+        return 0;
+    }
+
+    int64_t elapsed_ms = k_uptime_get() - stats_since_ms;
+    uint64_t elapsed_cycles = (uint64_t)MAX(elapsed_ms, 1) * rov_cycles_per_sec() / 1000U;
+
+    shell_print(sh, "%-8s %5s %8s %6s %9s  %-15s %-15s %-17s %s", "sensor", "Hz", "samples",
+                "errors", "dropped", "fetch mean/max", "ingest mean/max", "period min/max", "cpu");
+    for (int id = 0; id < SENSOR_COUNT; id++) {
+        sensor_stats_t s;
+        sensors_get_stats(id, &s);
+
+        if (!s.present) {
+            shell_print(sh, "%-8s not fitted", s.name);
+            continue;
+        }
+
+        uint32_t n = MAX(s.samples, 1U);
+        uint64_t busy = s.fetch_total_cycles + s.ingest_total_cycles;
+
+        shell_print(sh, "%-8s %5u %8u %6u %4u/%-4u  %6u/%-6u ns %5u/%-5u ns %6u/%-6u us %u.%02u%%",
+                    s.name, s.rate_hz, s.samples, s.errors,
+                    s.dropped[SENSOR_CONSUMER_CONTROL], s.dropped[SENSOR_CONSUMER_TELEMETRY],
+                    rov_cycles_to_ns((uint32_t)(s.fetch_total_cycles / n)),
+                    rov_cycles_to_ns(s.fetch_max_cycles),
+                    rov_cycles_to_ns((uint32_t)(s.ingest_total_cycles / n)),
+                    rov_cycles_to_ns(s.ingest_max_cycles),
+                    s.samples > 1 ? rov_cycles_to_ns(s.period_min_cycles) / 1000U : 0,
+                    s.samples > 1 ? rov_cycles_to_ns(s.period_max_cycles) / 1000U : 0,
+                    (uint32_t)(busy * 100U / elapsed_cycles),
+                    (uint32_t)(busy * 10000U / elapsed_cycles % 100U));
+    }
+    shell_print(sh, "dropped = control/telemetry consumer; over %lld ms", elapsed_ms);
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sensors_cmds,
+    SHELL_CMD_ARG(stats, NULL, "[reset] Ingestion cost, rate jitter and drops per sensor",
+                  cmd_sensors_stats, 1, 1),
+    SHELL_SUBCMD_SET_END
+);
+
+SHELL_SUBCMD_ADD((rov), sensors, &sensors_cmds, "Sensor ingestion", NULL, 1, 0);
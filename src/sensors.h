@@ -0,0 +1,146 @@
+#pragma once
+
+#include <zephyr/kernel.h>
+#include <zephyr/drivers/sensor.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ahrs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Sampling rates (the AHRS is tuned for the IMU rate)
+#define SENSORS_IMU_RATE_HZ     AHRS_SAMPLE_RATE_HZ
+#define SENSORS_DEPTH_RATE_HZ   50
+#define SENSORS_LEAK_RATE_HZ    10
+#define SENSORS_VOLTAGE_RATE_HZ 10
+
+// Ring capacity per consumer (power of two): 32 ms of IMU data at 1 kHz
+#define SENSORS_RING_SIZE 32
+
+// Leak probe: val1 != 0 means water detected
+#define SENSOR_CHAN_K2_LEAK ((enum sensor_channel)SENSOR_CHAN_PRIV_START)
+
+/*
+ * Sensors are found through devicetree aliases (imu0, depth0, leak0,
+ * vbat0) and read with the Zephyr sensor API. A missing alias just
+ * leaves that sensor out.
+ */
+enum sensor_id {
+    SENSOR_IMU = 0,
+    SENSOR_DEPTH,
+    SENSOR_LEAK,
+    SENSOR_VOLTAGE,
+    SENSOR_COUNT
+};
+
+// Each consumer has its own ring per sensor, so it never waits on another
+enum sensor_consumer {
+    SENSOR_CONSUMER_CONTROL = 0,
+    SENSOR_CONSUMER_TELEMETRY,
+    SENSOR_CONSUMER_COUNT
+};
+
+// Timestamps are in the setpoint timebase (setpoint_now_us)
+typedef struct {
+    uint32_t timestamp_us;
+    ahrs_sample_t imu;
+} sensor_imu_sample_t;
+
+typedef struct {
+    uint32_t timestamp_us;
+    float depth_m;         // Positive down
+    float pressure_kpa;
+    float temperature_c;
+} sensor_depth_sample_t;
+
+typedef struct {
+    uint32_t timestamp_us;
+    bool leak;
+} sensor_leak_sample_t;
+
+typedef struct {
+    uint32_t timestamp_us;
+    float voltage_v;
+} sensor_voltage_sample_t;
+
+/*
+ * Lock-free single-producer single-consumer ring of fixed-size slots.
+ * The producer fills a slot in place and publishes it by advancing head;
+ * the consumer reads the slot in place and frees it by advancing tail.
+ * When full, new samples are dropped (and counted) rather than
+ * overwriting a slot the consumer may be reading.
+ */
+typedef struct {
+    uint8_t *slots;
+    uint16_t slot_size;
+    atomic_t head;      // Written by the producer only
+    atomic_t tail;      // Written by the consumer only
+    atomic_t dropped;
+} sensor_ring_t;
+
+static inline void *sensor_ring_claim(sensor_ring_t *ring)
+{
+    atomic_val_t head = atomic_get(&ring->head);
+
+    if ((uint32_t)head - (uint32_t)atomic_get(&ring->tail) >= SENSORS_RING_SIZE) {
+        atomic_inc(&ring->dropped);
+        return NULL;
+    }
+    return ring->slots + (head & (SENSORS_RING_SIZE - 1)) * ring->slot_size;
+}
+
+static inline void sensor_ring_publish(sensor_ring_t *ring)
+{
+    atomic_inc(&ring->head);
+}
+
+static inline const void *sensor_ring_peek(sensor_ring_t *ring)
+{
+    atomic_val_t tail = atomic_get(&ring->tail);
+
+    if (tail == atomic_get(&ring->head)) {
+        return NULL;
+    }
+    return ring->slots + (tail & (SENSORS_RING_SIZE - 1)) * ring->slot_size;
+}
+
+static inline void sensor_ring_release(sensor_ring_t *ring)
+{
+    atomic_inc(&ring->tail);
+}
+
+// Ingestion cost and timing per sensor
+typedef struct {
+    const char *name;
+    bool present;
+    uint32_t rate_hz;
+    uint32_t samples;
+    uint32_t errors;              // Failed fetches
+    uint32_t dropped[SENSOR_CONSUMER_COUNT];
+    uint32_t fetch_max_cycles;    // Driver: sensor_sample_fetch + channel_get
+    uint64_t fetch_total_cycles;
+    uint32_t ingest_max_cycles;   // Timestamp, convert, ring publish
+    uint64_t ingest_total_cycles;
+    uint32_t period_min_cycles;   // Sample-to-sample interval
+    uint32_t period_max_cycles;
+} sensor_stats_t;
+
+void sensors_init(void);
+void sensors_start(void);
+
+/**
+ * Zero-copy access for one consumer: the next unread sample of a sensor,
+ * or NULL. The pointer stays valid until sensors_release().
+ */
+const void *sensors_peek(enum sensor_id id, enum sensor_consumer consumer);
+void sensors_release(enum sensor_id id, enum sensor_consumer consumer);
+
+void sensors_get_stats(enum sensor_id id, sensor_stats_t *stats);
+void sensors_reset_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,197 @@
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <string.h>
+
+#include "setpoint.h"
+#include "hotpath.h"
+
+LOG_MODULE_DECLARE(k2_app);
+
+BUILD_ASSERT((SETPOINT_RING_SIZE & (SETPOINT_RING_SIZE - 1)) == 0,
+             "SETPOINT_RING_SIZE must be a power of two");
+
+// Bounds for the update interval estimate (topside sends at 20-50 Hz)
+#define SETPOINT_MIN_INTERVAL_US 5000    // Ignore bursts closer than 5 ms
+#define SETPOINT_MAX_INTERVAL_US 200000  // Treat gaps above 200 ms as a new stream
+
+// Timestamped setpoint stored in the ring buffer
+typedef struct {
+    uint32_t timestamp_us;
+    float axes[ROV_AXIS_COUNT];
+} setpoint_entry_t;
+
+// Ring buffer of received setpoints. Written and read by the control thread only.
+static setpoint_entry_t ROV_HOT_BSS ring[SETPOINT_RING_SIZE];
+static uint32_t ring_head;   // Index of the next free slot
+static uint32_t ring_count;  // Number of valid entries (saturates at SETPOINT_RING_SIZE)
+
+// Per-update precomputed terms so that setpoint_sample() is only multiply-adds
+static float base[ROV_AXIS_COUNT];   // Start of the ramp (LINEAR) / newest setpoint (HOLD, FOH)
+static float delta[ROV_AXIS_COUNT];  // newest - previous
+static float inv_interval_us;        // 1 / estimated update interval, 0 when unknown
+
+static setpoint_config_t config = {
+    .mode = SETPOINT_MODE_FOH,
+    .extrapolation_limit_us = 20000,
+    .timeout_us = 500000,
+};
+static struct k_spinlock config_lock;
+
+static inline const setpoint_entry_t *ring_entry(uint32_t age)
+{
+    // age 0 = newest entry, 1 = the one before, ...
+    return &ring[(ring_head - 1 - age) & (SETPOINT_RING_SIZE - 1)];
+}
+
+static inline float clamp_axis(float value)
+{
+    if (value > 1.0f) {
+        return 1.0f;
+    }
+    if (value < -1.0f) {
+        return -1.0f;
+    }
+    return value;
+}
+
+/**
+ * Initialize the setpoint interpolation stage
+ */
+void setpoint_init(void)
+{
+    setpoint_reset();
+    LOG_INF("Setpoint interpolation: mode %d, extrapolation limit %u us, timeout %u us",
+            config.mode, config.extrapolation_limit_us, config.timeout_us);
+}
+
+/**
+ * Drop all stored setpoints (output returns to neutral until the next push)
+ */
+void setpoint_reset(void)
+{
+    ring_head = 0;
+    ring_count = 0;
+    inv_interval_us = 0.0f;
+    memset(base, 0, sizeof(base));
+    memset(delta, 0, sizeof(delta));
+}
+
+/**
+ * Change interpolation mode and limits, safe to call while the control loop runs
+ * @param new_config: New configuration to apply
+ */
+void setpoint_configure(const setpoint_config_t *new_config)
+{
+    k_spinlock_key_t key = k_spin_lock(&config_lock);
+    config = *new_config;
+    k_spin_unlock(&config_lock, key);
+}
+
+/**
+ * Read back the active interpolation configuration
+ * @param out: Destination for the configuration
+ */
+void setpoint_get_config(setpoint_config_t *out)
+{
+    k_spinlock_key_t key = k_spin_lock(&config_lock);
+    *out = config;
+    k_spin_unlock(&config_lock, key);
+}
+
+/**
+ * Store a new setpoint and precompute interpolation terms
+ * @param axes: Normalized axes (-1.0 to +1.0)
+ * @param timestamp_us: Time the command was received
+ */
+void setpoint_push(const float axes[ROV_AXIS_COUNT], uint32_t timestamp_us)
+{
+    setpoint_entry_t *entry = &ring[ring_head & (SETPOINT_RING_SIZE - 1)];
+
+    entry->timestamp_us = timestamp_us;
+    for (int i = 0; i < ROV_AXIS_COUNT; i++) {
+        entry->axes[i] = axes[i];
+    }
+    ring_head++;
+    if (ring_count < SETPOINT_RING_SIZE) {
+        ring_count++;
+    }
+
+    // Drop history across a long gap so we never ramp from a stale value
+    if (ring_count >= 2 &&
+        (timestamp_us - ring_entry(1)->timestamp_us) > SETPOINT_MAX_INTERVAL_US) {
+        ring[0] = *entry;
+        ring_head = 1;
+        ring_count = 1;
+    }
+
+    if (ring_count < 2) {
+        inv_interval_us = 0.0f;
+        for (int i = 0; i < ROV_AXIS_COUNT; i++) {
+            base[i] = axes[i];
+            delta[i] = 0.0f;
+        }
+        return;
+    }
+
+    // Average interval over the whole ring smooths out network jitter
+    const setpoint_entry_t *oldest = ring_entry(ring_count - 1);
+    uint32_t interval_us = (timestamp_us - oldest->timestamp_us) / (ring_count - 1);
+    interval_us = CLAMP(interval_us, SETPOINT_MIN_INTERVAL_US, SETPOINT_MAX_INTERVAL_US);
+    inv_interval_us = 1.0f / (float)interval_us;
+
+    const setpoint_entry_t *previous = ring_entry(1);
+    for (int i = 0; i < ROV_AXIS_COUNT; i++) {
+        base[i] = axes[i];
+        delta[i] = axes[i] - previous->axes[i];
+    }
+}
+
+/**
+ * Evaluate the interpolated setpoint for the current control tick
+ * @param now_us: Current time in the setpoint timebase
+ * @param axes: Output, normalized axes (-1.0 to +1.0)
+ * @return: true if the setpoint is fresh, false if stale (axes set to neutral)
+ */
+ROV_HOT_CODE bool setpoint_sample(uint32_t now_us, float axes[ROV_AXIS_COUNT])
+{
+    setpoint_config_t cfg;
+
+    k_spinlock_key_t key = k_spin_lock(&config_lock);
+    cfg = config;
+    k_spin_unlock(&config_lock, key);
+
+    if (ring_count == 0) {
+        memset(axes, 0, sizeof(float) * ROV_AXIS_COUNT);
+        return false;
+    }
+
+    uint32_t age_us = now_us - ring_entry(0)->timestamp_us;
+    if (age_us > cfg.timeout_us) {
+        memset(axes, 0, sizeof(float) * ROV_AXIS_COUNT);
+        return false;
+    }
+
+    // Fraction of one update interval covered since the newest setpoint
+    float alpha = 0.0f;
+
+    switch (cfg.mode) {
+    case SETPOINT_MODE_LINEAR:
+        // Ramp previous -> newest: output = newest - delta * (1 - alpha)
+        alpha = (float)age_us * inv_interval_us;
+        alpha = (inv_interval_us > 0.0f && alpha < 1.0f) ? alpha - 1.0f : 0.0f;
+        break;
+    case SETPOINT_MODE_FOH:
+        // Continue along the last slope, but only up to the extrapolation limit
+        alpha = (float)MIN(age_us, cfg.extrapolation_limit_us) * inv_interval_us;
+        break;
+    case SETPOINT_MODE_HOLD:
+    default:
+        break;
+    }
+
+    for (int i = 0; i < ROV_AXIS_COUNT; i++) {
+        axes[i] = clamp_axis(base[i] + delta[i] * alpha);
+    }
+
+    return true;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <zephyr/kernel.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "control.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Number of timestamped setpoints kept in the ring buffer (power of two)
+#define SETPOINT_RING_SIZE 8
+
+// Interpolation modes between network updates
+typedef enum {
+    SETPOINT_MODE_HOLD = 0, // Zero-order hold: output the newest setpoint as-is
+    SETPOINT_MODE_LINEAR,   // Ramp from the previous to the newest setpoint over one update interval
+    SETPOINT_MODE_FOH,      // First-order hold: extrapolate along the slope of the last two setpoints
+} setpoint_mode_t;
+
+// Runtime configuration of the interpolation stage
+typedef struct {
+    setpoint_mode_t mode;
+    uint32_t extrapolation_limit_us; // FOH: never extrapolate further than this past the newest setpoint
+    uint32_t timeout_us;             // Setpoint is considered stale (failsafe) after this age
+} setpoint_config_t;
+
+void setpoint_init(void);
+void setpoint_reset(void);
+void setpoint_configure(const setpoint_config_t *config);
+void setpoint_get_config(setpoint_config_t *config);
+
+// Store a new setpoint (normalized axes, -1.0 to +1.0) received at timestamp_us
+void setpoint_push(const float axes[ROV_AXIS_COUNT], uint32_t timestamp_us);
+
+// Evaluate the setpoint at now_us. Returns false (and neutral axes) when stale.
+bool setpoint_sample(uint32_t now_us, float axes[ROV_AXIS_COUNT]);
+
+// Current time in the microsecond timebase used for setpoint timestamps
+static inline uint32_t setpoint_now_us(void)
+{
+    return (uint32_t)k_ticks_to_us_floor64(k_uptime_ticks());
+}
+
+#ifdef __cplusplus
+}
+#endif
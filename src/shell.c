@@ -0,0 +1,9 @@
+#include <zephyr/kernel.h>
+#include <zephyr/shell/shell.h>
+
+/*
+ * Root "rov" shell command. Each module adds its own subcommands with
+ * SHELL_SUBCMD_ADD((rov), ...) next to the code they inspect or tune.
+ */
+SHELL_SUBCMD_SET_CREATE(rov_cmds, (rov));
+SHELL_CMD_REGISTER(rov, &rov_cmds, "ROV inspection and tuning commands", NULL);
@@ -0,0 +1,138 @@
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <math.h>
+
+#include "sim.h"
+
+LOG_MODULE_DECLARE(k2_app);
+
+#define SIM_DT_S (1.0f / ROV_CONTROL_RATE_HZ)
+
+// Heave: full thrust accelerates at 1 m/s^2 up to ~0.6 m/s, slightly buoyant
+#define SIM_HEAVE_ACCEL     1.0f
+#define SIM_HEAVE_DRAG      (SIM_HEAVE_ACCEL / (0.6f * 0.6f))
+#define SIM_BUOYANCY_ACCEL  0.05f
+
+// Yaw: full thrust accelerates at 120 deg/s^2 up to ~60 deg/s
+#define SIM_YAW_ACCEL       120.0f
+#define SIM_YAW_DRAG        (SIM_YAW_ACCEL / (60.0f * 60.0f))
+
+// Sensor noise amplitude (uniform) and gyro bias
+#define SIM_DEPTH_NOISE_M     0.005f
+#define SIM_GYRO_NOISE        0.005f  // rad/s
+#define SIM_ACCEL_NOISE       0.02f   // g
+#define SIM_MAG_NOISE         0.01f
+#define SIM_GYRO_BIAS_Z       0.004f  // rad/s
+#define SIM_VOLTAGE_NOISE     0.02f   // V
+
+// Battery: 4S pack, sagging with total thruster demand
+#define SIM_BATTERY_V         16.4f
+#define SIM_BATTERY_SAG_V     1.5f    // At full demand on all axes
+
+#define DEG_TO_RAD 0.01745329252f
+
+static float depth_m = 1.0f;       // Positive down
+static float depth_rate = 0.0f;
+static float heading_deg = 0.0f;
+static float yaw_rate = 0.0f;
+static float thrust_demand = 0.0f;  // 0..1, mean |axis| of the last command
+static uint32_t noise_state = 12345;
+
+// Uniform noise in -1..+1 from a small LCG (deterministic between runs)
+static float sim_noise(void)
+{
+    noise_state = noise_state * 1664525u + 1013904223u;
+    return (float)(int32_t)noise_state / 2147483648.0f;
+}
+
+/**
+ * Reset the plant to its initial state
+ */
+void sim_init(void)
+{
+    depth_m = 1.0f;
+    depth_rate = 0.0f;
+    heading_deg = 0.0f;
+    yaw_rate = 0.0f;
+    thrust_demand = 0.0f;
+
+    LOG_INF("native_sim plant model active (depth %.1f m, heading %.0f deg)",
+            (double)depth_m, (double)heading_deg);
+}
+
+/**
+ * Advance the plant by one control period
+ * @param axes: Commanded axes after the hold controllers
+ */
+void sim_step(const float axes[ROV_AXIS_COUNT])
+{
+    // Positive heave is upward, depth is positive down
+    float heave_accel = -SIM_HEAVE_ACCEL * axes[ROV_AXIS_HEAVE]
+                        - SIM_HEAVE_DRAG * depth_rate * fabsf(depth_rate)
+                        - SIM_BUOYANCY_ACCEL;
+    depth_rate += heave_accel * SIM_DT_S;
+    depth_m += depth_rate * SIM_DT_S;
+    if (depth_m < 0.0f) {
+        depth_m = 0.0f;   // At the surface
+        depth_rate = 0.0f;
+    }
+
+    float yaw_accel = SIM_YAW_ACCEL * axes[ROV_AXIS_YAW]
+                      - SIM_YAW_DRAG * yaw_rate * fabsf(yaw_rate);
+    yaw_rate += yaw_accel * SIM_DT_S;
+    heading_deg = fmodf(heading_deg + yaw_rate * SIM_DT_S + 360.0f, 360.0f);
+
+    float demand = 0.0f;
+    for (int i = 0; i < ROV_AXIS_COUNT; i++) {
+        demand += fabsf(axes[i]);
+    }
+    thrust_demand = MIN(demand / ROV_AXIS_COUNT, 1.0f);
+}
+
+/**
+ * Emulated depth sensor
+ * @param feedback: Output measurements (heading comes from the AHRS)
+ */
+void sim_get_feedback(hold_feedback_t *feedback)
+{
+    feedback->depth_m = depth_m + SIM_DEPTH_NOISE_M * sim_noise();
+    feedback->depth_valid = true;
+}
+
+/**
+ * Emulated IMU: level vehicle at the plant heading, with noise and gyro bias
+ * @param sample: Output IMU sample
+ */
+void sim_get_imu(ahrs_sample_t *sample)
+{
+    // The filter's yaw runs counter-clockwise, compass heading clockwise
+    const float euler[3] = { 0.0f, 0.0f, -heading_deg * DEG_TO_RAD };
+    const float euler_rate[3] = { 0.0f, 0.0f, -yaw_rate * DEG_TO_RAD };
+
+    ahrs_synthesize(euler, euler_rate, sample);
+
+    sample->gyro[2] += SIM_GYRO_BIAS_Z;
+    for (int i = 0; i < 3; i++) {
+        sample->gyro[i] += SIM_GYRO_NOISE * sim_noise();
+        sample->accel[i] += SIM_ACCEL_NOISE * sim_noise();
+        sample->mag[i] += SIM_MAG_NOISE * sim_noise();
+    }
+}
+
+/**
+ * Emulated leak probe (the simulated hull stays dry)
+ * @return: true if water is detected
+ */
+bool sim_get_leak(void)
+{
+    return false;
+}
+
+/**
+ * Emulated battery monitor
+ * @return: Pack voltage, V
+ */
+float sim_get_battery_voltage(void)
+{
+    return SIM_BATTERY_V - SIM_BATTERY_SAG_V * thrust_demand + SIM_VOLTAGE_NOISE * sim_noise();
+}
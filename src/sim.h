@@ -0,0 +1,26 @@
+#pragma once
+
+#include "control.h"
+#include "hold.h"
+#include "ahrs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Vehicle plant model for native_sim. Stands in for the depth sensor,
+ * IMU, leak probe and battery monitor (read through src/sensor_sim.c):
+ * the commanded axes drive simple heave and yaw dynamics, and the
+ * resulting samples are returned with sensor noise.
+ */
+void sim_init(void);
+void sim_step(const float axes[ROV_AXIS_COUNT]);
+void sim_get_feedback(hold_feedback_t *feedback);   // Depth only
+void sim_get_imu(ahrs_sample_t *sample);
+bool sim_get_leak(void);
+float sim_get_battery_voltage(void);
+
+#ifdef __cplusplus
+}
+#endif
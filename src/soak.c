@@ -0,0 +1,274 @@
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/net/socket.h>
+#include <zephyr/sys/byteorder.h>
+#include <errno.h>
+#include <string.h>
+
+#include "soak.h"
+#include "net.h"
+#include "cmdlog.h"
+#include "telemetry.h"
+#include "stackmon.h"
+
+LOG_MODULE_DECLARE(k2_app);
+
+#define SOAK_STACK_SIZE 2048
+#define SOAK_PRIORITY   K_PRIO_PREEMPT(11)   // Below every other application thread
+#define SOAK_RENEW_MS   (TELEMETRY_LEASE_MS / 2)
+
+K_THREAD_STACK_DEFINE(soak_stack, SOAK_STACK_SIZE);
+static struct k_thread soak_thread_data;
+static K_SEM_DEFINE(soak_go, 0, 1);
+static bool soak_created;               // Shell thread only
+
+static atomic_t soak_busy;
+static atomic_t soak_stop_requested;
+static uint32_t soak_rng = 0x2545f491;  // Soak thread only
+
+static soak_status_t status;
+static struct k_spinlock status_lock;
+
+static uint32_t soak_random(void)
+{
+    // xorshift32: cheap and repeatable from run to run
+    soak_rng ^= soak_rng << 13;
+    soak_rng ^= soak_rng >> 17;
+    soak_rng ^= soak_rng << 5;
+    return soak_rng;
+}
+
+static void soak_count(uint32_t *counter)
+{
+    k_spinlock_key_t key = k_spin_lock(&status_lock);
+    (*counter)++;
+    k_spin_unlock(&status_lock, key);
+}
+
+/**
+ * Send one command packet, as the topside would
+ * @param sock: Soak socket
+ * @param dst: Vehicle command port
+ * @param sequence: Command sequence number
+ * @param corrupt: Flip a CRC bit so the packet is rejected
+ * @return: zsock_sendto() result
+ */
+static int soak_send_command(int sock, const struct sockaddr_in *dst, uint32_t sequence,
+                             bool corrupt)
+{
+    udp_packet_t packet;
+    uint64_t payload = 0;
+
+    // Axes at the ends of their range or anywhere between, so the mixer and
+    // power limiter saturate; light and manipulator change on every command
+    for (int axis = 0; axis < 6; axis++) {
+        uint32_t r = soak_random();
+        uint8_t value = (r & 3) == 0 ? 0 : ((r & 3) == 1 ? 255 : (uint8_t)(r >> 8));
+
+        payload |= (uint64_t)value << (8 * axis);
+    }
+    payload |= (uint64_t)((sequence & 1) ? 255 : 0) << 48;
+    payload |= (uint64_t)(soak_random() & 0xFF) << 56;
+
+    packet.sequence = htonl(sequence);
+    packet.payload = sys_cpu_to_be64(payload);
+    packet.crc32 = htonl(calculate_crc32(&packet, sizeof(packet.sequence) +
+                                         sizeof(packet.payload)) ^ (corrupt ? 1U : 0U));
+    return zsock_sendto(sock, &packet, sizeof(packet), 0, (const struct sockaddr *)dst,
+                        sizeof(*dst));
+}
+
+/**
+ * Subscribe the soak socket to every telemetry topic at the highest rate
+ * @param all: false sends the empty list that ends the subscription
+ */
+static void soak_subscribe(int sock, bool all)
+{
+    uint8_t request[6 + 4 * TELEMETRY_TOPIC_COUNT];
+    int count = all ? TELEMETRY_TOPIC_COUNT : 0;
+    struct sockaddr_in dst = {
+        .sin_family = AF_INET,
+        .sin_port = htons(CONFIG_K2_TELEMETRY_PORT),
+    };
+
+    zsock_inet_pton(AF_INET, STATIC_IP_ADDR, &dst.sin_addr);
+    sys_put_le16(TELEMETRY_MAGIC, &request[0]);
+    request[2] = TELEMETRY_VERSION;
+    request[3] = TELEMETRY_MSG_SUBSCRIBE;
+    request[4] = 1;     // One tick per datagram: the most sends
+    request[5] = (uint8_t)count;
+    for (int topic = 0; topic < count; topic++) {
+        request[6 + 4 * topic] = (uint8_t)topic;
+        request[7 + 4 * topic] = 0;
+        sys_put_le16(TELEMETRY_MAX_RATE_HZ, &request[8 + 4 * topic]);
+    }
+    zsock_sendto(sock, request, 6 + 4 * count, 0, (const struct sockaddr *)&dst, sizeof(dst));
+}
+
+static void soak_drain(int sock)
+{
+    static uint8_t buf[TELEMETRY_MAX_DATAGRAM];
+    ssize_t len;
+
+    while ((len = zsock_recv(sock, buf, sizeof(buf), ZSOCK_MSG_DONTWAIT)) > 0) {
+        k_spinlock_key_t key = k_spin_lock(&status_lock);
+        status.telemetry_bytes += (uint32_t)len;
+        k_spin_unlock(&status_lock, key);
+    }
+}
+
+static void soak_run(uint32_t seconds)
+{
+    struct sockaddr_in dst = {
+        .sin_family = AF_INET,
+        .sin_port = htons(UDP_PORT),
+    };
+    cmdlog_level_t log_level = cmdlog_get_level();
+    uint32_t log_every = cmdlog_get_decimate();
+    int64_t start = k_uptime_get();
+    int64_t end = start + (int64_t)seconds * MSEC_PER_SEC;
+    int64_t next_burst = start;
+    int64_t next_renew = start;
+    uint32_t sequence = 1;
+    int sock;
+
+    sock = zsock_socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (sock < 0) {
+        LOG_ERR("Soak: socket failed: %d", errno);
+        return;
+    }
+    zsock_inet_pton(AF_INET, STATIC_IP_ADDR, &dst.sin_addr);
+
+    // Every command formats its record plus the light/manipulator lines
+    cmdlog_set_level(CMDLOG_VERBOSE);
+    cmdlog_set_decimate(1);
+    LOG_INF("Soak: %u s of worst-case load", seconds);
+
+    while (!atomic_get(&soak_stop_requested)) {
+        int64_t now = k_uptime_get();
+
+        if (now >= end) {
+            break;
+        }
+        if (now >= next_renew) {
+            soak_subscribe(sock, true);
+            next_renew = now + SOAK_RENEW_MS;
+        }
+
+        // Once a second, more commands than the queue holds in one go
+        int count = 1;
+
+        if (now >= next_burst) {
+            count = SOAK_BURST;
+            next_burst = now + MSEC_PER_SEC;
+            soak_count(&status.bursts);
+        }
+        for (int i = 0; i < count; i++, sequence++) {
+            if (sequence % SOAK_SHORT_EVERY == 0) {
+                // Wrong length: the UDP thread's size error path
+                if (zsock_sendto(sock, &sequence, sizeof(sequence), 0,
+                                 (const struct sockaddr *)&dst, sizeof(dst)) < 0) {
+                    soak_count(&status.send_errors);
+                }
+                soak_count(&status.short_packets);
+                continue;
+            }
+
+            bool corrupt = sequence % SOAK_CORRUPT_EVERY == 0;
+
+            if (soak_send_command(sock, &dst, sequence, corrupt) < 0) {
+                soak_count(&status.send_errors);
+            }
+            soak_count(corrupt ? &status.corrupt : &status.commands);
+        }
+        soak_drain(sock);
+
+        k_spinlock_key_t key = k_spin_lock(&status_lock);
+        status.remaining_s = (uint32_t)((end - now + MSEC_PER_SEC - 1) / MSEC_PER_SEC);
+        k_spin_unlock(&status_lock, key);
+
+        k_sleep(K_MSEC(SOAK_PERIOD_MS));
+    }
+
+    soak_subscribe(sock, false);
+    soak_drain(sock);
+    zsock_close(sock);
+    cmdlog_set_level(log_level);
+    cmdlog_set_decimate(log_every);
+
+    LOG_INF("Soak done: %u commands, %u corrupt, %u short, %u bursts, %u send errors",
+            status.commands, status.corrupt, status.short_packets, status.bursts,
+            status.send_errors);
+    stackmon_scan_now();
+}
+
+static void soak_thread(void *arg1, void *arg2, void *arg3)
+{
+    ARG_UNUSED(arg1); ARG_UNUSED(arg2); ARG_UNUSED(arg3);
+
+    while (1) {
+        k_sem_take(&soak_go, K_FOREVER);
+        soak_run(status.duration_s);
+
+        k_spinlock_key_t key = k_spin_lock(&status_lock);
+        status.running = false;
+        status.remaining_s = 0;
+        k_spin_unlock(&status_lock, key);
+        atomic_clear(&soak_busy);
+    }
+}
+
+/**
+ * Start a soak in the background
+ * @param seconds: Duration, 1..SOAK_MAX_SECONDS
+ * @return: 0, -EINVAL, -EBUSY if one is running, -ENETDOWN before the network is up,
+ *          -EPERM on hardware without CONFIG_K2_SOAK_ON_HARDWARE
+ */
+int soak_start(uint32_t seconds)
+{
+    // Full-scale random thruster commands: never on a vehicle unless asked for
+    if (!IS_ENABLED(CONFIG_ARCH_POSIX) && !IS_ENABLED(CONFIG_K2_SOAK_ON_HARDWARE)) {
+        return -EPERM;
+    }
+    if (seconds == 0 || seconds > SOAK_MAX_SECONDS) {
+        return -EINVAL;
+    }
+    if (!network_ready) {
+        return -ENETDOWN;
+    }
+    if (!atomic_cas(&soak_busy, 0, 1)) {
+        return -EBUSY;
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&status_lock);
+    uint32_t runs = status.runs;
+
+    memset(&status, 0, sizeof(status));
+    status.running = true;
+    status.runs = runs + 1;
+    status.duration_s = seconds;
+    status.remaining_s = seconds;
+    k_spin_unlock(&status_lock, key);
+
+    atomic_clear(&soak_stop_requested);
+    if (!soak_created) {
+        k_thread_create(&soak_thread_data, soak_stack, K_THREAD_STACK_SIZEOF(soak_stack),
+                        soak_thread, NULL, NULL, NULL, SOAK_PRIORITY, 0, K_NO_WAIT);
+        k_thread_name_set(&soak_thread_data, "soak");
+        soak_created = true;
+    }
+    k_sem_give(&soak_go);
+    return 0;
+}
+
+void soak_stop(void)
+{
+    atomic_set(&soak_stop_requested, 1);
+}
+
+void soak_get_status(soak_status_t *out)
+{
+    k_spinlock_key_t key = k_spin_lock(&status_lock);
+    *out = status;
+    k_spin_unlock(&status_lock, key);
+}
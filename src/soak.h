@@ -0,0 +1,53 @@
+#pragma once
+
+#include <zephyr/kernel.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Soak load generator for stack sizing (rov stack soak).
+ *
+ * A low-priority thread sends command packets to the vehicle's own address
+ * through the network stack, so they take the same path as the pilot's:
+ * full-scale random axes with light and manipulator changes on every
+ * command, a corrupt CRC every SOAK_CORRUPT_EVERY packets and a short
+ * datagram every SOAK_SHORT_EVERY, and once a second a burst that
+ * overflows the command queue. It also subscribes to every telemetry topic
+ * at the highest rate. While it runs, per-command logging is verbose with
+ * no decimation; both are restored afterwards.
+ *
+ * The commands drive the real outputs, so on hardware the soak only runs
+ * with CONFIG_K2_SOAK_ON_HARDWARE (propellers off or thrusters unpowered).
+ * Its packets come from the vehicle's own address and do not take over the
+ * pilot's telemetry stream.
+ */
+#define SOAK_MAX_SECONDS    3600
+#define SOAK_PERIOD_MS      1       // One command per millisecond between bursts
+#define SOAK_BURST          24      // More than the command queue holds
+#define SOAK_CORRUPT_EVERY  8
+#define SOAK_SHORT_EVERY    16
+
+typedef struct {
+    bool running;
+    uint32_t runs;               // Soaks started since boot
+    uint32_t duration_s;
+    uint32_t remaining_s;
+    uint32_t commands;           // Valid command packets sent
+    uint32_t corrupt;            // Packets with a bad CRC
+    uint32_t short_packets;      // Datagrams of the wrong length
+    uint32_t bursts;
+    uint32_t send_errors;
+    uint32_t telemetry_bytes;    // Telemetry received back on the soak socket
+} soak_status_t;
+
+int soak_start(uint32_t seconds);
+void soak_stop(void);
+void soak_get_status(soak_status_t *status);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,390 @@
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/shell/shell.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "stackmon.h"
+#include "soak.h"
+#include "cycles.h"
+
+LOG_MODULE_DECLARE(k2_app);
+
+#define STACKMON_PAINT 0xaa     // CONFIG_INIT_STACKS fill byte
+
+// Where each stack's size is set, by thread name prefix
+static const struct {
+    const char *prefix;
+    const char *defined_by;
+} stack_sources[] = {
+    { "udp_server", "src/net.c udp_thread_stack" },
+    { "rov_control", "src/control.c rov_control_stack" },
+    { "actuator", "src/actuator.c ACTUATOR_COMMIT_STACK_SIZE" },
+    { "telemetry", "src/telemetry.c TELEMETRY_STACK_SIZE" },
+    { "imu", "src/sensors.c SENSORS_STACK_SIZE" },      // One size for every source
+    { "depth", "src/sensors.c SENSORS_STACK_SIZE" },
+    { "leak", "src/sensors.c SENSORS_STACK_SIZE" },
+    { "voltage", "src/sensors.c SENSORS_STACK_SIZE" },
+    { "soak", "src/soak.c SOAK_STACK_SIZE" },
+    { "main", "CONFIG_MAIN_STACK_SIZE" },
+    { "idle", "CONFIG_IDLE_STACK_SIZE" },
+    { "sysworkq", "CONFIG_SYSTEM_WORKQUEUE_STACK_SIZE" },
+    { "logging", "CONFIG_LOG_PROCESS_THREAD_STACK_SIZE" },
+    { "shell_", "CONFIG_SHELL_STACK_SIZE" },
+    { "rx_q", "CONFIG_NET_RX_STACK_SIZE" },
+    { "tx_q", "CONFIG_NET_TX_STACK_SIZE" },
+    { "net_mgmt", "CONFIG_NET_MGMT_EVENT_STACK_SIZE" },
+};
+
+struct stackmon_slot {
+    const struct k_thread *thread;   // NULL when free
+    bool seen;                       // Still alive in this scan
+    stackmon_entry_t entry;
+};
+
+// Scanner state, system work queue only
+static struct stackmon_slot slots[STACKMON_MAX_STACKS];
+static stackmon_entry_t isr_entry;
+static stackmon_report_t report;
+static bool truncated;
+static uint32_t scan_now_ms;
+
+// Published copy for everyone else
+static stackmon_report_t published;
+static struct k_spinlock report_lock;
+
+static void stackmon_work_handler(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(scan_work, stackmon_work_handler);
+
+#if !defined(CONFIG_ARCH_POSIX)
+K_KERNEL_STACK_ARRAY_DECLARE(z_interrupt_stacks, CONFIG_MP_MAX_NUM_CPUS, CONFIG_ISR_STACK_SIZE);
+#endif
+
+/**
+ * Recommended stack size for a high-water mark
+ * @param high_water: Deepest use in bytes
+ * @return: High-water plus margin, rounded up to STACKMON_ROUND
+ */
+uint32_t stackmon_recommend(uint32_t high_water)
+{
+    uint32_t margin = MAX(high_water * STACKMON_MARGIN_PCT / 100U, (uint32_t)STACKMON_MARGIN_MIN);
+
+    return ROUND_UP(high_water + margin, STACKMON_ROUND);
+}
+
+static void stackmon_update(stackmon_entry_t *e, uint32_t size, uint32_t used)
+{
+    e->size = size;
+    if (used > e->high_water || e->grew_ms == 0) {
+        e->high_water = MAX(e->high_water, used);
+        e->grew_ms = scan_now_ms;
+    }
+    e->recommended = stackmon_recommend(e->high_water);
+}
+
+static void stackmon_name_slot(stackmon_entry_t *e, const struct k_thread *thread)
+{
+    const char *name = k_thread_name_get((k_tid_t)thread);
+
+    e->defined_by = NULL;
+    if (name == NULL || name[0] == '\0') {
+        e->name[0] = '\0';
+        return;
+    }
+    strncpy(e->name, name, sizeof(e->name) - 1);
+    e->name[sizeof(e->name) - 1] = '\0';
+    for (size_t i = 0; i < ARRAY_SIZE(stack_sources); i++) {
+        if (strncmp(name, stack_sources[i].prefix, strlen(stack_sources[i].prefix)) == 0) {
+            e->defined_by = stack_sources[i].defined_by;
+            break;
+        }
+    }
+}
+
+static void stackmon_collect(const struct k_thread *thread, void *user_data)
+{
+    ARG_UNUSED(user_data);
+
+    struct stackmon_slot *slot = NULL;
+    struct stackmon_slot *free_slot = NULL;
+    size_t unused;
+
+    for (int i = 0; i < STACKMON_MAX_STACKS; i++) {
+        if (slots[i].thread == thread) {
+            slot = &slots[i];
+            break;
+        }
+        if (slots[i].thread == NULL && free_slot == NULL) {
+            free_slot = &slots[i];
+        }
+    }
+    if (slot == NULL) {
+        if (free_slot == NULL) {
+            truncated = true;
+            return;
+        }
+        slot = free_slot;
+        slot->thread = thread;
+        memset(&slot->entry, 0, sizeof(slot->entry));
+    }
+    if (slot->entry.name[0] == '\0') {
+        stackmon_name_slot(&slot->entry, thread);
+    }
+
+    slot->seen = true;
+    if (k_thread_stack_space_get(thread, &unused) != 0) {
+        return;
+    }
+    stackmon_update(&slot->entry, thread->stack_info.size,
+                    thread->stack_info.size - MIN(unused, thread->stack_info.size));
+}
+
+/**
+ * Deepest use of the interrupt stack (painted by the reset code)
+ * @param size: Output, stack size
+ * @return: Bytes used, or -1 where there is no separate interrupt stack
+ */
+static int stackmon_isr_used(uint32_t *size)
+{
+#if !defined(CONFIG_ARCH_POSIX)
+    const uint8_t *buf = (const uint8_t *)K_KERNEL_STACK_BUFFER(z_interrupt_stacks[0]);
+    size_t n = K_KERNEL_STACK_SIZEOF(z_interrupt_stacks[0]);
+    size_t unused = 0;
+
+    // Descending stack: bytes never reached keep the paint at the low end
+    while (unused < n && buf[unused] == STACKMON_PAINT) {
+        unused++;
+    }
+    *size = (uint32_t)n;
+    return (int)(n - unused);
+#else
+    ARG_UNUSED(size);
+    return -1;
+#endif
+}
+
+static void stackmon_scan(void)
+{
+    uint32_t start = rov_cycles_now();
+    uint32_t isr_size;
+    int isr_used;
+
+    scan_now_ms = k_uptime_get_32();
+    for (int i = 0; i < STACKMON_MAX_STACKS; i++) {
+        slots[i].seen = false;
+    }
+    truncated = false;
+    k_thread_foreach_unlocked(stackmon_collect, NULL);
+
+    report.count = 0;
+    isr_used = stackmon_isr_used(&isr_size);
+    if (isr_used >= 0) {
+        strncpy(isr_entry.name, "ISR", sizeof(isr_entry.name));
+        isr_entry.defined_by = "CONFIG_ISR_STACK_SIZE";
+        isr_entry.isr = true;
+        stackmon_update(&isr_entry, isr_size, (uint32_t)isr_used);
+        report.stacks[report.count++] = isr_entry;
+    }
+    for (int i = 0; i < STACKMON_MAX_STACKS; i++) {
+        struct stackmon_slot *slot = &slots[i];
+
+        if (slot->thread == NULL) {
+            continue;
+        }
+        if (!slot->seen) {
+            slot->thread = NULL;    // Exited
+            continue;
+        }
+        if (report.count < STACKMON_MAX_STACKS) {
+            report.stacks[report.count++] = slot->entry;
+        } else {
+            truncated = true;
+        }
+    }
+    report.truncated = truncated;
+    report.timestamp_ms = scan_now_ms;
+    report.scans++;
+    report.scan_cycles = rov_cycles_now() - start;
+    report.scan_max_cycles = MAX(report.scan_max_cycles, report.scan_cycles);
+
+    k_spinlock_key_t key = k_spin_lock(&report_lock);
+    published = report;
+    k_spin_unlock(&report_lock, key);
+}
+
+static void stackmon_work_handler(struct k_work *work)
+{
+    ARG_UNUSED(work);
+
+    stackmon_scan();
+    k_work_schedule(&scan_work, K_MSEC(STACKMON_PERIOD_MS));
+}
+
+/**
+ * Start the periodic scan (system work queue)
+ */
+void stackmon_start(void)
+{
+    k_work_schedule(&scan_work, K_NO_WAIT);
+}
+
+void stackmon_scan_now(void)
+{
+    k_work_reschedule(&scan_work, K_NO_WAIT);
+}
+
+void stackmon_get_report(stackmon_report_t *out)
+{
+    k_spinlock_key_t key = k_spin_lock(&report_lock);
+    *out = published;
+    k_spin_unlock(&report_lock, key);
+}
+
+static void stackmon_print_soak(const struct shell *sh)
+{
+    soak_status_t soak;
+
+    soak_get_status(&soak);
+    if (soak.running) {
+        shell_print(sh, "soak running: %u s left, %u commands, %u corrupt, %u short, %u bursts",
+                    soak.remaining_s, soak.commands, soak.corrupt, soak.short_packets,
+                    soak.bursts);
+    } else if (soak.runs > 0) {
+        shell_print(sh, "last soak: %u s, %u commands, %u corrupt, %u short, %u bursts",
+                    soak.duration_s, soak.commands, soak.corrupt, soak.short_packets,
+                    soak.bursts);
+    } else {
+        shell_warn(sh, "No soak run yet: 'rov stack soak <seconds>' drives the worst-case paths");
+    }
+}
+
+static int cmd_stack_show(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    static stackmon_report_t r;
+
+    stackmon_get_report(&r);
+    if (r.scans == 0) {
+        shell_print(sh, "No scan yet");
+        return 0;
+    }
+    shell_print(sh, "stack             size  high-water  use%%  recommend  change   grew@s  size set by");
+    for (int i = 0; i < r.count; i++) {
+        const stackmon_entry_t *e = &r.stacks[i];
+        uint32_t use = e->size > 0 ? e->high_water * 100U / e->size : 0U;
+        int32_t change = (int32_t)e->recommended - (int32_t)e->size;
+
+        shell_print(sh, "%-16s %5u %11u %4u%% %10u %+7d %8u  %s%s", e->name[0] ? e->name : "?",
+                    e->size, e->high_water, use, e->recommended, change, e->grew_ms / 1000U,
+                    e->defined_by != NULL ? e->defined_by : "-",
+                    e->high_water + STACKMON_MARGIN_MIN > e->size ? "  LOW" : "");
+    }
+    if (r.truncated) {
+        shell_warn(sh, "More than %d stacks, list truncated", STACKMON_MAX_STACKS);
+    }
+    shell_print(sh, "recommend = high-water + %d %% (min %d B), rounded to %d B; "
+                "scan every %d ms, %u us (max %u us)",
+                STACKMON_MARGIN_PCT, STACKMON_MARGIN_MIN, STACKMON_ROUND, STACKMON_PERIOD_MS,
+                rov_cycles_to_ns(r.scan_cycles) / 1000U, rov_cycles_to_ns(r.scan_max_cycles) / 1000U);
+    if (IS_ENABLED(CONFIG_ARCH_POSIX)) {
+        shell_warn(sh, "native_sim: threads run on host stacks, use hardware numbers for sizing");
+    }
+    stackmon_print_soak(sh);
+    return 0;
+}
+
+static int cmd_stack_conf(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    static stackmon_report_t r;
+    bool done[STACKMON_MAX_STACKS] = { false };
+
+    stackmon_get_report(&r);
+    if (r.scans == 0) {
+        shell_print(sh, "No scan yet");
+        return 0;
+    }
+
+    // One line per setting; stacks sharing a setting take the largest recommendation
+    for (int i = 0; i < r.count; i++) {
+        const char *by = r.stacks[i].defined_by;
+        uint32_t size = r.stacks[i].size;
+        uint32_t high_water = r.stacks[i].high_water;
+        uint32_t recommended = r.stacks[i].recommended;
+
+        if (done[i] || by == NULL) {
+            continue;
+        }
+        for (int j = i + 1; j < r.count; j++) {
+            if (r.stacks[j].defined_by == by) {
+                high_water = MAX(high_water, r.stacks[j].high_water);
+                recommended = MAX(recommended, r.stacks[j].recommended);
+                size = MAX(size, r.stacks[j].size);
+                done[j] = true;
+            }
+        }
+        if (strncmp(by, "CONFIG_", 7) == 0) {
+            shell_print(sh, "%s=%u    # now %u, high-water %u", by, recommended, size, high_water);
+        } else {
+            shell_print(sh, "# %s: %u (now %u, high-water %u)", by, recommended, size, high_water);
+        }
+    }
+    stackmon_print_soak(sh);
+    return 0;
+}
+
+static int cmd_stack_soak(const struct shell *sh, size_t argc, char **argv)
+{
+    int ret;
+
+    if (argc < 2) {
+        stackmon_print_soak(sh);
+        return 0;
+    }
+    if (strcmp(argv[1], "stop") == 0) {
+        soak_stop();
+        shell_print(sh, "Soak stopping");
+        return 0;
+    }
+
+    ret = soak_start(strtoul(argv[1], NULL, 10));
+    if (ret == -EBUSY) {
+        shell_error(sh, "Soak already running ('rov stack soak stop')");
+    } else if (ret == -ENETDOWN) {
+        shell_error(sh, "Network not ready");
+    } else if (ret == -EPERM) {
+        shell_error(sh, "Soak drives the thrusters at full scale; build with "
+                    "CONFIG_K2_SOAK_ON_HARDWARE=y to allow it on hardware");
+    } else if (ret != 0) {
+        shell_error(sh, "Duration must be 1..%d s", SOAK_MAX_SECONDS);
+    } else {
+        shell_print(sh, "Soak started; check 'rov stack show' when it is done");
+    }
+    return ret;
+}
+
+static int cmd_stack_scan(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    stackmon_scan_now();
+    shell_print(sh, "Scan queued");
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(stack_cmds,
+    SHELL_CMD(show, NULL, "High-water mark and recommended size of every stack", cmd_stack_show),
+    SHELL_CMD(conf, NULL, "Recommended sizes as config/source settings", cmd_stack_conf),
+    SHELL_CMD_ARG(soak, NULL, "[<seconds>|stop] Drive the worst-case paths (status without args)",
+                  cmd_stack_soak, 1, 1),
+    SHELL_CMD(scan, NULL, "Scan now instead of at the next period", cmd_stack_scan),
+    SHELL_SUBCMD_SET_END
+);
+
+SHELL_SUBCMD_ADD((rov), stack, &stack_cmds, "Stack high-water marks and right-sizing", NULL, 1, 0);
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <zephyr/kernel.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Stack high-water monitoring.
+ *
+ * Once per STACKMON_PERIOD_MS a work item on the system work queue scans
+ * every thread stack (and the interrupt stack) for the deepest byte ever
+ * written (CONFIG_INIT_STACKS paints stacks at creation) and remembers
+ * when each high-water mark last grew. The report recommends a size per
+ * stack: the high-water mark plus STACKMON_MARGIN_PCT (at least
+ * STACKMON_MARGIN_MIN bytes), rounded up to STACKMON_ROUND. Run a soak
+ * (soak.h) first so the worst-case paths have been through.
+ *
+ * On native_sim threads run on host stacks, so the numbers only show what
+ * the Zephyr stack buffers hold; sizes come from hardware runs.
+ */
+#define STACKMON_PERIOD_MS   1000
+#define STACKMON_MAX_STACKS  24
+#define STACKMON_MARGIN_PCT  25
+#define STACKMON_MARGIN_MIN  256
+#define STACKMON_ROUND       64
+
+typedef struct {
+    char name[16];
+    const char *defined_by;      // Kconfig option or source symbol setting the size, or NULL
+    uint32_t size;
+    uint32_t high_water;         // Deepest use since boot, bytes
+    uint32_t grew_ms;            // Uptime when the high-water mark last grew
+    uint32_t recommended;
+    bool isr;                    // Interrupt stack
+} stackmon_entry_t;
+
+typedef struct {
+    uint32_t timestamp_ms;       // Uptime of the newest scan
+    uint32_t scans;
+    uint8_t count;
+    bool truncated;              // More stacks than STACKMON_MAX_STACKS
+    stackmon_entry_t stacks[STACKMON_MAX_STACKS];
+    uint32_t scan_cycles;        // Cost of the newest scan
+    uint32_t scan_max_cycles;
+} stackmon_report_t;
+
+void stackmon_start(void);
+void stackmon_scan_now(void);    // Queue an immediate scan
+void stackmon_get_report(stackmon_report_t *report);
+uint32_t stackmon_recommend(uint32_t high_water);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,1284 @@
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/shell/shell.h>
+#include <zephyr/net/socket.h>
+#include <zephyr/sys/byteorder.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "telemetry.h"
+#include "control.h"
+#include "actuator.h"
+#include "power.h"
+#include "sensors.h"
+#include "setpoint.h"
+#include "ahrs.h"
+#include "net.h"
+#include "led.h"
+#include "cycles.h"
+#include "cpuload.h"
+#include "health.h"
+#include "wcet.h"
+#if defined(CONFIG_K2_TELEMETRY_ZERO_COPY)
+#include "telemetry_pkt.h"
+#endif
+
+LOG_MODULE_DECLARE(k2_app);
+
+#define TELEMETRY_STACK_SIZE 2048
+#define TELEMETRY_PRIORITY   K_PRIO_PREEMPT(10)
+
+// Depth older than this is reported as invalid (same limit as the depth hold)
+#define TELEMETRY_DEPTH_TIMEOUT_US 100000
+
+// Timer wheel: one rotation is 64 ticks, longer periods count rounds
+#define TELEMETRY_WHEEL_SLOTS 64
+#define TELEMETRY_TIMER_NONE  0xFF
+
+#define TELEMETRY_PAYLOAD_MAX 84
+#define TELEMETRY_TAG_SIZE    2   // Topic and length in front of each payload
+#define TELEMETRY_REQUEST_MAX (6 + 4 * TELEMETRY_TOPIC_COUNT)
+#define TELEMETRY_RX_PER_TICK 4   // Subscribe requests handled per tick
+#define TELEMETRY_CPULOAD_TICKS (TELEMETRY_TICK_HZ * CPULOAD_SAMPLE_MS / 1000)
+
+// Subscriber slot of the pilot's default subscription
+#define TELEMETRY_PILOT 0
+#define TELEMETRY_PILOT_TOPICS (BIT(TELEMETRY_TOPIC_ATTITUDE) | BIT(TELEMETRY_TOPIC_COMMAND) | \
+                                BIT(TELEMETRY_TOPIC_THRUSTERS) | BIT(TELEMETRY_TOPIC_SENSORS) | \
+                                BIT(TELEMETRY_TOPIC_LINK) | BIT(TELEMETRY_TOPIC_SYSTEM))
+
+/*
+ * Telemetry uplink.
+ *
+ * A single low-priority thread runs a timer wheel at TELEMETRY_TICK_HZ.
+ * Each (subscriber, topic) pair has one statically allocated timer on the
+ * wheel; a tick collects the timers that expire in its slot into a
+ * per-subscriber "due" mask. The vehicle state is then gathered once, each
+ * topic that anyone needs is encoded once into a shared payload, and the
+ * payloads are appended to every due subscriber's datagram. A subscriber's
+ * datagram goes out when it holds `batch` ticks of data or the next tick
+ * would not fit. The same thread polls the socket for subscribe requests,
+ * so nothing here blocks.
+ *
+ * Datagrams are built either in the subscriber's preallocated buffer and
+ * sent with a non-blocking sendto (which copies them into a net_pkt), or,
+ * with CONFIG_K2_TELEMETRY_ZERO_COPY, straight into a net_pkt allocated
+ * when the batch starts, sized for the whole batch and trimmed on send.
+ */
+
+typedef void (*telemetry_encode_fn_t)(const telemetry_sample_t *s, uint8_t *dst);
+
+static void encode_attitude(const telemetry_sample_t *s, uint8_t *dst);
+static void encode_command(const telemetry_sample_t *s, uint8_t *dst);
+static void encode_thrusters(const telemetry_sample_t *s, uint8_t *dst);
+static void encode_power(const telemetry_sample_t *s, uint8_t *dst);
+static void encode_sensors(const telemetry_sample_t *s, uint8_t *dst);
+static void encode_link(const telemetry_sample_t *s, uint8_t *dst);
+static void encode_system(const telemetry_sample_t *s, uint8_t *dst);
+static void encode_latency(const telemetry_sample_t *s, uint8_t *dst);
+static void encode_cpu(const telemetry_sample_t *s, uint8_t *dst);
+static void encode_health(const telemetry_sample_t *s, uint8_t *dst);
+static void encode_wcet(const telemetry_sample_t *s, uint8_t *dst);
+
+// Payload sizes; each must fit the shared per-topic buffer (payloads[] below)
+#define TOPIC_SIZE_ATTITUDE   10
+#define TOPIC_SIZE_COMMAND    20
+#define TOPIC_SIZE_THRUSTERS  24
+#define TOPIC_SIZE_POWER      36
+#define TOPIC_SIZE_SENSORS    14
+#define TOPIC_SIZE_LINK       20
+#define TOPIC_SIZE_SYSTEM     8
+#define TOPIC_SIZE_LATENCY    (4 + 20 * LATENCY_SEGMENT_COUNT)
+#define TOPIC_SIZE_CPU        (12 + 4 * CPULOAD_GROUP_COUNT)
+#define TOPIC_SIZE_HEALTH     56
+#define TOPIC_SIZE_WCET       (12 + 8 * WCET_STAGE_COUNT)
+
+BUILD_ASSERT(TOPIC_SIZE_ATTITUDE <= TELEMETRY_PAYLOAD_MAX, "attitude payload too large");
+BUILD_ASSERT(TOPIC_SIZE_COMMAND <= TELEMETRY_PAYLOAD_MAX, "command payload too large");
+BUILD_ASSERT(TOPIC_SIZE_THRUSTERS <= TELEMETRY_PAYLOAD_MAX, "thrusters payload too large");
+BUILD_ASSERT(TOPIC_SIZE_POWER <= TELEMETRY_PAYLOAD_MAX, "power payload too large");
+BUILD_ASSERT(TOPIC_SIZE_SENSORS <= TELEMETRY_PAYLOAD_MAX, "sensors payload too large");
+BUILD_ASSERT(TOPIC_SIZE_LINK <= TELEMETRY_PAYLOAD_MAX, "link payload too large");
+BUILD_ASSERT(TOPIC_SIZE_SYSTEM <= TELEMETRY_PAYLOAD_MAX, "system payload too large");
+BUILD_ASSERT(TOPIC_SIZE_LATENCY <= TELEMETRY_PAYLOAD_MAX, "latency payload too large");
+BUILD_ASSERT(TOPIC_SIZE_CPU <= TELEMETRY_PAYLOAD_MAX, "cpu payload too large");
+BUILD_ASSERT(TOPIC_SIZE_HEALTH <= TELEMETRY_PAYLOAD_MAX, "health payload too large");
+BUILD_ASSERT(TOPIC_SIZE_WCET <= TELEMETRY_PAYLOAD_MAX, "wcet payload too large");
+
+// Topic registry (payload layouts mirrored in telemetry_rx.py)
+static const struct telemetry_topic_def {
+    const char *name;
+    uint8_t size;
+    telemetry_encode_fn_t encode;
+} topics[TELEMETRY_TOPIC_COUNT] = {
+    [TELEMETRY_TOPIC_ATTITUDE] = { "attitude", TOPIC_SIZE_ATTITUDE, encode_attitude },
+    [TELEMETRY_TOPIC_COMMAND] = { "command", TOPIC_SIZE_COMMAND, encode_command },
+    [TELEMETRY_TOPIC_THRUSTERS] = { "thrusters", TOPIC_SIZE_THRUSTERS, encode_thrusters },
+    [TELEMETRY_TOPIC_POWER] = { "power", TOPIC_SIZE_POWER, encode_power },
+    [TELEMETRY_TOPIC_SENSORS] = { "sensors", TOPIC_SIZE_SENSORS, encode_sensors },
+    [TELEMETRY_TOPIC_LINK] = { "link", TOPIC_SIZE_LINK, encode_link },
+    [TELEMETRY_TOPIC_SYSTEM] = { "system", TOPIC_SIZE_SYSTEM, encode_system },
+    [TELEMETRY_TOPIC_LATENCY] = { "latency", TOPIC_SIZE_LATENCY, encode_latency },
+    [TELEMETRY_TOPIC_CPU] = { "cpu", TOPIC_SIZE_CPU, encode_cpu },
+    [TELEMETRY_TOPIC_HEALTH] = { "health", TOPIC_SIZE_HEALTH, encode_health },
+    [TELEMETRY_TOPIC_WCET] = { "wcet", TOPIC_SIZE_WCET, encode_wcet },
+};
+
+// One wheel timer per (subscriber, topic), chained by index within a slot
+struct telemetry_timer {
+    uint8_t next;
+    uint8_t slot;
+    bool armed;
+    uint16_t period_ticks;
+    uint16_t rounds;        // Full rotations left before it fires
+};
+
+struct telemetry_subscriber {
+    telemetry_subscriber_info_t info;   // Config and counters (shell reads under the lock)
+    int64_t lease_expiry_ms;
+    uint32_t due;                       // Topics due this tick
+    uint32_t ticks_pending;             // Ticks of data in the datagram
+    size_t tick_max;                    // Bytes when every subscribed topic is due
+    size_t length;                      // Datagram bytes, header included
+    uint32_t batch_seq;
+#if defined(CONFIG_K2_TELEMETRY_ZERO_COPY)
+    telemetry_pkt_t pkt;                // Datagram being built in a net_pkt, if any
+#endif
+    uint8_t __aligned(4) buffer[TELEMETRY_MAX_DATAGRAM];
+};
+
+BUILD_ASSERT(TELEMETRY_MAX_SUBSCRIBERS * TELEMETRY_TOPIC_COUNT < TELEMETRY_TIMER_NONE,
+             "Timer index does not fit");
+BUILD_ASSERT((TELEMETRY_WHEEL_SLOTS & (TELEMETRY_WHEEL_SLOTS - 1)) == 0,
+             "Wheel size must be a power of two");
+BUILD_ASSERT(CONFIG_K2_TELEMETRY_BATCH <= TELEMETRY_MAX_BATCH, "Telemetry batch too large");
+BUILD_ASSERT(TELEMETRY_CPULOAD_TICKS * 1000 == TELEMETRY_TICK_HZ * CPULOAD_SAMPLE_MS,
+             "CPU load sample period must be a whole number of ticks");
+
+K_THREAD_STACK_DEFINE(telemetry_stack, TELEMETRY_STACK_SIZE);
+static struct k_thread telemetry_thread_data;
+K_TIMER_DEFINE(telemetry_timer, NULL, NULL);
+
+static atomic_t pilot_rate_hz = ATOMIC_INIT(CONFIG_K2_TELEMETRY_RATE_HZ);
+static atomic_t default_batch = ATOMIC_INIT(CONFIG_K2_TELEMETRY_BATCH);
+static atomic_t zero_copy = ATOMIC_INIT(IS_ENABLED(CONFIG_K2_TELEMETRY_ZERO_COPY));
+
+// Telemetry thread only
+static struct telemetry_timer timers[TELEMETRY_MAX_SUBSCRIBERS * TELEMETRY_TOPIC_COUNT];
+static uint8_t wheel[TELEMETRY_WHEEL_SLOTS];
+static uint32_t wheel_tick;
+static uint8_t payloads[TELEMETRY_TOPIC_COUNT][TELEMETRY_TAG_SIZE + TELEMETRY_PAYLOAD_MAX];
+static uint8_t rx_buffer[TELEMETRY_REQUEST_MAX];
+static int telemetry_sock = -1;
+static uint32_t pilot_rate_applied;
+
+// Newest sensor values seen on the telemetry rings (telemetry thread only)
+static sensor_depth_sample_t last_depth;
+static sensor_leak_sample_t last_leak;
+static sensor_voltage_sample_t last_voltage;
+static bool have_depth;
+
+static struct telemetry_subscriber subscribers[TELEMETRY_MAX_SUBSCRIBERS];
+static telemetry_sample_t last_sample;
+static bool have_last;
+static telemetry_stats_t stats;
+static struct k_spinlock telemetry_lock;
+
+static int16_t telemetry_q15(float value)
+{
+    return (int16_t)(CLAMP(value, -1.0f, 1.0f) * 32767.0f);
+}
+
+static uint16_t telemetry_u16(float value)
+{
+    return (uint16_t)(CLAMP(value, 0.0f, 1.0f) * 65535.0f);
+}
+
+static void telemetry_count(uint32_t *counter)
+{
+    k_spinlock_key_t key = k_spin_lock(&telemetry_lock);
+    (*counter)++;
+    k_spin_unlock(&telemetry_lock, key);
+}
+
+static void telemetry_put_float(float value, uint8_t *dst)
+{
+    uint32_t bits;
+
+    memcpy(&bits, &value, sizeof(bits));
+    sys_put_le32(bits, dst);
+}
+
+static void encode_attitude(const telemetry_sample_t *s, uint8_t *dst)
+{
+    sys_put_le32(s->timestamp_us, &dst[0]);
+    sys_put_le16((uint16_t)(int16_t)(s->roll_deg * 100.0f), &dst[4]);
+    sys_put_le16((uint16_t)(int16_t)(s->pitch_deg * 100.0f), &dst[6]);
+    sys_put_le16((uint16_t)(s->heading_deg * 100.0f) % 36000U, &dst[8]);
+}
+
+static void encode_command(const telemetry_sample_t *s, uint8_t *dst)
+{
+    const rov_command_t *cmd = &s->command;
+
+    sys_put_le32(s->timestamp_us, &dst[0]);
+    sys_put_le32(cmd->sequence, &dst[4]);
+    sys_put_le32(s->command_age_us, &dst[8]);
+    dst[12] = (uint8_t)cmd->surge;
+    dst[13] = (uint8_t)cmd->sway;
+    dst[14] = (uint8_t)cmd->heave;
+    dst[15] = (uint8_t)cmd->roll;
+    dst[16] = (uint8_t)cmd->pitch;
+    dst[17] = (uint8_t)cmd->yaw;
+    dst[18] = cmd->light;
+    dst[19] = cmd->manipulator;
+}
+
+static void encode_thrusters(const telemetry_sample_t *s, uint8_t *dst)
+{
+    sys_put_le32(s->timestamp_us, &dst[0]);
+    for (int i = 0; i < ROV_THRUSTER_COUNT; i++) {
+        sys_put_le16((uint16_t)telemetry_q15(s->thrust[i]), &dst[4 + 2 * i]);
+    }
+    sys_put_le16(telemetry_u16(s->light), &dst[20]);
+    sys_put_le16(telemetry_u16(s->manipulator), &dst[22]);
+}
+
+static void encode_power(const telemetry_sample_t *s, uint8_t *dst)
+{
+    sys_put_le32(s->timestamp_us, &dst[0]);
+    telemetry_put_float(s->requested_a, &dst[4]);
+    telemetry_put_float(s->delivered_a, &dst[8]);
+    telemetry_put_float(s->power_scale, &dst[12]);
+    telemetry_put_float(s->voltage_v, &dst[16]);
+    for (int i = 0; i < ROV_THRUSTER_COUNT; i++) {
+        // 0.01 A
+        sys_put_le16((uint16_t)CLAMP(s->thruster_current_a[i] * 100.0f, 0.0f, 65535.0f),
+                     &dst[20 + 2 * i]);
+    }
+}
+
+static void encode_sensors(const telemetry_sample_t *s, uint8_t *dst)
+{
+    sys_put_le32(s->timestamp_us, &dst[0]);
+    telemetry_put_float(s->depth_m, &dst[4]);
+    telemetry_put_float(s->voltage_v, &dst[8]);
+    dst[12] = s->flags & (TELEMETRY_FLAG_LEAK | TELEMETRY_FLAG_DEPTH_VALID);
+    dst[13] = 0;
+}
+
+static void encode_link(const telemetry_sample_t *s, uint8_t *dst)
+{
+    sys_put_le32(s->timestamp_us, &dst[0]);
+    sys_put_le32(s->rx_packets, &dst[4]);
+    sys_put_le32(s->crc_errors, &dst[8]);
+    sys_put_le32(s->size_errors, &dst[12]);
+    sys_put_le32(s->queue_drops, &dst[16]);
+}
+
+static void encode_system(const telemetry_sample_t *s, uint8_t *dst)
+{
+    sys_put_le32(s->timestamp_us, &dst[0]);
+    sys_put_le16(s->cpu_load, &dst[4]);
+    dst[6] = s->flags;
+    dst[7] = 0;
+}
+
+static void encode_latency(const telemetry_sample_t *s, uint8_t *dst)
+{
+    sys_put_le32(s->timestamp_us, &dst[0]);
+    for (int i = 0; i < LATENCY_SEGMENT_COUNT; i++) {
+        const latency_summary_t *l = &s->latency[i];
+        uint8_t *seg = &dst[4 + 20 * i];
+
+        sys_put_le32(l->count, &seg[0]);
+        sys_put_le32(l->p50_ns, &seg[4]);
+        sys_put_le32(l->p90_ns, &seg[8]);
+        sys_put_le32(l->p99_ns, &seg[12]);
+        sys_put_le32(l->max_ns, &seg[16]);
+    }
+}
+
+static void encode_cpu(const telemetry_sample_t *s, uint8_t *dst)
+{
+    const cpuload_summary_t *c = &s->cpu;
+
+    sys_put_le32(s->timestamp_us, &dst[0]);
+    sys_put_le16(c->total[CPULOAD_WINDOW_1S], &dst[4]);
+    sys_put_le16(c->total[CPULOAD_WINDOW_10S], &dst[6]);
+    sys_put_le16(c->peak, &dst[8]);
+    sys_put_le16(0, &dst[10]);
+    for (int i = 0; i < CPULOAD_GROUP_COUNT; i++) {
+        sys_put_le16(c->group[i][CPULOAD_WINDOW_1S], &dst[12 + 4 * i]);
+        sys_put_le16(c->group[i][CPULOAD_WINDOW_10S], &dst[14 + 4 * i]);
+    }
+}
+
+static void encode_health(const telemetry_sample_t *s, uint8_t *dst)
+{
+    const health_record_t *h = &s->health;
+
+    sys_put_le32(s->timestamp_us, &dst[0]);
+    sys_put_le32(h->uptime_s, &dst[4]);
+    sys_put_le16(h->flags, &dst[8]);
+    sys_put_le16(h->command_rate_hz, &dst[10]);
+    sys_put_le32(h->rx_packets, &dst[12]);
+    sys_put_le32(h->crc_errors, &dst[16]);
+    sys_put_le32(h->size_errors, &dst[20]);
+    sys_put_le32(h->recv_errors, &dst[24]);
+    sys_put_le32(h->queue_drops, &dst[28]);
+    sys_put_le32(h->control_ticks, &dst[32]);
+    sys_put_le32(h->control_overruns, &dst[36]);
+    sys_put_le16(h->cpu_load, &dst[40]);
+    sys_put_le16(h->cpu_peak, &dst[42]);
+    sys_put_le16((uint16_t)MIN(h->stack_free, UINT16_MAX), &dst[44]);
+    dst[46] = h->stack_free_pct;
+    dst[47] = 0;
+    sys_put_le16((uint16_t)MIN(h->stalls, UINT16_MAX), &dst[48]);
+    sys_put_le16(0, &dst[50]);
+    sys_put_le32(h->latency_max_us, &dst[52]);
+}
+
+// Stage time in 0.1 us, saturated to 16 bits
+static uint16_t wcet_tenths_us(uint32_t cycles)
+{
+    return (uint16_t)MIN(rov_cycles_to_ns(cycles) / 100U, UINT16_MAX);
+}
+
+static void encode_wcet(const telemetry_sample_t *s, uint8_t *dst)
+{
+    const wcet_report_t *w = &s->wcet;
+
+    sys_put_le32(s->timestamp_us, &dst[0]);
+    sys_put_le16((uint16_t)MIN(w->budget_us, UINT16_MAX), &dst[4]);
+    sys_put_le16((uint16_t)MIN(w->window_overruns, UINT16_MAX), &dst[6]);
+    sys_put_le32(w->overruns, &dst[8]);
+    for (int i = 0; i < WCET_STAGE_COUNT; i++) {
+        const wcet_stage_stats_t *st = &w->stage[i];
+        uint8_t *stage = &dst[12 + 8 * i];
+
+        sys_put_le16(wcet_tenths_us(st->mean_cycles), &stage[0]);
+        sys_put_le16(wcet_tenths_us(st->p99_cycles), &stage[2]);
+        sys_put_le16(wcet_tenths_us(st->max_cycles), &stage[4]);
+        sys_put_le16(wcet_tenths_us(st->worst_cycles), &stage[6]);
+    }
+}
+
+/**
+ * Drain the telemetry consumer rings, keeping the newest sample of each
+ */
+static void telemetry_read_sensors(void)
+{
+    const sensor_depth_sample_t *depth;
+    const sensor_leak_sample_t *leak;
+    const sensor_voltage_sample_t *voltage;
+
+    // Attitude comes from the AHRS snapshot; raw IMU samples have no telemetry ring
+    while ((depth = sensors_peek(SENSOR_DEPTH, SENSOR_CONSUMER_TELEMETRY)) != NULL) {
+        last_depth = *depth;
+        have_depth = true;
+        sensors_release(SENSOR_DEPTH, SENSOR_CONSUMER_TELEMETRY);
+    }
+    while ((leak = sensors_peek(SENSOR_LEAK, SENSOR_CONSUMER_TELEMETRY)) != NULL) {
+        last_leak = *leak;
+        sensors_release(SENSOR_LEAK, SENSOR_CONSUMER_TELEMETRY);
+    }
+    while ((voltage = sensors_peek(SENSOR_VOLTAGE, SENSOR_CONSUMER_TELEMETRY)) != NULL) {
+        last_voltage = *voltage;
+        sensors_release(SENSOR_VOLTAGE, SENSOR_CONSUMER_TELEMETRY);
+    }
+}
+
+/**
+ * Gather the current vehicle state
+ * @param sample: Output
+ */
+static void telemetry_collect(telemetry_sample_t *sample)
+{
+    actuator_frame_t frame;
+    net_link_stats_t link;
+    power_status_t power;
+    ahrs_snapshot_t attitude;
+
+    sample->timestamp_us = setpoint_now_us();
+
+    rov_get_last_command(&sample->command);
+    sample->command_age_us = sample->command.sequence != 0
+                           ? sample->timestamp_us - sample->command.timestamp_us : UINT32_MAX;
+
+    actuator_get_last(&frame);
+    memcpy(sample->thrust, frame.thrust, sizeof(sample->thrust));
+    sample->light = frame.light;
+    sample->manipulator = frame.manipulator;
+
+    power_get_status(&power);
+    sample->requested_a = power.requested_a;
+    sample->delivered_a = power.delivered_a;
+    sample->power_scale = power.scale;
+    for (int i = 0; i < ROV_THRUSTER_COUNT; i++) {
+#if defined(CONFIG_K2_ACTUATOR_CAN)
+        esc_telemetry_t esc;
+
+        if (actuator_can_get_telemetry(i, &esc) == 0 && esc.replies > 0) {
+            sample->thruster_current_a[i] = esc.current_a;
+            continue;
+        }
+#endif
+        // No current sensing: estimate from the power curve, on the frame the
+        // limiter budgeted (force domain, before compensation)
+        float single[ROV_THRUSTER_COUNT] = { 0 };
+
+        single[i] = power.thrust[i];
+        sample->thruster_current_a[i] = power_estimate(single);
+    }
+
+    net_get_link_stats(&link);
+    sample->rx_packets = link.rx_packets;
+    sample->crc_errors = link.crc_errors;
+    sample->size_errors = link.size_errors;
+    sample->queue_drops = rov_command_drops();
+    sample->cpu_load = cpuload_total(CPULOAD_WINDOW_1S);
+
+    sample->depth_m = last_depth.depth_m;
+    sample->voltage_v = last_voltage.voltage_v;
+
+    ahrs_get_snapshot(&attitude);
+    sample->roll_deg = attitude.roll_deg;
+    sample->pitch_deg = attitude.pitch_deg;
+    sample->heading_deg = attitude.heading_deg;
+
+    sample->flags = 0;
+    if (atomic_test_bit(&led_status, LED_STATUS_LINK_UP)) {
+        sample->flags |= TELEMETRY_FLAG_LINK_UP;
+    }
+    if (atomic_test_bit(&led_status, LED_STATUS_FAILSAFE)) {
+        sample->flags |= TELEMETRY_FLAG_FAILSAFE;
+    }
+    if (last_leak.leak) {
+        sample->flags |= TELEMETRY_FLAG_LEAK;
+    }
+    if (have_depth && sample->timestamp_us - last_depth.timestamp_us <= TELEMETRY_DEPTH_TIMEOUT_US) {
+        sample->flags |= TELEMETRY_FLAG_DEPTH_VALID;
+    }
+}
+
+/**
+ * Arm a timer to fire a number of ticks from now
+ * @param index: Timer (subscriber * TELEMETRY_TOPIC_COUNT + topic)
+ * @param delay: Ticks, at least 1
+ */
+static void wheel_insert(uint8_t index, uint32_t delay)
+{
+    struct telemetry_timer *t = &timers[index];
+
+    t->slot = (wheel_tick + delay) & (TELEMETRY_WHEEL_SLOTS - 1);
+    t->rounds = (delay - 1) / TELEMETRY_WHEEL_SLOTS;
+    t->next = wheel[t->slot];
+    t->armed = true;
+    wheel[t->slot] = index;
+}
+
+static void wheel_remove(uint8_t index)
+{
+    struct telemetry_timer *t = &timers[index];
+    uint8_t *link = &wheel[t->slot];
+
+    if (!t->armed) {
+        return;
+    }
+    while (*link != TELEMETRY_TIMER_NONE) {
+        if (*link == index) {
+            *link = t->next;
+            break;
+        }
+        link = &timers[*link].next;
+    }
+    t->armed = false;
+}
+
+/**
+ * Advance the wheel one tick and mark the topics that are due
+ */
+static void wheel_advance(void)
+{
+    wheel_tick++;
+
+    uint8_t slot = wheel_tick & (TELEMETRY_WHEEL_SLOTS - 1);
+    uint8_t index = wheel[slot];
+
+    // Detach the slot; timers that are not due yet go back into it
+    wheel[slot] = TELEMETRY_TIMER_NONE;
+    while (index != TELEMETRY_TIMER_NONE) {
+        struct telemetry_timer *t = &timers[index];
+        uint8_t next = t->next;
+
+        if (t->rounds > 0) {
+            t->rounds--;
+            t->next = wheel[slot];
+            wheel[slot] = index;
+        } else {
+            subscribers[index / TELEMETRY_TOPIC_COUNT].due |= BIT(index % TELEMETRY_TOPIC_COUNT);
+            wheel_insert(index, t->period_ticks);
+        }
+        index = next;
+    }
+}
+
+/**
+ * Replace a subscriber's topics and rates (telemetry thread)
+ * @param sub: Subscriber slot
+ * @param rates: Requested rate per topic, 0 = not subscribed
+ * @param batch: Ticks per datagram, 0 = default
+ * @return: true if at least one topic is subscribed
+ */
+static bool telemetry_subscribe(int sub, const uint16_t rates[TELEMETRY_TOPIC_COUNT], uint8_t batch)
+{
+    struct telemetry_subscriber *s = &subscribers[sub];
+    uint16_t applied[TELEMETRY_TOPIC_COUNT];
+    size_t tick_max = 0;
+    bool any = false;
+
+    for (int topic = 0; topic < TELEMETRY_TOPIC_COUNT; topic++) {
+        uint8_t index = sub * TELEMETRY_TOPIC_COUNT + topic;
+        uint32_t rate = MIN(rates[topic], TELEMETRY_MAX_RATE_HZ);
+
+        wheel_remove(index);
+        applied[topic] = 0;
+        if (rate == 0) {
+            continue;
+        }
+        // Nearest whole number of ticks; the ack reports the resulting rate
+        uint32_t period = MAX((TELEMETRY_TICK_HZ + rate / 2) / rate, 1U);
+
+        timers[index].period_ticks = period;
+        applied[topic] = TELEMETRY_TICK_HZ / period;
+        wheel_insert(index, 1);
+        tick_max += TELEMETRY_TAG_SIZE + topics[topic].size;
+        any = true;
+    }
+
+    if (batch == 0 || batch > TELEMETRY_MAX_BATCH) {
+        batch = (uint8_t)atomic_get(&default_batch);
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&telemetry_lock);
+    memcpy(s->info.rate_hz, applied, sizeof(applied));
+    s->info.batch = batch;
+    s->tick_max = tick_max;
+    if (any && !s->info.active) {
+        s->info.datagrams = 0;
+        s->info.bytes = 0;
+        s->info.send_errors = 0;
+        s->length = TELEMETRY_HEADER_SIZE;
+        s->ticks_pending = 0;
+        s->batch_seq = 0;
+        s->due = 0;
+    }
+    s->info.active = any;
+    k_spin_unlock(&telemetry_lock, key);
+    return any;
+}
+
+static void telemetry_unsubscribe(int sub)
+{
+    static const uint16_t none[TELEMETRY_TOPIC_COUNT];
+
+    telemetry_subscribe(sub, none, 0);
+}
+
+/**
+ * Send a subscriber's datagram if it holds any data
+ */
+static void telemetry_flush(struct telemetry_subscriber *s)
+{
+    uint8_t header[TELEMETRY_HEADER_SIZE];
+    uint32_t cycles;
+    int ret = 0;
+
+    if (s->length <= TELEMETRY_HEADER_SIZE) {
+        return;
+    }
+
+    sys_put_le16(TELEMETRY_MAGIC, &header[0]);
+    header[2] = TELEMETRY_VERSION;
+    header[3] = TELEMETRY_MSG_DATA;
+    sys_put_le32(s->batch_seq++, &header[4]);
+    sys_put_le32(setpoint_now_us(), &header[8]);
+
+    uint32_t start = rov_cycles_now();
+#if defined(CONFIG_K2_TELEMETRY_ZERO_COPY)
+    if (s->pkt.pkt != NULL) {
+        ret = telemetry_pkt_patch(&s->pkt, 0, header, sizeof(header));
+        if (ret == 0) {
+            ret = telemetry_pkt_send(&s->pkt);
+        } else {
+            telemetry_pkt_abort(&s->pkt);
+        }
+    } else
+#endif
+    {
+        memcpy(s->buffer, header, sizeof(header));
+        if (zsock_sendto(telemetry_sock, s->buffer, s->length, ZSOCK_MSG_DONTWAIT,
+                         (struct sockaddr *)&s->info.addr, sizeof(s->info.addr)) < 0) {
+            ret = -errno;
+        }
+    }
+    cycles = rov_cycles_now() - start;
+
+    k_spinlock_key_t key = k_spin_lock(&telemetry_lock);
+    if (ret < 0) {
+        s->info.send_errors++;
+    } else {
+        s->info.datagrams++;
+        s->info.bytes += s->length;
+    }
+    stats.send_max_cycles = MAX(stats.send_max_cycles, cycles);
+    k_spin_unlock(&telemetry_lock, key);
+
+    s->length = TELEMETRY_HEADER_SIZE;
+    s->ticks_pending = 0;
+}
+
+/**
+ * Make room for one tick of data in a subscriber's datagram, starting a
+ * new datagram (and on the zero-copy path, its net_pkt) if needed
+ * @param s: Subscriber
+ * @param tick_size: Bytes about to be appended
+ * @return: false if no net_pkt could be allocated (this tick is dropped)
+ */
+static bool telemetry_reserve(struct telemetry_subscriber *s, size_t tick_size)
+{
+    size_t capacity = TELEMETRY_MAX_DATAGRAM;
+
+#if defined(CONFIG_K2_TELEMETRY_ZERO_COPY)
+    if (s->pkt.pkt != NULL) {
+        capacity = s->pkt.capacity;
+    }
+#endif
+    if (s->length + tick_size > capacity) {
+        telemetry_flush(s);
+    }
+
+#if defined(CONFIG_K2_TELEMETRY_ZERO_COPY)
+    if (s->length == TELEMETRY_HEADER_SIZE && atomic_get(&zero_copy)) {
+        // Sized for a full batch; the header is filled in on send
+        static const uint8_t header[TELEMETRY_HEADER_SIZE];
+
+        capacity = MIN(TELEMETRY_HEADER_SIZE + s->info.batch * s->tick_max,
+                       TELEMETRY_MAX_DATAGRAM);
+        if (telemetry_pkt_begin(&s->pkt, &s->info.addr, htons(CONFIG_K2_TELEMETRY_PORT),
+                                capacity) < 0) {
+            telemetry_count(&stats.alloc_failures);
+            return false;
+        }
+        telemetry_pkt_write(&s->pkt, header, sizeof(header));
+    }
+#endif
+    return true;
+}
+
+/**
+ * Append one tagged topic payload to a subscriber's datagram
+ */
+static void telemetry_append(struct telemetry_subscriber *s, const uint8_t *message, size_t size)
+{
+#if defined(CONFIG_K2_TELEMETRY_ZERO_COPY)
+    if (s->pkt.pkt != NULL) {
+        telemetry_pkt_write(&s->pkt, message, size);
+        s->length += size;
+        return;
+    }
+#endif
+    memcpy(&s->buffer[s->length], message, size);
+    s->length += size;
+}
+
+/**
+ * Keep the pilot's default subscription pointed at the command source
+ */
+static void telemetry_update_pilot(void)
+{
+    struct telemetry_subscriber *s = &subscribers[TELEMETRY_PILOT];
+    uint32_t rate = (uint32_t)atomic_get(&pilot_rate_hz);
+    struct sockaddr_in pilot;
+
+    if (rate == 0) {
+        if (s->info.active) {
+            telemetry_flush(s);
+            telemetry_unsubscribe(TELEMETRY_PILOT);
+        }
+        pilot_rate_applied = 0;
+        return;
+    }
+    if (!net_get_pilot(&pilot)) {
+        telemetry_count(&stats.no_pilot);
+        return;
+    }
+
+    pilot.sin_port = htons(CONFIG_K2_TELEMETRY_PORT);
+    if (s->info.active && rate == pilot_rate_applied &&
+        s->info.batch == (uint32_t)atomic_get(&default_batch) &&
+        s->info.addr.sin_addr.s_addr == pilot.sin_addr.s_addr) {
+        return;
+    }
+
+    // New pilot, rate or batch: restart the default stream
+    uint16_t rates[TELEMETRY_TOPIC_COUNT];
+
+    for (int topic = 0; topic < TELEMETRY_TOPIC_COUNT; topic++) {
+        rates[topic] = (TELEMETRY_PILOT_TOPICS & BIT(topic)) ? rate : 0;
+    }
+    telemetry_flush(s);
+
+    k_spinlock_key_t key = k_spin_lock(&telemetry_lock);
+    s->info.addr = pilot;
+    s->info.pilot = true;
+    s->info.lease_ms = 0;
+    k_spin_unlock(&telemetry_lock, key);
+
+    telemetry_subscribe(TELEMETRY_PILOT, rates, 0);
+    pilot_rate_applied = rate;
+}
+
+/**
+ * Acknowledge a subscribe request with the rates actually scheduled
+ */
+static void telemetry_send_ack(int sub, const struct sockaddr_in *to)
+{
+    const telemetry_subscriber_info_t *info = &subscribers[sub].info;
+    uint8_t ack[TELEMETRY_REQUEST_MAX];
+    size_t length = 6;
+
+    sys_put_le16(TELEMETRY_MAGIC, &ack[0]);
+    ack[2] = TELEMETRY_VERSION;
+    ack[3] = TELEMETRY_MSG_SUBSCRIBE_ACK;
+    ack[4] = info->active ? info->batch : 0;
+    ack[5] = 0;
+    for (int topic = 0; topic < TELEMETRY_TOPIC_COUNT; topic++) {
+        if (info->rate_hz[topic] == 0) {
+            continue;
+        }
+        ack[length] = topic;
+        ack[length + 1] = 0;
+        sys_put_le16(info->rate_hz[topic], &ack[length + 2]);
+        length += 4;
+        ack[5]++;
+    }
+    (void)zsock_sendto(telemetry_sock, ack, length, ZSOCK_MSG_DONTWAIT,
+                       (const struct sockaddr *)to, sizeof(*to));
+}
+
+/**
+ * Apply one subscribe request
+ * @param data: Request datagram
+ * @param length: Its size
+ * @param from: Sender, which becomes (or identifies) the subscriber
+ */
+static void telemetry_handle_request(const uint8_t *data, size_t length,
+                                     const struct sockaddr_in *from)
+{
+    uint16_t rates[TELEMETRY_TOPIC_COUNT] = { 0 };
+    int sub = -1;
+    int free_slot = -1;
+
+    if (length < 6 || sys_get_le16(&data[0]) != TELEMETRY_MAGIC ||
+        data[2] != TELEMETRY_VERSION || data[3] != TELEMETRY_MSG_SUBSCRIBE ||
+        length != 6 + 4U * data[5]) {
+        telemetry_count(&stats.bad_requests);
+        return;
+    }
+    for (int i = 0; i < data[5]; i++) {
+        const uint8_t *entry = &data[6 + 4 * i];
+
+        if (entry[0] >= TELEMETRY_TOPIC_COUNT) {
+            telemetry_count(&stats.bad_requests);
+            return;
+        }
+        rates[entry[0]] = sys_get_le16(&entry[2]);
+    }
+
+    for (int i = TELEMETRY_PILOT + 1; i < TELEMETRY_MAX_SUBSCRIBERS; i++) {
+        const struct sockaddr_in *addr = &subscribers[i].info.addr;
+
+        if (subscribers[i].info.active && addr->sin_addr.s_addr == from->sin_addr.s_addr &&
+            addr->sin_port == from->sin_port) {
+            sub = i;
+            break;
+        }
+        if (!subscribers[i].info.active && free_slot < 0) {
+            free_slot = i;
+        }
+    }
+    if (sub < 0) {
+        if (free_slot < 0) {
+            telemetry_count(&stats.rejected);
+            return;
+        }
+        sub = free_slot;
+        k_spinlock_key_t key = k_spin_lock(&telemetry_lock);
+        subscribers[sub].info.addr = *from;
+        subscribers[sub].info.pilot = false;
+        k_spin_unlock(&telemetry_lock, key);
+    } else {
+        // Pending data was scheduled under the old rates
+        telemetry_flush(&subscribers[sub]);
+    }
+
+    bool active = telemetry_subscribe(sub, rates, data[4]);
+
+    k_spinlock_key_t key = k_spin_lock(&telemetry_lock);
+    subscribers[sub].lease_expiry_ms = k_uptime_get() + TELEMETRY_LEASE_MS;
+    stats.requests++;
+    k_spin_unlock(&telemetry_lock, key);
+
+    telemetry_send_ack(sub, from);
+    if (!active) {
+        LOG_INF("Telemetry subscriber %d left", sub);
+    }
+}
+
+/**
+ * Handle pending subscribe requests and expired leases
+ */
+static void telemetry_poll_requests(void)
+{
+    int64_t now = k_uptime_get();
+
+    for (int i = 0; i < TELEMETRY_RX_PER_TICK; i++) {
+        struct sockaddr_in from;
+        socklen_t from_len = sizeof(from);
+        ssize_t len = zsock_recvfrom(telemetry_sock, rx_buffer, sizeof(rx_buffer),
+                                     ZSOCK_MSG_DONTWAIT, (struct sockaddr *)&from, &from_len);
+        if (len < 0) {
+            break;
+        }
+        telemetry_handle_request(rx_buffer, (size_t)len, &from);
+    }
+
+    for (int i = TELEMETRY_PILOT + 1; i < TELEMETRY_MAX_SUBSCRIBERS; i++) {
+        struct telemetry_subscriber *s = &subscribers[i];
+
+        if (s->info.active && now >= s->lease_expiry_ms) {
+            telemetry_flush(s);
+            telemetry_unsubscribe(i);
+            telemetry_count(&stats.expired);
+            LOG_INF("Telemetry subscriber %d lease expired", i);
+        }
+    }
+}
+
+/**
+ * One wheel tick: schedule, build each due topic once, queue to subscribers
+ */
+static void telemetry_tick(void)
+{
+    static telemetry_sample_t sample;
+    uint32_t needed = 0;
+    uint32_t built = 0;
+
+    uint32_t start = rov_cycles_now();
+
+    if (wheel_tick % TELEMETRY_CPULOAD_TICKS == 0) {
+        cpuload_sample();
+    }
+    telemetry_read_sensors();
+    telemetry_update_pilot();
+    wheel_advance();
+
+    for (int i = 0; i < TELEMETRY_MAX_SUBSCRIBERS; i++) {
+        needed |= subscribers[i].due;
+    }
+    if (needed == 0) {
+        return;
+    }
+
+    telemetry_collect(&sample);
+    if (needed & BIT(TELEMETRY_TOPIC_LATENCY)) {
+        latency_get_summary(sample.latency);
+    }
+    if (needed & BIT(TELEMETRY_TOPIC_CPU)) {
+        cpuload_get_summary(&sample.cpu);
+    }
+    if (needed & BIT(TELEMETRY_TOPIC_HEALTH)) {
+        health_get_record(&sample.health);
+    }
+    if (needed & BIT(TELEMETRY_TOPIC_WCET)) {
+        wcet_get_report(&sample.wcet);
+    }
+    for (int topic = 0; topic < TELEMETRY_TOPIC_COUNT; topic++) {
+        if (needed & BIT(topic)) {
+            payloads[topic][0] = topic;
+            payloads[topic][1] = topics[topic].size;
+            topics[topic].encode(&sample, &payloads[topic][TELEMETRY_TAG_SIZE]);
+            built |= BIT(topic);
+        }
+    }
+
+    uint32_t sends[TELEMETRY_TOPIC_COUNT] = { 0 };
+
+    for (int i = 0; i < TELEMETRY_MAX_SUBSCRIBERS; i++) {
+        struct telemetry_subscriber *s = &subscribers[i];
+        size_t tick_size = 0;
+
+        if (s->due == 0) {
+            continue;
+        }
+        for (int topic = 0; topic < TELEMETRY_TOPIC_COUNT; topic++) {
+            if (s->due & BIT(topic)) {
+                tick_size += TELEMETRY_TAG_SIZE + topics[topic].size;
+            }
+        }
+        if (!telemetry_reserve(s, tick_size)) {
+            s->due = 0;
+            continue;
+        }
+        for (int topic = 0; topic < TELEMETRY_TOPIC_COUNT; topic++) {
+            if (s->due & BIT(topic)) {
+                telemetry_append(s, payloads[topic], TELEMETRY_TAG_SIZE + topics[topic].size);
+                sends[topic]++;
+            }
+        }
+        s->due = 0;
+        if (++s->ticks_pending >= s->info.batch) {
+            telemetry_flush(s);
+        }
+    }
+
+    uint32_t cycles = rov_cycles_now() - start;
+
+    k_spinlock_key_t key = k_spin_lock(&telemetry_lock);
+    last_sample = sample;
+    have_last = true;
+    for (int topic = 0; topic < TELEMETRY_TOPIC_COUNT; topic++) {
+        stats.builds[topic] += (built >> topic) & 1U;
+        stats.sends[topic] += sends[topic];
+    }
+    stats.tick_max_cycles = MAX(stats.tick_max_cycles, cycles);
+    k_spin_unlock(&telemetry_lock, key);
+}
+
+static void telemetry_thread(void *arg1, void *arg2, void *arg3)
+{
+    ARG_UNUSED(arg1);
+    ARG_UNUSED(arg2);
+    ARG_UNUSED(arg3);
+
+    struct sockaddr_in bind_addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(CONFIG_K2_TELEMETRY_PORT),
+        .sin_addr.s_addr = htonl(INADDR_ANY),
+    };
+
+    telemetry_sock = zsock_socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (telemetry_sock < 0) {
+        LOG_ERR("Telemetry socket failed: %d", errno);
+        return;
+    }
+    if (zsock_bind(telemetry_sock, (struct sockaddr *)&bind_addr, sizeof(bind_addr)) < 0) {
+        LOG_ERR("Telemetry bind to port %d failed: %d", CONFIG_K2_TELEMETRY_PORT, errno);
+        zsock_close(telemetry_sock);
+        return;
+    }
+    LOG_INF("Telemetry uplink: port %d, %d Hz wheel", CONFIG_K2_TELEMETRY_PORT,
+            TELEMETRY_TICK_HZ);
+
+    k_timer_start(&telemetry_timer, K_USEC(1000000 / TELEMETRY_TICK_HZ),
+                  K_USEC(1000000 / TELEMETRY_TICK_HZ));
+    while (1) {
+        uint32_t expired = k_timer_status_sync(&telemetry_timer);
+
+        if (expired > 1) {
+            k_spinlock_key_t key = k_spin_lock(&telemetry_lock);
+            stats.overruns += expired - 1;
+            k_spin_unlock(&telemetry_lock, key);
+        }
+
+        telemetry_poll_requests();
+        telemetry_tick();
+        telemetry_count(&stats.ticks);
+    }
+}
+
+/**
+ * Initialize the telemetry uplink
+ */
+void telemetry_init(void)
+{
+    memset(wheel, TELEMETRY_TIMER_NONE, sizeof(wheel));
+    for (int i = 0; i < TELEMETRY_MAX_SUBSCRIBERS; i++) {
+        subscribers[i].length = TELEMETRY_HEADER_SIZE;
+    }
+    telemetry_reset_stats();
+    LOG_INF("Telemetry: pilot stream %d Hz, %d ticks per datagram, %d subscribers",
+            CONFIG_K2_TELEMETRY_RATE_HZ, CONFIG_K2_TELEMETRY_BATCH, TELEMETRY_MAX_SUBSCRIBERS);
+}
+
+/**
+ * Start the telemetry thread (after networking is initialized)
+ */
+void telemetry_start(void)
+{
+    k_thread_create(&telemetry_thread_data, telemetry_stack,
+                    K_THREAD_STACK_SIZEOF(telemetry_stack),
+                    telemetry_thread, NULL, NULL, NULL,
+                    TELEMETRY_PRIORITY, 0, K_NO_WAIT);
+    k_thread_name_set(&telemetry_thread_data, "telemetry");
+}
+
+const char *telemetry_topic_name(int topic)
+{
+    return (topic >= 0 && topic < TELEMETRY_TOPIC_COUNT) ? topics[topic].name : "?";
+}
+
+int telemetry_topic_from_name(const char *name)
+{
+    for (int topic = 0; topic < TELEMETRY_TOPIC_COUNT; topic++) {
+        if (strcmp(name, topics[topic].name) == 0) {
+            return topic;
+        }
+    }
+    return -EINVAL;
+}
+
+/**
+ * Set the rate of the pilot's default stream
+ * @param rate: Samples per second, 0 (off) .. TELEMETRY_MAX_RATE_HZ
+ * @return: 0, or -EINVAL if out of range
+ */
+int telemetry_set_rate(uint32_t rate)
+{
+    if (rate > TELEMETRY_MAX_RATE_HZ) {
+        return -EINVAL;
+    }
+    atomic_set(&pilot_rate_hz, (atomic_val_t)rate);
+    return 0;
+}
+
+/**
+ * Set the default number of ticks per datagram (pilot stream, and
+ * subscribers that do not ask for a batch size)
+ * @param batch: 1..TELEMETRY_MAX_BATCH
+ * @return: 0, or -EINVAL if out of range
+ */
+int telemetry_set_batch(uint32_t batch)
+{
+    if (batch < 1 || batch > TELEMETRY_MAX_BATCH) {
+        return -EINVAL;
+    }
+    atomic_set(&default_batch, (atomic_val_t)batch);
+    return 0;
+}
+
+uint32_t telemetry_get_rate(void)
+{
+    return (uint32_t)atomic_get(&pilot_rate_hz);
+}
+
+uint32_t telemetry_get_batch(void)
+{
+    return (uint32_t)atomic_get(&default_batch);
+}
+
+/**
+ * Get the state gathered on the newest tick that sent anything
+ * @param sample: Output
+ * @return: false if nothing has been gathered yet
+ */
+bool telemetry_get_last(telemetry_sample_t *sample)
+{
+    k_spinlock_key_t key = k_spin_lock(&telemetry_lock);
+    bool valid = have_last;
+    *sample = last_sample;
+    k_spin_unlock(&telemetry_lock, key);
+    return valid;
+}
+
+/**
+ * Get one subscriber slot
+ * @param index: 0..TELEMETRY_MAX_SUBSCRIBERS-1 (0 is the pilot)
+ * @param info: Output, with the remaining lease
+ * @return: 0, or -EINVAL for a bad index
+ */
+int telemetry_get_subscriber(int index, telemetry_subscriber_info_t *info)
+{
+    if (index < 0 || index >= TELEMETRY_MAX_SUBSCRIBERS) {
+        return -EINVAL;
+    }
+
+    int64_t now = k_uptime_get();
+    k_spinlock_key_t key = k_spin_lock(&telemetry_lock);
+    *info = subscribers[index].info;
+    if (info->active && !info->pilot) {
+        info->lease_ms = (uint32_t)MAX(subscribers[index].lease_expiry_ms - now, 0);
+    }
+    k_spin_unlock(&telemetry_lock, key);
+    return 0;
+}
+
+void telemetry_get_stats(telemetry_stats_t *out)
+{
+    k_spinlock_key_t key = k_spin_lock(&telemetry_lock);
+    *out = stats;
+    k_spin_unlock(&telemetry_lock, key);
+}
+
+void telemetry_reset_stats(void)
+{
+    k_spinlock_key_t key = k_spin_lock(&telemetry_lock);
+    memset(&stats, 0, sizeof(stats));
+    k_spin_unlock(&telemetry_lock, key);
+}
+
+static int cmd_telemetry_show(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    telemetry_sample_t s;
+
+    if (!telemetry_get_last(&s)) {
+        shell_print(sh, "no sample yet (no subscriber)");
+        return 0;
+    }
+    shell_print(sh, "@%u us  cmd #%u age %u us  [%d %d %d %d %d %d] light %u manip %u",
+                s.timestamp_us, s.command.sequence, s.command_age_us, s.command.surge,
+                s.command.sway, s.command.heave, s.command.roll, s.command.pitch,
+                s.command.yaw, s.command.light, s.command.manipulator);
+    shell_print(sh, "thrust %+.2f %+.2f %+.2f %+.2f %+.2f %+.2f %+.2f %+.2f  light %.2f manip %.2f",
+                (double)s.thrust[0], (double)s.thrust[1], (double)s.thrust[2],
+                (double)s.thrust[3], (double)s.thrust[4], (double)s.thrust[5],
+                (double)s.thrust[6], (double)s.thrust[7], (double)s.light,
+                (double)s.manipulator);
+    shell_print(sh, "current %.1f A requested, %.1f A delivered (scale %.2f)",
+                (double)s.requested_a, (double)s.delivered_a, (double)s.power_scale);
+    shell_print(sh, "link rx %u crc %u size %u drops %u  cpu %u.%02u%%  flags%s%s%s%s",
+                s.rx_packets, s.crc_errors, s.size_errors, s.queue_drops,
+                s.cpu_load / 100U, s.cpu_load % 100U,
+                (s.flags & TELEMETRY_FLAG_LINK_UP) ? " link" : "",
+                (s.flags & TELEMETRY_FLAG_FAILSAFE) ? " failsafe" : "",
+                (s.flags & TELEMETRY_FLAG_LEAK) ? " LEAK" : "",
+                (s.flags & TELEMETRY_FLAG_DEPTH_VALID) ? " depth" : "");
+    shell_print(sh, "depth %.3f m  battery %.2f V  roll %.1f pitch %.1f heading %.1f",
+                (double)s.depth_m, (double)s.voltage_v, (double)s.roll_deg,
+                (double)s.pitch_deg, (double)s.heading_deg);
+    return 0;
+}
+
+static int cmd_telemetry_subs(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    shell_print(sh, "pilot stream %u Hz, default batch %u, wheel %d Hz",
+                telemetry_get_rate(), telemetry_get_batch(), TELEMETRY_TICK_HZ);
+    for (int i = 0; i < TELEMETRY_MAX_SUBSCRIBERS; i++) {
+        telemetry_subscriber_info_t info;
+        char addr[NET_IPV4_ADDR_LEN];
+        char rates[96];
+        int pos = 0;
+
+        telemetry_get_subscriber(i, &info);
+        if (!info.active) {
+            continue;
+        }
+        zsock_inet_ntop(AF_INET, &info.addr.sin_addr, addr, sizeof(addr));
+        rates[0] = '\0';
+        for (int topic = 0; topic < TELEMETRY_TOPIC_COUNT && pos < (int)sizeof(rates); topic++) {
+            if (info.rate_hz[topic] != 0) {
+                pos += snprintf(&rates[pos], sizeof(rates) - pos, " %s:%u",
+                                telemetry_topic_name(topic), info.rate_hz[topic]);
+            }
+        }
+        shell_print(sh, "[%d] %s:%u %s batch %u%s", i, addr, ntohs(info.addr.sin_port),
+                    info.pilot ? "(pilot)" : "", info.batch, rates);
+        shell_print(sh, "    datagrams %u  bytes %u  send errors %u  lease %u ms",
+                    info.datagrams, info.bytes, info.send_errors, info.lease_ms);
+    }
+    return 0;
+}
+
+static int cmd_telemetry_rate(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+
+    if (telemetry_set_rate(strtoul(argv[1], NULL, 10)) != 0) {
+        shell_error(sh, "Rate must be 0 (off) .. %d Hz", TELEMETRY_MAX_RATE_HZ);
+        return -EINVAL;
+    }
+    return 0;
+}
+
+static int cmd_telemetry_batch(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+
+    if (telemetry_set_batch(strtoul(argv[1], NULL, 10)) != 0) {
+        shell_error(sh, "Batch must be 1..%d ticks", TELEMETRY_MAX_BATCH);
+        return -EINVAL;
+    }
+    return 0;
+}
+
+static int cmd_telemetry_stats(const struct shell *sh, size_t argc, char **argv)
+{
+    telemetry_stats_t s;
+
+    if (argc > 1 && strcmp(argv[1], "reset") == 0) {
+        telemetry_reset_stats();
+        shell_print(sh, "Telemetry stats reset");
+        return 0;
+    }
+
+    telemetry_get_stats(&s);
+    shell_print(sh, "ticks %u  overruns %u  requests %u  bad %u  rejected %u  expired %u  no pilot %u",
+                s.ticks, s.overruns, s.requests, s.bad_requests, s.rejected, s.expired,
+                s.no_pilot);
+    for (int topic = 0; topic < TELEMETRY_TOPIC_COUNT; topic++) {
+        shell_print(sh, "  %-10s built %8u  sent %8u", telemetry_topic_name(topic),
+                    s.builds[topic], s.sends[topic]);
+    }
+    shell_print(sh, "tick max %u ns  send max %u ns",
+                rov_cycles_to_ns(s.tick_max_cycles), rov_cycles_to_ns(s.send_max_cycles));
+#if defined(CONFIG_K2_TELEMETRY_ZERO_COPY)
+    telemetry_pool_usage_t pools;
+
+    telemetry_pool_usage(&pools);
+    shell_print(sh, "path %s  net_pkt alloc failures %u  free TX: %u/%u pkts, %u/%u bufs",
+                atomic_get(&zero_copy) ? "pkt" : "socket", s.alloc_failures,
+                pools.pkts_free, pools.pkts_total, pools.bufs_free, pools.bufs_total);
+#endif
+    return 0;
+}
+
+static int cmd_telemetry_path(const struct shell *sh, size_t argc, char **argv)
+{
+    if (argc > 1) {
+        if (strcmp(argv[1], "socket") == 0) {
+            atomic_set(&zero_copy, 0);
+        } else if (strcmp(argv[1], "pkt") == 0 && IS_ENABLED(CONFIG_K2_TELEMETRY_ZERO_COPY)) {
+            atomic_set(&zero_copy, 1);
+        } else {
+            shell_error(sh, "Path must be socket%s", IS_ENABLED(CONFIG_K2_TELEMETRY_ZERO_COPY)
+                        ? " or pkt" : " (CONFIG_K2_TELEMETRY_ZERO_COPY=n)");
+            return -EINVAL;
+        }
+    }
+    shell_print(sh, "Transmit path: %s", atomic_get(&zero_copy) ? "pkt (zero-copy)" : "socket");
+    return 0;
+}
+
+SHELL_SUBCMD_SET_CREATE(telemetry_cmds, (rov, telemetry));
+SHELL_SUBCMD_ADD((rov, telemetry), show, NULL, "Newest gathered vehicle state",
+                 cmd_telemetry_show, 1, 0);
+SHELL_SUBCMD_ADD((rov, telemetry), subs, NULL, "Subscribers, topics and rates",
+                 cmd_telemetry_subs, 1, 0);
+SHELL_SUBCMD_ADD((rov, telemetry), rate, NULL, "<hz> Pilot default stream rate (0 = off)",
+                 cmd_telemetry_rate, 2, 0);
+SHELL_SUBCMD_ADD((rov, telemetry), batch, NULL, "<n> Default ticks per datagram",
+                 cmd_telemetry_batch, 2, 0);
+SHELL_SUBCMD_ADD((rov, telemetry), path, NULL, "[socket|pkt] Transmit path for new datagrams",
+                 cmd_telemetry_path, 1, 1);
+SHELL_SUBCMD_ADD((rov, telemetry), stats, NULL, "[reset] Wheel, per-topic build/send counts and cost",
+                 cmd_telemetry_stats, 1, 1);
+SHELL_SUBCMD_ADD((rov), telemetry, &telemetry_cmds, "Telemetry uplink", NULL, 1, 0);
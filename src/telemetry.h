@@ -0,0 +1,151 @@
+#pragma once
+
+#include <zephyr/kernel.h>
+#include <zephyr/net/net_ip.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "control.h"
+#include "latency.h"
+#include "cpuload.h"
+#include "health.h"
+#include "wcet.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Telemetry uplink with topic subscriptions.
+ *
+ * Clients subscribe by sending a request to CONFIG_K2_TELEMETRY_PORT on the
+ * vehicle, listing topics and rates; the subscription is a lease that must
+ * be renewed (resend the request) within TELEMETRY_LEASE_MS. The pilot (the
+ * source of the last valid command) also gets a default subscription at
+ * CONFIG_K2_TELEMETRY_RATE_HZ, sent to the same port on its address.
+ *
+ * All datagrams are little-endian and start with:
+ *   magic u16 ("K2"), version u8, type u8
+ * Subscribe request / acknowledgement (TELEMETRY_MSG_SUBSCRIBE / _ACK):
+ *   batch u8 (0 = default), count u8, count x { topic u8, reserved u8, rate_hz u16 }
+ *   rate 0 drops a topic; an empty list ends the subscription. The ack
+ *   carries the rates actually scheduled (tick rate / whole ticks).
+ * Data (TELEMETRY_MSG_DATA):
+ *   batch_seq u32 (per subscriber), sent_us u32, then messages
+ *   { topic u8, length u8, payload } with timestamp_us u32 first in every
+ *   payload. Layouts are in telemetry.c and telemetry_rx.py.
+ */
+#define TELEMETRY_MAGIC        0x4B32
+#define TELEMETRY_VERSION      2
+#define TELEMETRY_HEADER_SIZE  12
+
+enum telemetry_msg_type {
+    TELEMETRY_MSG_DATA = 0,
+    TELEMETRY_MSG_SUBSCRIBE,
+    TELEMETRY_MSG_SUBSCRIBE_ACK,
+};
+
+enum telemetry_topic {
+    TELEMETRY_TOPIC_ATTITUDE = 0,   // Roll, pitch, heading
+    TELEMETRY_TOPIC_COMMAND,        // Last command and its age
+    TELEMETRY_TOPIC_THRUSTERS,      // Committed outputs
+    TELEMETRY_TOPIC_POWER,          // Thruster current, limiter, battery
+    TELEMETRY_TOPIC_SENSORS,        // Depth, battery, leak
+    TELEMETRY_TOPIC_LINK,           // Uplink counters
+    TELEMETRY_TOPIC_SYSTEM,         // CPU load, status flags
+    TELEMETRY_TOPIC_LATENCY,        // Packet-to-output latency percentiles
+    TELEMETRY_TOPIC_CPU,            // CPU load per thread group, 1 s and 10 s windows
+    TELEMETRY_TOPIC_HEALTH,         // Newest health supervisor record
+    TELEMETRY_TOPIC_WCET,           // Control tick stage timing and budget overruns
+    TELEMETRY_TOPIC_COUNT
+};
+
+// Scheduling: every topic rate is a whole number of wheel ticks
+#define TELEMETRY_TICK_HZ          200
+#define TELEMETRY_MAX_RATE_HZ      TELEMETRY_TICK_HZ
+#define TELEMETRY_MAX_SUBSCRIBERS  4       // Including the pilot's default subscription
+#define TELEMETRY_LEASE_MS         5000
+#define TELEMETRY_MAX_BATCH        20      // Ticks with data per datagram
+#define TELEMETRY_MAX_DATAGRAM     1472    // One Ethernet frame of UDP payload
+
+// Status flags (SENSORS and SYSTEM topics)
+#define TELEMETRY_FLAG_LINK_UP      BIT(0)
+#define TELEMETRY_FLAG_FAILSAFE     BIT(1)
+#define TELEMETRY_FLAG_LEAK         BIT(2)
+#define TELEMETRY_FLAG_DEPTH_VALID  BIT(3)
+
+// Vehicle state gathered once per tick, in engineering units
+typedef struct {
+    uint32_t timestamp_us;                 // Setpoint timebase
+    rov_command_t command;                 // Newest command taken by control
+    uint32_t command_age_us;               // UINT32_MAX before the first command
+    float thrust[ROV_THRUSTER_COUNT];      // Last committed outputs
+    float light;
+    float manipulator;
+    float thruster_current_a[ROV_THRUSTER_COUNT]; // Measured (CAN ESCs) or estimated
+    float requested_a;                     // Power limiter, last control tick
+    float delivered_a;
+    float power_scale;
+    uint32_t rx_packets;
+    uint32_t crc_errors;
+    uint32_t size_errors;
+    uint32_t queue_drops;
+    uint16_t cpu_load;                     // 0.01 %, over the last second (sliding)
+    uint8_t flags;                         // TELEMETRY_FLAG_*
+    float depth_m;
+    float voltage_v;
+    float roll_deg;
+    float pitch_deg;
+    float heading_deg;
+    latency_summary_t latency[LATENCY_SEGMENT_COUNT];  // Only filled when the topic is due
+    cpuload_summary_t cpu;                             // Only filled when the topic is due
+    health_record_t health;                            // Only filled when the topic is due
+    wcet_report_t wcet;                                // Only filled when the topic is due
+} telemetry_sample_t;
+
+typedef struct {
+    struct sockaddr_in addr;
+    bool active;
+    bool pilot;                                    // Default subscription of the command source
+    uint32_t lease_ms;                             // Remaining, 0 for the pilot
+    uint8_t batch;
+    uint16_t rate_hz[TELEMETRY_TOPIC_COUNT];       // Scheduled rate, 0 = not subscribed
+    uint32_t datagrams;
+    uint32_t bytes;
+    uint32_t send_errors;
+} telemetry_subscriber_info_t;
+
+typedef struct {
+    uint32_t ticks;
+    uint32_t overruns;           // Wheel ticks missed (timer expired more than once)
+    uint32_t builds[TELEMETRY_TOPIC_COUNT];  // Payloads encoded (once per tick, shared)
+    uint32_t sends[TELEMETRY_TOPIC_COUNT];   // Payloads queued to subscribers
+    uint32_t requests;           // Subscribe requests accepted
+    uint32_t bad_requests;
+    uint32_t rejected;           // No free subscriber slot
+    uint32_t expired;
+    uint32_t no_pilot;           // Pilot ticks discarded before a pilot was known
+    uint32_t alloc_failures;     // Ticks dropped for lack of a net_pkt (zero-copy path)
+    uint32_t tick_max_cycles;    // Wheel + build + queue for one tick
+    uint32_t send_max_cycles;    // One datagram handed to the stack
+} telemetry_stats_t;
+
+void telemetry_init(void);
+void telemetry_start(void);
+
+const char *telemetry_topic_name(int topic);
+int telemetry_topic_from_name(const char *name);
+
+int telemetry_set_rate(uint32_t rate_hz);   // Pilot default stream, 0 = off
+int telemetry_set_batch(uint32_t batch);    // Default batch, 1..TELEMETRY_MAX_BATCH
+uint32_t telemetry_get_rate(void);
+uint32_t telemetry_get_batch(void);
+
+bool telemetry_get_last(telemetry_sample_t *sample);  // false until the first tick with data
+int telemetry_get_subscriber(int index, telemetry_subscriber_info_t *info);
+void telemetry_get_stats(telemetry_stats_t *stats);
+void telemetry_reset_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
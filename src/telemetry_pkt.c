@@ -0,0 +1,314 @@
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/shell/shell.h>
+#include <zephyr/net/net_core.h>
+#include <zephyr/net/net_if.h>
+#include <zephyr/net/net_pkt.h>
+#include <zephyr/net/socket.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+// IPv4/UDP header construction from the IP stack (subsys/net/ip)
+#include <ipv4.h>
+#include <udp_internal.h>
+
+#include "telemetry.h"
+#include "telemetry_pkt.h"
+#include "cycles.h"
+
+LOG_MODULE_DECLARE(k2_app);
+
+#define TELEMETRY_PKT_HEADERS (NET_IPV4H_LEN + NET_UDPH_LEN)
+
+// Bench defaults and the size of a typical topic message (tag + payload)
+#define TELEMETRY_BENCH_DATAGRAMS 1000
+#define TELEMETRY_BENCH_BYTES     300
+#define TELEMETRY_BENCH_MESSAGE   22
+#define TELEMETRY_BENCH_PORT      9      // Discard service on the target
+#define TELEMETRY_BENCH_RETRIES   1000   // Per datagram, 1 ms apart
+
+/**
+ * Allocate a UDP packet with room for a payload and write its headers
+ * @param tx: Transmit state, tx->pkt is NULL on failure
+ * @param dst: Destination address and port (network byte order)
+ * @param src_port: Source port (network byte order)
+ * @param capacity: Payload bytes to allocate (at most one MTU)
+ * @return: 0, -ENETDOWN without an interface, -ENOBUFS if the pools are empty
+ */
+int telemetry_pkt_begin(telemetry_pkt_t *tx, const struct sockaddr_in *dst, uint16_t src_port,
+                        size_t capacity)
+{
+    struct net_if *iface = net_if_get_default();
+    struct net_pkt *pkt;
+
+    tx->pkt = NULL;
+    if (iface == NULL) {
+        return -ENETDOWN;
+    }
+
+    // Never waits: telemetry drops a datagram rather than stall on the pool
+    pkt = net_pkt_alloc_with_buffer(iface, capacity, AF_INET, IPPROTO_UDP, K_NO_WAIT);
+    if (pkt == NULL) {
+        return -ENOBUFS;
+    }
+
+    const struct in_addr *src = net_if_ipv4_select_src_addr(iface, &dst->sin_addr);
+
+    if (net_ipv4_create(pkt, src, &dst->sin_addr) < 0 ||
+        net_udp_create(pkt, src_port, dst->sin_port) < 0) {
+        net_pkt_unref(pkt);
+        return -ENOBUFS;
+    }
+
+    tx->pkt = pkt;
+    tx->capacity = capacity;
+    tx->length = 0;
+    return 0;
+}
+
+/**
+ * Append payload bytes at the end of the packet
+ * @return: 0, or -ENOSPC past the allocated capacity
+ */
+int telemetry_pkt_write(telemetry_pkt_t *tx, const void *data, size_t length)
+{
+    if (tx->length + length > tx->capacity) {
+        return -ENOSPC;
+    }
+    int ret = net_pkt_write(tx->pkt, data, length);
+
+    if (ret == 0) {
+        tx->length += length;
+    }
+    return ret;
+}
+
+/**
+ * Overwrite payload bytes already written (after the last write only)
+ * @param offset: Payload offset
+ */
+int telemetry_pkt_patch(telemetry_pkt_t *tx, size_t offset, const void *data, size_t length)
+{
+    if (offset + length > tx->length) {
+        return -EINVAL;
+    }
+
+    net_pkt_cursor_init(tx->pkt);
+    net_pkt_set_overwrite(tx->pkt, true);
+    int ret = net_pkt_skip(tx->pkt, TELEMETRY_PKT_HEADERS + offset);
+
+    if (ret == 0) {
+        ret = net_pkt_write(tx->pkt, data, length);
+    }
+    net_pkt_set_overwrite(tx->pkt, false);
+    return ret;
+}
+
+/**
+ * Finalize the headers and hand the packet to the stack; the packet is
+ * consumed either way
+ * @return: 0, or the stack's error
+ */
+int telemetry_pkt_send(telemetry_pkt_t *tx)
+{
+    struct net_pkt *pkt = tx->pkt;
+    int ret;
+
+    tx->pkt = NULL;
+
+    // Release the part of the allocation the batch did not use
+    net_pkt_trim_buffer(pkt);
+    net_pkt_cursor_init(pkt);
+    ret = net_ipv4_finalize(pkt, IPPROTO_UDP);
+    if (ret == 0) {
+        ret = net_send_data(pkt);
+    }
+    if (ret < 0) {
+        net_pkt_unref(pkt);
+    }
+    return ret;
+}
+
+void telemetry_pkt_abort(telemetry_pkt_t *tx)
+{
+    if (tx->pkt != NULL) {
+        net_pkt_unref(tx->pkt);
+        tx->pkt = NULL;
+    }
+}
+
+/**
+ * Snapshot of the network stack TX pools
+ * @param usage: Output; buffer counts need CONFIG_NET_BUF_POOL_USAGE
+ */
+void telemetry_pool_usage(telemetry_pool_usage_t *usage)
+{
+    struct k_mem_slab *rx_slab;
+    struct k_mem_slab *tx_slab;
+    struct net_buf_pool *rx_data;
+    struct net_buf_pool *tx_data;
+
+    net_pkt_get_info(&rx_slab, &tx_slab, &rx_data, &tx_data);
+    usage->pkts_free = k_mem_slab_num_free_get(tx_slab);
+    usage->pkts_total = usage->pkts_free + k_mem_slab_num_used_get(tx_slab);
+    usage->bufs_total = tx_data->buf_count;
+#if defined(CONFIG_NET_BUF_POOL_USAGE)
+    usage->bufs_free = (uint32_t)atomic_get(&tx_data->avail_count);
+#else
+    usage->bufs_free = tx_data->buf_count;
+#endif
+}
+
+/*
+ * Socket vs. net_pkt transmit of telemetry-sized datagrams. Both paths
+ * build the datagram from TELEMETRY_BENCH_MESSAGE-byte pieces, as the
+ * telemetry thread does: the socket path into a flat buffer that
+ * zsock_sendto then copies into a net_pkt, the pkt path straight into the
+ * net_pkt. A datagram that cannot get buffers is retried every 1 ms, so
+ * the rate is what the stack sustains; the pool minimum shows how close
+ * each path runs to exhausting it.
+ */
+struct telemetry_bench {
+    uint32_t sent;
+    uint32_t retries;
+    uint32_t failed;
+    uint64_t cycles;             // Building and sending, without the retry waits
+    int64_t elapsed_ms;
+    uint32_t pkts_free_min;
+    uint32_t bufs_free_min;
+};
+
+static uint8_t bench_message[TELEMETRY_BENCH_MESSAGE];
+static uint8_t bench_buffer[TELEMETRY_MAX_DATAGRAM];
+
+static void bench_sample_pools(struct telemetry_bench *b)
+{
+    telemetry_pool_usage_t usage;
+
+    telemetry_pool_usage(&usage);
+    b->pkts_free_min = MIN(b->pkts_free_min, usage.pkts_free);
+    b->bufs_free_min = MIN(b->bufs_free_min, usage.bufs_free);
+}
+
+static int bench_socket_send(int sock, const struct sockaddr_in *dst, size_t bytes)
+{
+    for (size_t pos = 0; pos < bytes; pos += TELEMETRY_BENCH_MESSAGE) {
+        memcpy(&bench_buffer[pos], bench_message, MIN(TELEMETRY_BENCH_MESSAGE, bytes - pos));
+    }
+    return zsock_sendto(sock, bench_buffer, bytes, ZSOCK_MSG_DONTWAIT,
+                        (const struct sockaddr *)dst, sizeof(*dst)) < 0 ? -errno : 0;
+}
+
+static int bench_pkt_send(const struct sockaddr_in *dst, size_t bytes)
+{
+    telemetry_pkt_t tx;
+    int ret = telemetry_pkt_begin(&tx, dst, htons(CONFIG_K2_TELEMETRY_PORT), bytes);
+
+    for (size_t pos = 0; ret == 0 && pos < bytes; pos += TELEMETRY_BENCH_MESSAGE) {
+        ret = telemetry_pkt_write(&tx, bench_message, MIN(TELEMETRY_BENCH_MESSAGE, bytes - pos));
+    }
+    if (ret < 0) {
+        telemetry_pkt_abort(&tx);
+        return ret;
+    }
+    return telemetry_pkt_send(&tx);
+}
+
+static void bench_run(int sock, const struct sockaddr_in *dst, uint32_t count, size_t bytes,
+                      struct telemetry_bench *b)
+{
+    memset(b, 0, sizeof(*b));
+    b->pkts_free_min = UINT32_MAX;
+    b->bufs_free_min = UINT32_MAX;
+
+    // Let the previous run drain out of the TX queue
+    k_sleep(K_MSEC(200));
+
+    int64_t start_ms = k_uptime_get();
+    for (uint32_t n = 0; n < count; n++) {
+        int tries = 0;
+        int ret;
+
+        do {
+            uint32_t start = rov_cycles_now();
+            ret = (sock >= 0) ? bench_socket_send(sock, dst, bytes) : bench_pkt_send(dst, bytes);
+            b->cycles += rov_cycles_now() - start;
+            bench_sample_pools(b);
+            if (ret == -ENOBUFS || ret == -ENOMEM || ret == -EAGAIN) {
+                b->retries++;
+                k_sleep(K_MSEC(1));
+            }
+        } while ((ret == -ENOBUFS || ret == -ENOMEM || ret == -EAGAIN) &&
+                 ++tries < TELEMETRY_BENCH_RETRIES);
+
+        if (ret == 0) {
+            b->sent++;
+        } else {
+            b->failed++;
+        }
+    }
+    b->elapsed_ms = MAX(k_uptime_get() - start_ms, 1);
+}
+
+static void bench_print(const struct shell *sh, const char *name, const struct telemetry_bench *b,
+                        size_t bytes, const telemetry_pool_usage_t *pools)
+{
+    uint32_t per_second = (uint32_t)(b->sent * 1000LL / b->elapsed_ms);
+    uint32_t attempts = b->sent + b->retries + b->failed;
+
+    shell_print(sh, "  %-6s %6u datagrams/s %7u messages/s  %6u ns/datagram  "
+                "retries %u failed %u  min free: %u/%u pkts, %u/%u bufs",
+                name, per_second, per_second * (uint32_t)DIV_ROUND_UP(bytes, TELEMETRY_BENCH_MESSAGE),
+                attempts ? rov_cycles_to_ns((uint32_t)(b->cycles / attempts)) : 0,
+                b->retries, b->failed, b->pkts_free_min, pools->pkts_total,
+                b->bufs_free_min, pools->bufs_total);
+}
+
+static int cmd_telemetry_bench(const struct shell *sh, size_t argc, char **argv)
+{
+    struct sockaddr_in dst = {
+        .sin_family = AF_INET,
+        .sin_port = htons(TELEMETRY_BENCH_PORT),
+    };
+    uint32_t count = (argc > 2) ? strtoul(argv[2], NULL, 10) : TELEMETRY_BENCH_DATAGRAMS;
+    size_t bytes = (argc > 3) ? strtoul(argv[3], NULL, 10) : TELEMETRY_BENCH_BYTES;
+    telemetry_pool_usage_t pools;
+    struct telemetry_bench b;
+
+    if (zsock_inet_pton(AF_INET, argv[1], &dst.sin_addr) != 1) {
+        shell_error(sh, "Invalid IPv4 address: %s", argv[1]);
+        return -EINVAL;
+    }
+    if (count == 0 || bytes < TELEMETRY_HEADER_SIZE || bytes > TELEMETRY_MAX_DATAGRAM) {
+        shell_error(sh, "Datagram size must be %d..%d bytes", TELEMETRY_HEADER_SIZE,
+                    TELEMETRY_MAX_DATAGRAM);
+        return -EINVAL;
+    }
+    for (int i = 0; i < TELEMETRY_BENCH_MESSAGE; i++) {
+        bench_message[i] = (uint8_t)i;
+    }
+
+    int sock = zsock_socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (sock < 0) {
+        shell_error(sh, "Socket failed: %d", errno);
+        return -errno;
+    }
+
+    telemetry_pool_usage(&pools);
+    shell_print(sh, "%u datagrams of %u bytes to %s:%d (idle pools: %u/%u pkts, %u/%u bufs)",
+                count, (uint32_t)bytes, argv[1], TELEMETRY_BENCH_PORT, pools.pkts_free,
+                pools.pkts_total, pools.bufs_free, pools.bufs_total);
+
+    bench_run(sock, &dst, count, bytes, &b);
+    bench_print(sh, "socket", &b, bytes, &pools);
+    zsock_close(sock);
+
+    bench_run(-1, &dst, count, bytes, &b);
+    bench_print(sh, "pkt", &b, bytes, &pools);
+    return 0;
+}
+
+SHELL_SUBCMD_ADD((rov, telemetry), bench, NULL,
+                 "<ipv4> [datagrams] [bytes] Socket vs. net_pkt transmit rate and pool usage",
+                 cmd_telemetry_bench, 2, 2);
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <zephyr/kernel.h>
+#include <zephyr/net/net_ip.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct net_pkt;
+
+/*
+ * Zero-copy UDP transmit (CONFIG_K2_TELEMETRY_ZERO_COPY): the net_pkt is
+ * allocated with its IPv4/UDP headers when a datagram is started, the
+ * telemetry is serialized straight into its buffer chain, and the packet
+ * is handed to the stack without going through a socket.
+ */
+typedef struct {
+    struct net_pkt *pkt;
+    size_t capacity;      // Payload bytes allocated
+    size_t length;        // Payload bytes written
+} telemetry_pkt_t;
+
+// Free TX packets and TX data buffers in the network stack pools
+typedef struct {
+    uint32_t pkts_free;
+    uint32_t pkts_total;
+    uint32_t bufs_free;
+    uint32_t bufs_total;
+} telemetry_pool_usage_t;
+
+int telemetry_pkt_begin(telemetry_pkt_t *tx, const struct sockaddr_in *dst, uint16_t src_port,
+                        size_t capacity);
+int telemetry_pkt_write(telemetry_pkt_t *tx, const void *data, size_t length);
+int telemetry_pkt_patch(telemetry_pkt_t *tx, size_t offset, const void *data, size_t length);
+int telemetry_pkt_send(telemetry_pkt_t *tx);
+void telemetry_pkt_abort(telemetry_pkt_t *tx);
+
+void telemetry_pool_usage(telemetry_pool_usage_t *usage);
+
+#ifdef __cplusplus
+}
+#endif
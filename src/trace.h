@@ -0,0 +1,48 @@
+#pragma once
+
+#include <zephyr/kernel.h>
+#include <stdint.h>
+
+#if defined(CONFIG_TRACING_CTF)
+#include <zephyr/tracing/tracing.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Command pipeline trace points (tracing.conf / tracing_uart.conf).
+ *
+ * With CTF tracing each point is a named_event in the trace, next to the
+ * kernel's thread switch and ISR events, and trace_analyze.py rebuilds
+ * every packet's path from them. arg0 is always the command sequence:
+ *
+ *   rov_rx        udp_server: zsock_recvfrom() returned   arg1 = bytes
+ *   rov_valid     udp_server: CRC matched                 arg1 = 0
+ *   rov_invalid   udp_server: CRC mismatch                arg1 = 0
+ *   rov_queued    udp_server: on the command queue        arg1 = queue depth
+ *   rov_dropped   udp_server: command queue full          arg1 = 0
+ *   rov_dequeued  rov_control: taken off the queue        arg1 = queue depth
+ *   rov_actuated  commit timer ISR: first output frame    arg1 = 0
+ *
+ * Without tracing the macros compile to nothing.
+ */
+#if defined(CONFIG_TRACING_CTF)
+#define ROV_TRACE(name, seq, arg) \
+    sys_trace_named_event(name, (uint32_t)(seq), (uint32_t)(arg))
+#else
+#define ROV_TRACE(name, seq, arg) do { ARG_UNUSED(seq); ARG_UNUSED(arg); } while (0)
+#endif
+
+#define ROV_TRACE_RX(seq, bytes)       ROV_TRACE("rov_rx", seq, bytes)
+#define ROV_TRACE_VALID(seq)           ROV_TRACE("rov_valid", seq, 0)
+#define ROV_TRACE_INVALID(seq)         ROV_TRACE("rov_invalid", seq, 0)
+#define ROV_TRACE_QUEUED(seq, depth)   ROV_TRACE("rov_queued", seq, depth)
+#define ROV_TRACE_DROPPED(seq)         ROV_TRACE("rov_dropped", seq, 0)
+#define ROV_TRACE_DEQUEUED(seq, depth) ROV_TRACE("rov_dequeued", seq, depth)
+#define ROV_TRACE_ACTUATED(seq)        ROV_TRACE("rov_actuated", seq, 0)
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,234 @@
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/shell/shell.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "wcet.h"
+#include "cycles.h"
+
+LOG_MODULE_DECLARE(k2_app);
+
+// p99 of a window = smallest of its top (window / 100 + 1) samples
+#define WCET_TOP_COUNT (WCET_WINDOW_TICKS / 100 + 1)
+
+static const char *const stage_names[WCET_STAGE_COUNT] = {
+    "dequeue", "filters", "hold", "mixer", "power", "output", "logging", "tick"
+};
+
+// Accumulator for the current window, owned by the control thread
+typedef struct {
+    uint64_t sum;
+    uint32_t max;
+    uint32_t worst;
+    uint32_t top[WCET_TOP_COUNT];   // Largest samples, descending
+} wcet_acc_t;
+
+static wcet_acc_t acc[WCET_STAGE_COUNT];
+static uint32_t window_ticks;
+static uint32_t window_overruns;
+static uint32_t total_ticks;
+static uint32_t total_overruns;
+
+// Published once per window
+static wcet_report_t published;
+static struct k_spinlock report_lock;
+
+static atomic_t budget_cycles;
+static atomic_t reset_requested;
+
+/**
+ * Initialize the control-loop timing instrumentation
+ */
+void wcet_init(void)
+{
+    memset(acc, 0, sizeof(acc));
+    memset(&published, 0, sizeof(published));
+    window_ticks = 0;
+    window_overruns = 0;
+    total_ticks = 0;
+    total_overruns = 0;
+    wcet_set_budget_us(WCET_DEFAULT_BUDGET_US);
+
+    LOG_INF("Control tick budget: %u us (period %u us)",
+            WCET_DEFAULT_BUDGET_US, ROV_CONTROL_PERIOD_US);
+}
+
+/**
+ * Record the cost of one stage in the current tick
+ * @param stage: Instrumented stage
+ * @param cycles: Cycles spent in the stage
+ */
+void wcet_record(wcet_stage_t stage, uint32_t cycles)
+{
+    wcet_acc_t *a = &acc[stage];
+
+    a->sum += cycles;
+    if (cycles > a->max) {
+        a->max = cycles;
+    }
+
+    // Keep the window's largest samples sorted; most ticks exit on this compare
+    if (cycles > a->top[WCET_TOP_COUNT - 1]) {
+        int i = WCET_TOP_COUNT - 1;
+
+        while (i > 0 && a->top[i - 1] < cycles) {
+            a->top[i] = a->top[i - 1];
+            i--;
+        }
+        a->top[i] = cycles;
+    }
+}
+
+static void wcet_publish_window(void)
+{
+    k_spinlock_key_t key = k_spin_lock(&report_lock);
+
+    for (int i = 0; i < WCET_STAGE_COUNT; i++) {
+        wcet_acc_t *a = &acc[i];
+        wcet_stage_stats_t *s = &published.stage[i];
+
+        a->worst = MAX(a->worst, a->max);
+        s->mean_cycles = (uint32_t)(a->sum / window_ticks);
+        s->p99_cycles = a->top[WCET_TOP_COUNT - 1];
+        s->max_cycles = a->max;
+        s->worst_cycles = a->worst;
+
+        a->sum = 0;
+        a->max = 0;
+        memset(a->top, 0, sizeof(a->top));
+    }
+    published.budget_us = rov_cycles_to_ns(atomic_get(&budget_cycles)) / 1000;
+    published.ticks = total_ticks;
+    published.overruns = total_overruns;
+    published.window_overruns = window_overruns;
+
+    k_spin_unlock(&report_lock, key);
+}
+
+/**
+ * Close the current tick: record its total cost and check it against the budget
+ * @param tick_cycles: Cycles for the whole iteration
+ */
+void wcet_tick_end(uint32_t tick_cycles)
+{
+    if (atomic_clear(&reset_requested)) {
+        memset(acc, 0, sizeof(acc));
+        window_ticks = 0;
+        window_overruns = 0;
+        total_ticks = 0;
+        total_overruns = 0;
+    }
+
+    wcet_record(WCET_STAGE_TICK, tick_cycles);
+    total_ticks++;
+
+    if (tick_cycles > (uint32_t)atomic_get(&budget_cycles)) {
+        window_overruns++;
+        total_overruns++;
+    }
+
+    if (++window_ticks < WCET_WINDOW_TICKS) {
+        return;
+    }
+
+    wcet_publish_window();
+
+    // At most one warning per window, so overruns do not cause more overruns
+    if (window_overruns > 0) {
+        LOG_WRN("Control tick over budget in %u/%u ticks (max %u ns)",
+                window_overruns, window_ticks,
+                rov_cycles_to_ns(published.stage[WCET_STAGE_TICK].max_cycles));
+    }
+    window_ticks = 0;
+    window_overruns = 0;
+}
+
+/**
+ * Copy the statistics of the last completed window
+ * @param report: Output report
+ */
+void wcet_get_report(wcet_report_t *report)
+{
+    k_spinlock_key_t key = k_spin_lock(&report_lock);
+    *report = published;
+    k_spin_unlock(&report_lock, key);
+}
+
+/**
+ * Set the per-tick budget used for overrun detection
+ * @param budget_us: Budget in microseconds
+ */
+void wcet_set_budget_us(uint32_t budget_us)
+{
+    uint32_t cycles = (uint32_t)(((uint64_t)budget_us * rov_cycles_per_sec()) / 1000000U);
+
+    atomic_set(&budget_cycles, cycles);
+}
+
+/**
+ * Clear all statistics, applied by the control thread on its next tick
+ */
+void wcet_reset(void)
+{
+    atomic_set(&reset_requested, 1);
+}
+
+const char *wcet_stage_name(wcet_stage_t stage)
+{
+    return (stage < WCET_STAGE_COUNT) ? stage_names[stage] : "?";
+}
+
+static int cmd_wcet_show(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    wcet_report_t r;
+    wcet_get_report(&r);
+
+    shell_print(sh, "stage       mean_ns   p99_ns   max_ns  worst_ns  (last %d ticks)",
+                WCET_WINDOW_TICKS);
+    for (int i = 0; i < WCET_STAGE_COUNT; i++) {
+        const wcet_stage_stats_t *s = &r.stage[i];
+
+        shell_print(sh, "%-9s %9u %8u %8u %9u", stage_names[i],
+                    rov_cycles_to_ns(s->mean_cycles), rov_cycles_to_ns(s->p99_cycles),
+                    rov_cycles_to_ns(s->max_cycles), rov_cycles_to_ns(s->worst_cycles));
+    }
+    shell_print(sh, "budget %u us: %u/%u ticks over budget (%u in last window)",
+                r.budget_us, r.overruns, r.ticks, r.window_overruns);
+    return 0;
+}
+
+static int cmd_wcet_reset(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    wcet_reset();
+    shell_print(sh, "Timing statistics reset");
+    return 0;
+}
+
+static int cmd_wcet_budget(const struct shell *sh, size_t argc, char **argv)
+{
+    long budget_us = strtol(argv[1], NULL, 10);
+
+    if (budget_us <= 0 || budget_us > ROV_CONTROL_PERIOD_US) {
+        shell_error(sh, "Budget must be 1..%d us", ROV_CONTROL_PERIOD_US);
+        return -EINVAL;
+    }
+    wcet_set_budget_us((uint32_t)budget_us);
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(wcet_cmds,
+    SHELL_CMD(show, NULL, "Per-stage mean/p99/max control tick cost", cmd_wcet_show),
+    SHELL_CMD(reset, NULL, "Clear timing statistics", cmd_wcet_reset),
+    SHELL_CMD_ARG(budget, NULL, "<us> Per-tick budget for overrun detection", cmd_wcet_budget, 2, 0),
+    SHELL_SUBCMD_SET_END
+);
+
+SHELL_SUBCMD_ADD((rov), wcet, &wcet_cmds, "Control loop timing", NULL, 1, 0);
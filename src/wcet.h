@@ -0,0 +1,60 @@
+#pragma once
+
+#include <zephyr/kernel.h>
+#include <stdint.h>
+
+#include "control.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Instrumented stages of one control tick
+typedef enum {
+    WCET_STAGE_DEQUEUE = 0,  // Drain the command queue into the setpoint ring
+    WCET_STAGE_FILTERS,      // Setpoint interpolation + input filter bank
+    WCET_STAGE_HOLD,         // Attitude/depth feedback + hold controllers
+    WCET_STAGE_MIXER,        // 6DOF allocation
+    WCET_STAGE_POWER,        // Thruster current budget + force compensation
+    WCET_STAGE_OUTPUT,       // Output frame publish (committed later by the actuator timer)
+    WCET_STAGE_LOGGING,      // Per-command logging
+    WCET_STAGE_TICK,         // Whole iteration
+    WCET_STAGE_COUNT
+} wcet_stage_t;
+
+// Statistics window: one second of control ticks
+#define WCET_WINDOW_TICKS ROV_CONTROL_RATE_HZ
+
+// Default per-tick budget (half the control period)
+#define WCET_DEFAULT_BUDGET_US (ROV_CONTROL_PERIOD_US / 2)
+
+typedef struct {
+    uint32_t mean_cycles;    // Last completed window
+    uint32_t p99_cycles;     // Last completed window
+    uint32_t max_cycles;     // Last completed window
+    uint32_t worst_cycles;   // Since the last reset
+} wcet_stage_stats_t;
+
+typedef struct {
+    wcet_stage_stats_t stage[WCET_STAGE_COUNT];
+    uint32_t budget_us;
+    uint32_t ticks;             // Ticks since the last reset
+    uint32_t overruns;          // Ticks over budget since the last reset
+    uint32_t window_overruns;   // Ticks over budget in the last completed window
+} wcet_report_t;
+
+void wcet_init(void);
+
+// Called from the control thread only
+void wcet_record(wcet_stage_t stage, uint32_t cycles);
+void wcet_tick_end(uint32_t tick_cycles);
+
+// Any thread
+void wcet_get_report(wcet_report_t *report);
+void wcet_set_budget_us(uint32_t budget_us);
+void wcet_reset(void);
+const char *wcet_stage_name(wcet_stage_t stage);
+
+#ifdef __cplusplus
+}
+#endif
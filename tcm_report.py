@@ -0,0 +1,98 @@
+#!/usr/bin/env python3
+"""
+Report what the firmware places in ITCM/DTCM (CONFIG_K2_HOTPATH_TCM)
+Lists every symbol in the tightly coupled memories with its size and the
+usage of each region. With --baseline, also shows where each of those
+symbols lived in a build without the option, i.e. what moved.
+
+Usage:
+    west build -b nucleo_f767zi K2-Zephyr -d build/tcm
+    west build -b nucleo_f767zi K2-Zephyr -d build/flash -- -DCONFIG_K2_HOTPATH_TCM=n
+    python3 tcm_report.py build/tcm/zephyr/zephyr.elf --baseline build/flash/zephyr/zephyr.elf
+"""
+
+import argparse
+import shutil
+import subprocess
+import sys
+
+# STM32F767 memory map (must match the board devicetree)
+REGIONS = [
+    ('ITCM', 0x00000000, 16 * 1024),
+    ('flash', 0x08000000, 2048 * 1024),
+    ('DTCM', 0x20000000, 128 * 1024),
+    ('SRAM', 0x20020000, 384 * 1024),
+]
+TCM_REGIONS = ('ITCM', 'DTCM')
+
+NM_CANDIDATES = ['arm-zephyr-eabi-nm', 'arm-none-eabi-nm', 'nm']
+
+
+def region_of(addr):
+    for name, base, size in REGIONS:
+        if base <= addr < base + size:
+            return name
+    return '?'
+
+
+def find_nm(requested):
+    if requested:
+        return requested
+    for candidate in NM_CANDIDATES:
+        if shutil.which(candidate):
+            return candidate
+    sys.exit("No nm found; pass --nm <path to toolchain nm>")
+
+
+def load_symbols(nm, elf):
+    """name -> (address, size, type) for every sized symbol"""
+    out = subprocess.run([nm, '-S', elf], capture_output=True, text=True, check=True).stdout
+    symbols = {}
+    for line in out.splitlines():
+        fields = line.split()
+        if len(fields) != 4:
+            continue   # Unsized symbols (section markers, linker labels)
+        addr, size, kind, name = fields
+        # Thumb function addresses carry bit 0
+        symbols[name] = (int(addr, 16) & ~1, int(size, 16), kind)
+    return symbols
+
+
+def main():
+    parser = argparse.ArgumentParser(description="ITCM/DTCM placement report")
+    parser.add_argument('elf', help="zephyr.elf built with CONFIG_K2_HOTPATH_TCM=y")
+    parser.add_argument('--baseline', help="zephyr.elf built with CONFIG_K2_HOTPATH_TCM=n")
+    parser.add_argument('--nm', help="nm binary (default: first of %s)" % ', '.join(NM_CANDIDATES))
+    args = parser.parse_args()
+
+    nm = find_nm(args.nm)
+    symbols = load_symbols(nm, args.elf)
+    baseline = load_symbols(nm, args.baseline) if args.baseline else None
+
+    for region in TCM_REGIONS:
+        size = next(s for n, _, s in REGIONS if n == region)
+        placed = sorted(((name, sym) for name, sym in symbols.items()
+                         if region_of(sym[0]) == region),
+                        key=lambda item: -item[1][1])
+        used = sum(sym[1] for _, sym in placed)
+
+        print(f"{region}: {used} of {size} bytes ({used * 100.0 / size:.1f}%), "
+              f"{len(placed)} symbols")
+        for name, (addr, sym_size, kind) in placed:
+            line = f"  0x{addr:08x} {sym_size:6d}  {kind}  {name}"
+            if baseline is not None:
+                before = baseline.get(name)
+                line += f"   (was {region_of(before[0]) if before else 'inlined/absent'})"
+            print(line)
+        print()
+
+    if baseline is not None:
+        tcm_before = sum(s for a, s, _ in baseline.values() if region_of(a) in TCM_REGIONS)
+        moved = sum(s for name, (a, s, _) in symbols.items()
+                    if region_of(a) in TCM_REGIONS and name in baseline
+                    and region_of(baseline[name][0]) not in TCM_REGIONS)
+        print(f"Moved into TCM: {moved} bytes (baseline already had {tcm_before} bytes in TCM)")
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,295 @@
+#!/usr/bin/env python3
+"""
+Telemetry receiver for the K2 uplink (src/telemetry.c)
+Decodes telemetry datagrams and reports datagram rate, throughput, lost
+datagrams (gaps in the batch sequence) and, per topic, the message rate
+and the spread of the device-side interval.
+
+Without --host it only listens: the vehicle sends the pilot's default
+stream to the address it last received a valid command from, so run it on
+the pilot machine. With --host and one or more --sub, it subscribes to
+those topics and rates and renews the subscription until stopped.
+
+Usage:
+    python3 telemetry_rx.py                             # pilot default stream
+    python3 telemetry_rx.py --print                     # also print each message
+    python3 telemetry_rx.py --host 192.168.1.100 --sub attitude:50 --sub power:5
+    python3 telemetry_rx.py --host 192.168.1.100 --sub all:10 --batch 1 --duration 60
+"""
+
+import argparse
+import socket
+import struct
+import time
+
+# Must match src/telemetry.h and the encoders in src/telemetry.c
+DEFAULT_PORT = 12346
+MAGIC = 0x4B32
+VERSION = 2
+MSG_DATA, MSG_SUBSCRIBE, MSG_SUBSCRIBE_ACK = 0, 1, 2
+HEADER = struct.Struct('<HBBII')          # magic, version, type, batch_seq, sent_us
+REQUEST = struct.Struct('<HBBBB')         # magic, version, type, batch, count
+ENTRY = struct.Struct('<BxH')             # topic, rate_hz
+RENEW_S = 1.0                             # Well inside the 5 s lease
+
+FLAG_LINK_UP = 0x01
+FLAG_FAILSAFE = 0x02
+FLAG_LEAK = 0x04
+FLAG_DEPTH_VALID = 0x08
+
+# Command lifecycle segments (src/latency.h), each count + p50/p90/p99/max in ns
+LATENCY_SEGMENTS = ('decode', 'queue', 'control', 'total')
+
+# CPU load thread groups (src/cpuload.h), each 1 s and 10 s in 0.01 %
+CPU_GROUPS = ('udp', 'control', 'net', 'log', 'sensors', 'telemetry', 'other', 'idle')
+
+# Control tick stages (src/wcet.h), each mean/p99/max (last window) and worst in 0.1 us
+WCET_STAGES = ('dequeue', 'filters', 'hold', 'mixer', 'power', 'output', 'logging', 'tick')
+
+# Health record flags (src/health.h)
+HEALTH_FLAGS = ('link_up', 'failsafe', 'control_stalled', 'watchdog', 'watchdog_reset',
+                'stack_low')
+
+# id -> (name, layout, decoder); every payload starts with timestamp_us
+TOPICS = {
+    0: ('attitude', struct.Struct('<IhhH'),
+        lambda f: {'roll_deg': f[1] / 100.0, 'pitch_deg': f[2] / 100.0,
+                   'heading_deg': f[3] / 100.0}),
+    1: ('command', struct.Struct('<III6bBB'),
+        lambda f: {'sequence': f[1], 'age_us': None if f[2] == 0xFFFFFFFF else f[2],
+                   'axes': f[3:9], 'light': f[9], 'manipulator': f[10]}),
+    2: ('thrusters', struct.Struct('<I8hHH'),
+        lambda f: {'thrust': [v / 32767.0 for v in f[1:9]], 'light': f[9] / 65535.0,
+                   'manipulator': f[10] / 65535.0}),
+    3: ('power', struct.Struct('<Iffff8H'),
+        lambda f: {'requested_a': f[1], 'delivered_a': f[2], 'scale': f[3],
+                   'voltage_v': f[4], 'current_a': [v / 100.0 for v in f[5:13]]}),
+    4: ('sensors', struct.Struct('<IffBx'),
+        lambda f: {'depth_m': f[1], 'voltage_v': f[2], 'leak': bool(f[3] & FLAG_LEAK),
+                   'depth_valid': bool(f[3] & FLAG_DEPTH_VALID)}),
+    5: ('link', struct.Struct('<IIIII'),
+        lambda f: {'rx_packets': f[1], 'crc_errors': f[2], 'size_errors': f[3],
+                   'queue_drops': f[4]}),
+    6: ('system', struct.Struct('<IHBx'),
+        lambda f: {'cpu_load': f[1] / 100.0, 'link_up': bool(f[2] & FLAG_LINK_UP),
+                   'failsafe': bool(f[2] & FLAG_FAILSAFE), 'leak': bool(f[2] & FLAG_LEAK)}),
+    7: ('latency', struct.Struct('<I' + '5I' * len(LATENCY_SEGMENTS)),
+        lambda f: {f"{name}_{key}": (f[1 + 5 * i + j] if j == 0 else f[1 + 5 * i + j] / 1000.0)
+                   for i, name in enumerate(LATENCY_SEGMENTS)
+                   for j, key in enumerate(('count', 'p50_us', 'p90_us', 'p99_us', 'max_us'))}),
+    8: ('cpu', struct.Struct('<IHHHxx' + '2H' * len(CPU_GROUPS)),
+        lambda f: dict({'total_1s': f[1] / 100.0, 'total_10s': f[2] / 100.0, 'peak': f[3] / 100.0},
+                       **{f"{name}_{window}": f[4 + 2 * i + j] / 100.0
+                          for i, name in enumerate(CPU_GROUPS)
+                          for j, window in enumerate(('1s', '10s'))})),
+    9: ('health', struct.Struct('<IIHH7IHHHBxHxxI'),
+        lambda f: dict({'uptime_s': f[1], 'command_rate_hz': f[3], 'rx_packets': f[4],
+                        'crc_errors': f[5], 'size_errors': f[6], 'recv_errors': f[7],
+                        'queue_drops': f[8], 'control_ticks': f[9], 'control_overruns': f[10],
+                        'cpu_load': f[11] / 100.0, 'cpu_peak': f[12] / 100.0,
+                        'stack_free': f[13], 'stack_free_pct': f[14], 'stalls': f[15],
+                        'latency_max_us': f[16]},
+                       **{name: bool(f[2] & (1 << bit)) for bit, name in enumerate(HEALTH_FLAGS)})),
+    10: ('wcet', struct.Struct('<IHHI' + '4H' * len(WCET_STAGES)),
+         lambda f: dict({'budget_us': f[1], 'window_overruns': f[2], 'overruns': f[3]},
+                        **{f"{name}_{key}": f[4 + 4 * i + j] / 10.0
+                           for i, name in enumerate(WCET_STAGES)
+                           for j, key in enumerate(('mean_us', 'p99_us', 'max_us', 'worst_us'))})),
+}
+TOPIC_IDS = {name: topic for topic, (name, _, _) in TOPICS.items()}
+
+
+def decode_datagram(data):
+    """(batch_seq, sent_us, [(topic, timestamp_us, fields)]) or None"""
+    if len(data) < HEADER.size:
+        return None
+    magic, version, kind, batch_seq, sent_us = HEADER.unpack_from(data)
+    if magic != MAGIC or version != VERSION or kind != MSG_DATA:
+        return None
+    messages = []
+    offset = HEADER.size
+    while offset + 2 <= len(data):
+        topic, length = data[offset], data[offset + 1]
+        payload = data[offset + 2:offset + 2 + length]
+        offset += 2 + length
+        if len(payload) != length:
+            return None
+        if topic not in TOPICS or TOPICS[topic][1].size != length:
+            messages.append((topic, None, None))   # Newer firmware: skip unknown topics
+            continue
+        _, layout, decode = TOPICS[topic]
+        fields = layout.unpack(payload)
+        messages.append((topic, fields[0], decode(fields)))
+    return batch_seq, sent_us, messages
+
+
+def build_request(subs, batch):
+    """Subscribe request for {topic: rate_hz}; an empty dict unsubscribes"""
+    body = b''.join(ENTRY.pack(topic, rate) for topic, rate in sorted(subs.items()))
+    return REQUEST.pack(MAGIC, VERSION, MSG_SUBSCRIBE, batch, len(subs)) + body
+
+
+def decode_ack(data):
+    """(batch, {topic: rate_hz}) or None"""
+    if len(data) < REQUEST.size:
+        return None
+    magic, version, kind, batch, count = REQUEST.unpack_from(data)
+    if magic != MAGIC or version != VERSION or kind != MSG_SUBSCRIBE_ACK \
+            or len(data) != REQUEST.size + count * ENTRY.size:
+        return None
+    rates = dict(ENTRY.unpack_from(data, REQUEST.size + i * ENTRY.size) for i in range(count))
+    return batch, rates
+
+
+def parse_subs(specs):
+    subs = {}
+    for spec in specs:
+        name, _, rate = spec.partition(':')
+        rate = int(rate) if rate else 10
+        names = list(TOPIC_IDS) if name == 'all' else [name]
+        for n in names:
+            if n not in TOPIC_IDS:
+                raise SystemExit(f"Unknown topic {n!r}; one of: all, {', '.join(TOPIC_IDS)}")
+            subs[TOPIC_IDS[n]] = rate
+    return subs
+
+
+def format_message(topic, timestamp_us, fields):
+    name = TOPICS[topic][0]
+    text = ' '.join(f"{k}={v:.3f}" if isinstance(v, float) else
+                    f"{k}=[{' '.join(f'{x:+.2f}' for x in v)}]" if isinstance(v, list) else
+                    f"{k}={v}" for k, v in fields.items())
+    return f"{timestamp_us:>10} {name:<9} {text}"
+
+
+class Stats:
+    def __init__(self, carry=None):
+        self.datagrams = 0
+        self.bytes = 0
+        self.lost = 0
+        self.reordered = 0
+        self.invalid = 0
+        self.messages = {}        # topic -> count
+        self.intervals = {}       # topic -> [us]
+        # Sequence and timestamps carry over so gaps across windows still count
+        self.last_seq = carry.last_seq if carry else None
+        self.last_timestamp = dict(carry.last_timestamp) if carry else {}
+
+    def add(self, size, batch_seq, messages):
+        self.datagrams += 1
+        self.bytes += size
+        if self.last_seq is not None:
+            gap = (batch_seq - self.last_seq) & 0xFFFFFFFF
+            if gap == 0 or gap > 0x7FFFFFFF:
+                self.reordered += 1
+                return
+            self.lost += gap - 1
+        self.last_seq = batch_seq
+        for topic, timestamp_us, _ in messages:
+            if timestamp_us is None:
+                continue
+            self.messages[topic] = self.messages.get(topic, 0) + 1
+            if topic in self.last_timestamp:
+                interval = (timestamp_us - self.last_timestamp[topic]) & 0xFFFFFFFF
+                self.intervals.setdefault(topic, []).append(interval)
+            self.last_timestamp[topic] = timestamp_us
+
+
+def report(label, stats, elapsed):
+    expected = stats.datagrams + stats.lost
+    loss = 100.0 * stats.lost / expected if expected else 0.0
+    line = (f"{label}: {stats.datagrams / elapsed:6.1f} datagrams/s  "
+            f"{stats.bytes / elapsed / 1000:6.1f} kB/s  lost {stats.lost} ({loss:.2f}%)")
+    if stats.reordered or stats.invalid:
+        line += f"  reordered {stats.reordered}  invalid {stats.invalid}"
+    print(line)
+    for topic in sorted(stats.messages):
+        iv = sorted(stats.intervals.get(topic, []))
+        text = f"    {TOPICS[topic][0]:<9} {stats.messages[topic] / elapsed:6.1f} /s"
+        if iv:
+            text += (f"  interval mean {sum(iv) / len(iv) / 1000:6.2f} ms"
+                     f"  min {iv[0] / 1000:6.2f}  max {iv[-1] / 1000:6.2f}")
+        print(text)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="K2 telemetry receiver")
+    parser.add_argument('--port', type=int, default=DEFAULT_PORT,
+                        help="Vehicle telemetry port (CONFIG_K2_TELEMETRY_PORT)")
+    parser.add_argument('--host', help="Vehicle address, to subscribe (needs --sub)")
+    parser.add_argument('--sub', action='append', default=[], metavar='TOPIC:HZ',
+                        help="Topic and rate, repeatable (topics: all, %s)" % ', '.join(TOPIC_IDS))
+    parser.add_argument('--batch', type=int, default=0, help="Ticks per datagram (0 = device default)")
+    parser.add_argument('--print', action='store_true', help="Print every decoded message")
+    parser.add_argument('--interval', type=float, default=1.0, help="Seconds between summaries")
+    parser.add_argument('--duration', type=float, help="Stop after this many seconds")
+    args = parser.parse_args()
+
+    subs = parse_subs(args.sub)
+    if subs and not args.host:
+        parser.error("--sub needs --host")
+
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    if subs:
+        sock.bind(('0.0.0.0', 0))          # Subscriber: data comes back to this port
+        request = build_request(subs, args.batch)
+        print(f"Subscribing at {args.host}:{args.port}: " +
+              ', '.join(f"{TOPICS[t][0]}@{r}Hz" for t, r in sorted(subs.items())))
+    else:
+        sock.bind(('0.0.0.0', args.port))  # Pilot default stream
+        print(f"Listening for the pilot stream on port {args.port}")
+    sock.settimeout(0.1)
+
+    total = Stats()
+    window = Stats()
+    start = window_start = time.monotonic()
+    renew_at = start
+    try:
+        while args.duration is None or time.monotonic() - start < args.duration:
+            now = time.monotonic()
+            if subs and now >= renew_at:
+                sock.sendto(request, (args.host, args.port))
+                renew_at = now + RENEW_S
+
+            try:
+                data, _ = sock.recvfrom(2048)
+            except socket.timeout:
+                data = None
+
+            if data is not None:
+                decoded = decode_datagram(data)
+                ack = None if decoded else decode_ack(data)
+                if decoded is not None:
+                    batch_seq, _, messages = decoded
+                    total.add(len(data), batch_seq, messages)
+                    window.add(len(data), batch_seq, messages)
+                    if args.print:
+                        for message in messages:
+                            if message[1] is not None:
+                                print(format_message(*message))
+                elif ack is not None:
+                    if total.datagrams == 0:
+                        batch, rates = ack
+                        print(f"Subscribed, batch {batch}: " +
+                              ', '.join(f"{TOPICS[t][0]}@{r}Hz" for t, r in sorted(rates.items())))
+                else:
+                    total.invalid += 1
+                    window.invalid += 1
+
+            now = time.monotonic()
+            if now - window_start >= args.interval:
+                report("last", window, now - window_start)
+                window = Stats(carry=window)
+                window_start = now
+    except KeyboardInterrupt:
+        pass
+    finally:
+        if subs:
+            sock.sendto(build_request({}, 0), (args.host, args.port))
+
+    report("total", total, max(time.monotonic() - start, 1e-6))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,390 @@
+#!/usr/bin/env python3
+"""
+Command pipeline trace analysis for K2 CTF traces (src/trace.h)
+Reads a Zephyr CTF trace (tracing.conf on native_sim, tracing_uart.conf on
+hardware), follows every command packet through the rov_rx, rov_valid,
+rov_queued, rov_dequeued and rov_actuated trace points and prints
+per-packet latency tables and per-segment percentiles. With --perfetto it
+also writes a Chrome trace event JSON timeline (open in ui.perfetto.dev):
+one track per thread from the kernel's switch events, an ISR track, the
+trace points as instants and one async span per packet, with flow arrows
+from the UDP thread to the control thread to the commit ISR.
+
+The CTF stream is decoded with babeltrace2 (Python bindings if installed,
+otherwise the command line tool). The trace directory needs Zephyr's CTF
+metadata next to the stream; it is copied from ZEPHYR_BASE (or
+--zephyr-base) when missing. --text reads saved babeltrace2 output
+(babeltrace2 --clock-seconds --no-delta trace > trace.txt) instead.
+
+On hardware --port captures the tracing UART into the trace directory
+first; start it before resetting the board so the stream begins at an
+event boundary.
+
+Usage:
+    python3 trace_analyze.py trace
+    python3 trace_analyze.py trace --perfetto timeline.json --csv packets.csv
+    python3 trace_analyze.py --port /dev/ttyUSB0 --duration 10 trace
+    python3 trace_analyze.py --text trace.txt --rows 50
+"""
+
+import argparse
+import json
+import os
+import re
+import shutil
+import subprocess
+import sys
+import time
+
+STAGES = ('rx', 'valid', 'queued', 'dequeued', 'actuated')
+SEGMENTS = (
+    ('decode', 'rx', 'valid'),          # recvfrom return -> CRC checked
+    ('handoff', 'valid', 'queued'),     # decode and k_msgq_put
+    ('queue', 'queued', 'dequeued'),    # waiting for the control thread
+    ('control', 'dequeued', 'actuated'),  # control tick and commit phase
+    ('total', 'rx', 'actuated'),
+)
+STREAM_FILE = 'channel0_0'
+METADATA = os.path.join('subsys', 'tracing', 'ctf', 'tsdl', 'metadata')
+ISR_TID = 0
+
+TEXT_EVENT = re.compile(r'^\[\s*(\d+)(?:\.(\d+))?\]\s+(?:\([^)]*\)\s+)?([\w:]+):\s+\{\s*(.*?)\s*\}')
+TEXT_FIELD = re.compile(r'(\w+) = ("(?:[^"\\]|\\.)*"|[^,]+)')
+
+
+class Packet:
+    def __init__(self, index, sequence):
+        self.index = index       # Order of first appearance in the trace
+        self.sequence = sequence
+        self.times = {}          # Stage -> ns
+        self.arg = {}            # Stage -> arg1 (bytes, queue depth)
+        self.invalid = False
+        self.dropped = False
+        self.superseded = False  # Dequeued, but a newer command reached the output first
+        self.waited_for = set()  # Threads that ran while it sat on the queue
+
+    def segment(self, start, end):
+        if start in self.times and end in self.times:
+            return self.times[end] - self.times[start]
+        return None
+
+
+def field_value(field):
+    try:
+        return int(field)
+    except (TypeError, ValueError):
+        return str(field)
+
+
+def events_bt2(path):
+    import bt2
+
+    for msg in bt2.TraceCollectionMessageIterator(path):
+        if type(msg) is not bt2._EventMessageConst:
+            continue
+        payload = msg.event.payload_field
+        fields = {k: field_value(v) for k, v in payload.items()} if payload is not None else {}
+        yield msg.default_clock_snapshot.ns_from_origin, msg.event.name, fields
+
+
+def parse_text(lines):
+    for line in lines:
+        m = TEXT_EVENT.match(line)
+        if not m:
+            continue
+        seconds, fraction, name, body = m.groups()
+        fraction = (fraction or '0')[:9].ljust(9, '0')
+        fields = {}
+        for key, value in TEXT_FIELD.findall(body):
+            value = value.strip()
+            if value.startswith('"'):
+                fields[key] = value[1:-1]
+            else:
+                try:
+                    fields[key] = int(value, 0)
+                except ValueError:
+                    fields[key] = value
+        yield int(seconds) * 1000000000 + int(fraction), name, fields
+
+
+def events_cli(path):
+    if shutil.which('babeltrace2') is None:
+        raise SystemExit("Decoding CTF needs babeltrace2 (Python bindings or command line tool)")
+    proc = subprocess.Popen(['babeltrace2', '--clock-seconds', '--no-delta', path],
+                            stdout=subprocess.PIPE, text=True, errors='replace')
+    yield from parse_text(proc.stdout)
+    if proc.wait() != 0:
+        raise SystemExit(f"babeltrace2 failed on {path}")
+
+
+def prepare_trace_dir(path, zephyr_base):
+    """The stream needs Zephyr's metadata file next to it"""
+    metadata = os.path.join(path, 'metadata')
+    if os.path.exists(metadata):
+        return
+    if not zephyr_base:
+        raise SystemExit(f"{metadata} is missing; set ZEPHYR_BASE (or --zephyr-base) to copy it")
+    shutil.copy(os.path.join(zephyr_base, METADATA), metadata)
+
+
+def capture(args):
+    try:
+        import serial
+    except ImportError:
+        raise SystemExit("Capturing from a serial port needs pyserial (pip install pyserial)")
+    os.makedirs(args.trace, exist_ok=True)
+    total = 0
+    start = time.monotonic()
+    with serial.Serial(args.port, args.baud, timeout=0.1) as port, \
+            open(os.path.join(args.trace, STREAM_FILE), 'wb') as out:
+        print(f"Capturing {args.port} for {args.duration:.0f} s (reset the board now)",
+              file=sys.stderr)
+        try:
+            while time.monotonic() - start < args.duration:
+                chunk = port.read(65536)
+                out.write(chunk)
+                total += len(chunk)
+        except KeyboardInterrupt:
+            pass
+    elapsed = time.monotonic() - start
+    print(f"{total} bytes in {elapsed:.1f} s ({total / elapsed / 1000:.1f} kB/s)", file=sys.stderr)
+
+
+class Timeline:
+    """Chrome trace event JSON, as loaded by Perfetto"""
+
+    def __init__(self):
+        self.events = []
+        self.threads = {ISR_TID: 'ISR'}
+        self.running = {}        # tid -> switch-in ns
+
+    @staticmethod
+    def us(ns):
+        return ns / 1000.0
+
+    def switch_in(self, ns, tid, name):
+        self.threads[tid] = name
+        self.running[tid] = ns
+
+    def switch_out(self, ns, tid):
+        start = self.running.pop(tid, None)
+        if start is not None:
+            self.events.append({'ph': 'X', 'pid': 1, 'tid': tid, 'name': self.threads[tid],
+                                'cat': 'sched', 'ts': self.us(start), 'dur': self.us(ns - start)})
+
+    def isr(self, ns, enter):
+        self.events.append({'ph': 'B' if enter else 'E', 'pid': 1, 'tid': ISR_TID,
+                            'name': 'isr', 'cat': 'isr', 'ts': self.us(ns)})
+
+    def instant(self, ns, tid, name, sequence, arg):
+        self.events.append({'ph': 'i', 's': 't', 'pid': 1, 'tid': tid, 'name': name,
+                            'cat': 'rov', 'ts': self.us(ns),
+                            'args': {'sequence': sequence, 'arg1': arg}})
+
+    def packet(self, packet, tids):
+        times = packet.times
+        stamps = [s for s in STAGES if s in times]
+        if len(stamps) < 2:
+            return
+        span = {'pid': 1, 'cat': 'packet', 'id': packet.index}
+        name = f"#{packet.sequence}"
+        self.events.append(dict(span, ph='b', name=name, ts=self.us(times[stamps[0]])))
+        for first, second in zip(stamps, stamps[1:]):
+            self.events.append(dict(span, ph='b', name=f"{first}->{second}", ts=self.us(times[first])))
+            self.events.append(dict(span, ph='e', name=f"{first}->{second}", ts=self.us(times[second])))
+        self.events.append(dict(span, ph='e', name=name, ts=self.us(times[stamps[-1]])))
+
+        # Flow arrows between the threads that handled the packet
+        hops = [s for s in ('rx', 'dequeued', 'actuated') if s in times]
+        if len(hops) < 2:
+            return
+        for i, stage in enumerate(hops):
+            phase = 's' if i == 0 else ('f' if i == len(hops) - 1 else 't')
+            event = {'ph': phase, 'pid': 1, 'tid': tids[stage], 'cat': 'flow', 'id': packet.index,
+                     'name': 'command', 'ts': self.us(times[stage])}
+            if phase == 'f':
+                event['bp'] = 'e'
+            self.events.append(event)
+
+    def write(self, path, end_ns):
+        for tid in list(self.running):
+            self.switch_out(end_ns, tid)
+        meta = [{'ph': 'M', 'pid': 1, 'name': 'process_name', 'args': {'name': 'K2'}}]
+        meta += [{'ph': 'M', 'pid': 1, 'tid': tid, 'name': 'thread_name', 'args': {'name': name}}
+                 for tid, name in self.threads.items()]
+        with open(path, 'w') as f:
+            json.dump({'traceEvents': meta + self.events, 'displayTimeUnit': 'ns'}, f)
+
+
+def analyze(events, timeline):
+    packets = []
+    open_packets = {}            # Sequence -> newest packet with that sequence
+    stage_tids = {}              # (packet index, stage) -> tid, for flow arrows
+    queued = []                  # Packets between rov_queued and rov_dequeued
+    current = None               # tid running outside ISRs
+    isr_depth = 0
+    counts = {}
+    first_ns = last_ns = None
+
+    for ns, name, fields in events:
+        first_ns = ns if first_ns is None else first_ns
+        last_ns = ns
+        counts[name] = counts.get(name, 0) + 1
+
+        if name == 'thread_switched_in':
+            current = fields.get('thread_id')
+            thread = fields.get('name') or f"0x{current:x}"
+            if timeline:
+                timeline.switch_in(ns, current, thread)
+            for packet in queued:
+                packet.waited_for.add(thread)
+        elif name == 'thread_switched_out':
+            if timeline:
+                timeline.switch_out(ns, fields.get('thread_id'))
+        elif name in ('isr_enter', 'isr_exit'):
+            isr_depth = isr_depth + 1 if name == 'isr_enter' else max(isr_depth - 1, 0)
+            if timeline:
+                timeline.isr(ns, name == 'isr_enter')
+        elif name == 'named_event':
+            trace_point = fields.get('name', '')
+            if not trace_point.startswith('rov_'):
+                continue
+            stage = trace_point[4:]
+            sequence = fields.get('arg0', 0)
+            arg = fields.get('arg1', 0)
+            tid = ISR_TID if isr_depth > 0 else current
+            if timeline:
+                timeline.instant(ns, tid, trace_point, sequence, arg)
+
+            packet = open_packets.get(sequence)
+            if stage == 'rx' or packet is None:
+                packet = Packet(len(packets), sequence)
+                open_packets[sequence] = packet
+                packets.append(packet)
+            index = packet.index
+
+            if stage == 'invalid':
+                packet.invalid = True
+            elif stage == 'dropped':
+                packet.dropped = True
+            elif stage in STAGES and stage not in packet.times:
+                packet.times[stage] = ns
+                packet.arg[stage] = arg
+                stage_tids[(index, stage)] = tid
+                if stage == 'queued':
+                    queued.append(packet)
+                elif stage == 'dequeued' and packet in queued:
+                    queued.remove(packet)
+                elif stage == 'actuated':
+                    # Commands dequeued before it in the same tick never reach the output
+                    for older in packets[max(0, index - 64):index]:
+                        if 'dequeued' in older.times and 'actuated' not in older.times:
+                            older.superseded = True
+
+    if timeline and packets:
+        for packet in packets:
+            tids = {stage: stage_tids.get((packet.index, stage), ISR_TID) for stage in STAGES}
+            timeline.packet(packet, tids)
+    return packets, counts, first_ns, last_ns
+
+
+def percentile(sorted_values, fraction):
+    rank = max(0, min(len(sorted_values) - 1, int(round(fraction * len(sorted_values) + 0.5)) - 1))
+    return sorted_values[rank]
+
+
+def report(packets, counts, first_ns, last_ns, rows):
+    duration = (last_ns - first_ns) / 1e9 if first_ns is not None and last_ns > first_ns else 0.0
+    print(f"{sum(counts.values())} events over {duration:.3f} s: "
+          + ', '.join(f"{n} {c}" for n, c in sorted(counts.items(), key=lambda kv: -kv[1])[:8]))
+    if not packets:
+        print("No rov_* trace points (was the firmware built with tracing.conf?)")
+        return
+
+    complete = [p for p in packets if 'actuated' in p.times and 'rx' in p.times]
+    print(f"packets {len(packets)}  actuated {len(complete)}  "
+          f"superseded {sum(p.superseded for p in packets)}  "
+          f"invalid {sum(p.invalid for p in packets)}  dropped {sum(p.dropped for p in packets)}  "
+          f"incomplete {sum(1 for p in packets if not p.superseded and not p.invalid and not p.dropped and 'actuated' not in p.times)}")
+
+    print()
+    print("segment      count       p50       p90       p99       max      mean  (us)")
+    for name, start, end in SEGMENTS:
+        values = sorted(v for v in (p.segment(start, end) for p in packets) if v is not None)
+        if not values:
+            print(f"{name:<8} {0:9d}")
+            continue
+        cells = [percentile(values, f) / 1000 for f in (0.5, 0.9, 0.99)]
+        cells += [values[-1] / 1000, sum(values) / len(values) / 1000]
+        print(f"{name:<8} {len(values):9d} " + ' '.join(f"{c:9.1f}" for c in cells))
+
+    if rows > 0 and complete:
+        slowest = sorted(complete, key=lambda p: p.segment('rx', 'actuated'), reverse=True)[:rows]
+        print()
+        print(f"slowest {len(slowest)} packets (us)")
+        print("   sequence    decode   handoff     queue   control     total  depth  ran while queued")
+        for p in slowest:
+            cells = [p.segment(s, e) for _, s, e in SEGMENTS]
+            text = ' '.join(f"{c / 1000:9.1f}" if c is not None else f"{'-':>9}" for c in cells)
+            waited = ', '.join(sorted(p.waited_for - {'rov_control'})) or '-'
+            print(f"{p.sequence:11d} {text} {p.arg.get('queued', 0):6d}  {waited}")
+
+
+def write_csv(path, packets):
+    with open(path, 'w') as f:
+        f.write('sequence,' + ','.join(f"{s}_ns" for s in STAGES) + ','
+                + ','.join(f"{name}_ns" for name, _, _ in SEGMENTS)
+                + ',queue_depth,invalid,dropped,superseded\n')
+        for p in packets:
+            stamps = [str(p.times[s]) if s in p.times else '' for s in STAGES]
+            segments = [p.segment(s, e) for _, s, e in SEGMENTS]
+            f.write(f"{p.sequence}," + ','.join(stamps) + ','
+                    + ','.join('' if v is None else str(v) for v in segments)
+                    + f",{p.arg.get('queued', '')},{int(p.invalid)},{int(p.dropped)},"
+                    f"{int(p.superseded)}\n")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="K2 command pipeline trace analysis")
+    parser.add_argument('trace', nargs='?', help="CTF trace directory (stream file channel0_0)")
+    parser.add_argument('--text', help="Saved babeltrace2 text output instead of a trace directory")
+    parser.add_argument('--port', help="Capture the tracing UART into the trace directory first")
+    parser.add_argument('--baud', type=int, default=2000000)
+    parser.add_argument('--duration', type=float, default=10.0, help="Capture length in seconds")
+    parser.add_argument('--zephyr-base', default=os.environ.get('ZEPHYR_BASE'),
+                        help="Zephyr tree with the CTF metadata (default $ZEPHYR_BASE)")
+    parser.add_argument('--perfetto', help="Write a Chrome trace event JSON timeline to this file")
+    parser.add_argument('--csv', help="Write every packet's timestamps and segments to this file")
+    parser.add_argument('--rows', type=int, default=20, help="Slowest packets to list (0: none)")
+    args = parser.parse_args()
+
+    if not args.trace and not args.text:
+        parser.error("give a trace directory or --text")
+    if args.port:
+        if not args.trace:
+            parser.error("--port needs a trace directory to capture into")
+        capture(args)
+
+    if args.text:
+        stream = open(args.text, errors='replace')
+        events = parse_text(stream)
+    else:
+        prepare_trace_dir(args.trace, args.zephyr_base)
+        try:
+            import bt2  # noqa: F401
+            events = events_bt2(args.trace)
+        except ImportError:
+            events = events_cli(args.trace)
+
+    timeline = Timeline() if args.perfetto else None
+    packets, counts, first_ns, last_ns = analyze(events, timeline)
+    report(packets, counts, first_ns, last_ns, args.rows)
+    if args.csv:
+        write_csv(args.csv, packets)
+    if timeline and last_ns is not None:
+        timeline.write(args.perfetto, last_ns)
+        print(f"\nTimeline: {args.perfetto} ({len(timeline.events)} events, open in ui.perfetto.dev)")
+
+
+if __name__ == '__main__':
+    main()